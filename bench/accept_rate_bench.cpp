@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <iostream>
+
+#include "bench_utils.hpp"
+
+using namespace echo;
+using namespace echo::bench;
+
+namespace {
+const char message[] = "ping\n";
+const size_t messageLen = sizeof(message) - 1;
+
+/* Opens "connections" connections to a running dispatcher in bursts of "burst" (over the Unix domain listener if
+ * "overUnix", the Internet one otherwise). Every connection of a burst is connected before any of them sends its
+ * message, so the dispatcher sees them arrive together, and the burst ends once all of them got their response. Also
+ * reports the dispatcher's CPU time per connection and the descriptors it still holds afterwards */
+void runBenchmark(const DispatcherProcess &dispatcher, const char *handoff, bool overUnix, size_t burst,
+                  size_t connections) {
+    std::vector<double> burstLatencies;
+    std::vector<int> clients;
+    char response[messageLen];
+
+    double cpuBefore = dispatcher.getCpuSeconds();
+    auto start = Clock::now();
+    for (size_t opened = 0; opened < connections; opened += burst) {
+        auto burstStart = Clock::now();
+        for (size_t i = 0; i < burst; i++) {
+            int fd = overUnix ? connectUnix(startUnixPath) : connectInet(startPort);
+            setReceiveTimeout(fd, 10);
+            clients.emplace_back(fd);
+        }
+        for (int fd : clients) {
+            writeAll(fd, message, messageLen);
+        }
+        for (int fd : clients) {
+            readExactly(fd, response, sizeof(response));
+        }
+        burstLatencies.emplace_back(secondsSince(burstStart) * 1e3);
+
+        for (int fd : clients) {
+            close(fd);
+        }
+        clients.clear();
+    }
+    double elapsed = secondsSince(start);
+    double opened = burstLatencies.size() * burst;
+
+    std::printf("%-10s %-6s %8zu %14.0f %14.3f %14.3f %18.2f %15zu\n", handoff, overUnix ? "UNIX" : "INET", burst,
+                opened / elapsed, percentile(burstLatencies, 50), percentile(burstLatencies, 99),
+                (dispatcher.getCpuSeconds() - cpuBefore) / opened * 1e6, dispatcher.getOpenFdCount());
+}
+} // namespace
+
+/* Measures how fast the dispatcher hands accepted connections over to its servers: connections per second until the
+ * first response, and the latency of whole bursts of connections, for every way of handing sockets over */
+int main() {
+    raiseFdLimit();
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::setvbuf(stdout, nullptr, _IOLBF, 0);
+    try {
+        std::printf("%-10s %-6s %8s %14s %14s %14s %18s %15s\n", "handoff", "via", "burst", "conns/s", "burst p50 ms",
+                    "burst p99 ms", "dispatcher us/conn", "dispatcher fds");
+        for (const char *handoff : {"SCM_RIGHTS", "PIDFD"}) {
+            DispatcherProcess dispatcher({"--event-loop", "EPOLL", "--handoff", handoff});
+            for (bool overUnix : {true, false}) {
+                for (size_t burst : {1, 64}) {
+                    runBenchmark(dispatcher, handoff, overUnix, burst, 2048);
+                }
+            }
+        }
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+    }
+
+    return 0;
+}
\ No newline at end of file
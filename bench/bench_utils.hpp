@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+#include "listener/dispatcher.hpp"
+#include "listener/server.hpp"
+
+namespace echo::bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/* Returns the "p"-th percentile (0-100) of "samples", sorting them in place */
+inline double percentile(std::vector<double> &samples, double p) {
+    if (samples.empty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t idx = std::min(samples.size() - 1, static_cast<size_t>(p / 100.0 * samples.size()));
+    return samples[idx];
+}
+
+/* Raises the soft open file limit to the hard limit, so that thousands of connections can be opened */
+inline void raiseFdLimit() {
+    struct rlimit limit {};
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+}
+
+/* Forks a Server process the same way the dispatcher does and hands client sockets over to it through its pipe */
+class ServerProcess {
+  public:
+    /* Runs a server with "config" in a child process, responding with "schema" if there is one instead of echoing */
+    ServerProcess(const ServerConfig &config, const std::string &pipeName = "/tmp/echo_bench_fifo",
+                  AbstractResponseSchema schema = nullptr)
+        : pipeName(pipeName) {
+        unlink(pipeName.c_str());
+        mkfifo(pipeName.c_str(), O_RDWR);
+        chmod(pipeName.c_str(), S_IRUSR | S_IWUSR);
+        prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY);
+
+        pid = fork();
+        if (pid == -1) {
+            throw std::system_error(errno, std::generic_category(), "Benchmark server fork error");
+        } else if (pid == 0) {
+            // Connection logs of thousands of clients would dominate the measurements
+            int devNull = open("/dev/null", O_WRONLY);
+            dup2(devNull, STDOUT_FILENO);
+            {
+                Server server(pipeName, config);
+                if (schema != nullptr) {
+                    server.setResponseSchema(std::move(schema));
+                }
+                server.start();
+            }
+            std::_Exit(0);
+        }
+
+        pipeFd = open(pipeName.c_str(), O_WRONLY);
+        if (pipeFd == -1) {
+            throw std::system_error(errno, std::generic_category(), "Benchmark pipe opening error");
+        }
+    }
+
+    ~ServerProcess() {
+        close(pipeFd);
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+        unlink(pipeName.c_str());
+    }
+
+    /* Hands "fd" speaking "framing" over to the server using the dispatcher->server pipe protocol */
+    void handOff(int fd, FramingType framing = FramingType::LINE) {
+        std::byte buf[sizeof(std::byte) + sizeof(int) + sizeof(FramingType)];
+        buf[0] = newClientFdPipeFlag;
+        std::memcpy(&buf[1], &fd, sizeof(int));
+        buf[1 + sizeof(int)] = static_cast<std::byte>(framing);
+        if (write(pipeFd, buf, sizeof(buf)) == -1) {
+            throw std::system_error(errno, std::generic_category(), "Benchmark handoff error");
+        }
+    }
+
+    inline int getPid() const { return pid; }
+
+    /* Resident set size of the server process in KiB, or 0 if it can't be read */
+    size_t getResidentKiB() const {
+        std::string statusPath = "/proc/" + std::to_string(pid) + "/status";
+        FILE *status = std::fopen(statusPath.c_str(), "r");
+        if (status == nullptr) {
+            return 0;
+        }
+
+        char line[256];
+        size_t residentKiB = 0;
+        while (std::fgets(line, sizeof(line), status) != nullptr) {
+            if (std::sscanf(line, "VmRSS: %zu kB", &residentKiB) == 1) {
+                break;
+            }
+        }
+        std::fclose(status);
+        return residentKiB;
+    }
+
+  private:
+    std::string pipeName;
+    int pid;
+    int pipeFd;
+};
+
+/* Connects to the Unix domain socket at "path" or throws an error if necessary */
+inline int connectUnix(const std::string &path) {
+    struct sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1 || connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1) {
+        int connectErrno = errno;
+        close(fd);
+        throw std::system_error(connectErrno, std::generic_category(), "Benchmark Unix connect error");
+    }
+    return fd;
+}
+
+/* Connects to "port" on the loopback interface with the Nagle algorithm disabled, or throws an error if necessary */
+inline int connectInet(int port) {
+    struct sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1 || connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1) {
+        int connectErrno = errno;
+        close(fd);
+        throw std::system_error(connectErrno, std::generic_category(), "Benchmark TCP connect error");
+    }
+    int flag = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    return fd;
+}
+
+/* Runs a whole dispatcher with its servers in a child process, started with the startup "options" (e.g "--event-loop",
+ * "EPOLL"), and waits until it accepts connections */
+class DispatcherProcess {
+  public:
+    DispatcherProcess(const std::vector<std::string> &options, int serverCount = 3) : serverCount(serverCount) {
+        // The CLI thread of the dispatcher reads stdin, which is kept open but silent
+        int stdinPipe[2];
+        if (pipe(stdinPipe) == -1) {
+            throw std::system_error(errno, std::generic_category(), "Benchmark dispatcher stdin error");
+        }
+
+        pid = fork();
+        if (pid == -1) {
+            throw std::system_error(errno, std::generic_category(), "Benchmark dispatcher fork error");
+        } else if (pid == 0) {
+            dup2(stdinPipe[0], STDIN_FILENO);
+            close(stdinPipe[0]);
+            close(stdinPipe[1]);
+            int devNull = open("/dev/null", O_WRONLY);
+            dup2(devNull, STDOUT_FILENO);
+            {
+                Dispatcher dispatcher(serverCount);
+                std::vector<std::string> args{"./dispatcher"};
+                args.insert(args.end(), options.begin(), options.end());
+                for (auto &tokens : StartupTokens::splitByOption(args)) {
+                    dispatcher.executeCommand(std::move(tokens));
+                }
+                dispatcher.start();
+            }
+            std::_Exit(0);
+        }
+
+        close(stdinPipe[0]);
+        stdinFd = stdinPipe[1];
+
+        for (int attempt = 0;; attempt++) {
+            try {
+                close(connectUnix(startUnixPath));
+                break;
+            } catch (const std::system_error &e) {
+                if (attempt == 500) {
+                    throw;
+                }
+                usleep(10000);
+            }
+        }
+    }
+
+    ~DispatcherProcess() {
+        kill(pid, SIGTERM);
+        close(stdinFd);
+        waitpid(pid, nullptr, 0);
+
+        // The servers are not our children, so their exit is awaited through their listeners going away, letting the
+        // next dispatcher bind the same ports. With SO_REUSEPORT, the servers listen on the dispatcher's port too
+        for (int id = 0; id <= serverCount; id++) {
+            for (int attempt = 0; attempt < 500; attempt++) {
+                try {
+                    close(connectInet(startPort + id));
+                } catch (const std::system_error &e) {
+                    break;
+                }
+                usleep(10000);
+            }
+        }
+    }
+
+    DispatcherProcess(const DispatcherProcess &) = delete;
+    DispatcherProcess &operator=(const DispatcherProcess &) = delete;
+
+    /* CPU time spent so far by the thread accepting and forwarding connections (the dispatcher's main thread) */
+    double getCpuSeconds() const {
+        std::string schedstatPath = "/proc/" + std::to_string(pid) + "/schedstat";
+        FILE *schedstat = std::fopen(schedstatPath.c_str(), "r");
+        unsigned long long runNanoseconds = 0;
+        if (schedstat != nullptr) {
+            std::fscanf(schedstat, "%llu", &runNanoseconds);
+            std::fclose(schedstat);
+        }
+        return runNanoseconds / 1e9;
+    }
+
+    /* Number of file descriptors the dispatcher holds open */
+    size_t getOpenFdCount() const {
+        std::string fdPath = "/proc/" + std::to_string(pid) + "/fd";
+        auto entries = std::filesystem::directory_iterator(fdPath);
+        return std::distance(std::filesystem::begin(entries), std::filesystem::end(entries));
+    }
+
+    /* Proportional set size in KiB of the dispatcher and of its server processes if it forked any, so pages the servers
+     * share with the dispatcher are only counted once */
+    size_t getProportionalSetKiB() const {
+        std::vector<int> pids{pid};
+        std::string childrenPath = "/proc/" + std::to_string(pid) + "/task/" + std::to_string(pid) + "/children";
+        FILE *children = std::fopen(childrenPath.c_str(), "r");
+        if (children != nullptr) {
+            int childPid;
+            while (std::fscanf(children, "%d", &childPid) == 1) {
+                pids.emplace_back(childPid);
+            }
+            std::fclose(children);
+        }
+
+        size_t totalKiB = 0;
+        for (int processPid : pids) {
+            std::string rollupPath = "/proc/" + std::to_string(processPid) + "/smaps_rollup";
+            FILE *rollup = std::fopen(rollupPath.c_str(), "r");
+            if (rollup == nullptr) {
+                continue;
+            }
+            char line[256];
+            size_t pssKiB = 0;
+            while (std::fgets(line, sizeof(line), rollup) != nullptr) {
+                if (std::sscanf(line, "Pss: %zu kB", &pssKiB) == 1) {
+                    break;
+                }
+            }
+            std::fclose(rollup);
+            totalKiB += pssKiB;
+        }
+        return totalKiB;
+    }
+
+  private:
+    int pid;
+    int stdinFd;
+    int serverCount;
+};
+
+/* Fills "pair" with the two ends of a connected TCP loopback connection (the client end first). Both ends disable the
+ * Nagle algorithm, like the sockets accepted by the dispatcher */
+inline void tcpSocketPair(int pair[2]) {
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addressLen = sizeof(address);
+
+    if (listenFd == -1 || bind(listenFd, reinterpret_cast<sockaddr *>(&address), addressLen) == -1 ||
+        listen(listenFd, 1) == -1 || getsockname(listenFd, reinterpret_cast<sockaddr *>(&address), &addressLen) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Benchmark TCP listener error");
+    }
+
+    pair[0] = socket(AF_INET, SOCK_STREAM, 0);
+    if (pair[0] == -1 || connect(pair[0], reinterpret_cast<sockaddr *>(&address), addressLen) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Benchmark TCP connect error");
+    }
+    pair[1] = accept(listenFd, nullptr, nullptr);
+    close(listenFd);
+    if (pair[1] == -1) {
+        throw std::system_error(errno, std::generic_category(), "Benchmark TCP accept error");
+    }
+
+    int flag = 1;
+    setsockopt(pair[0], IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    setsockopt(pair[1], IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+/* Makes blocking reads on "fd" fail after "seconds" instead of hanging if the server stops responding */
+inline void setReceiveTimeout(int fd, int seconds) {
+    struct timeval timeout {};
+    timeout.tv_sec = seconds;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+/* Writes all "len" bytes of "data" to the blocking "fd" */
+inline void writeAll(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written == -1) {
+            throw std::system_error(errno, std::generic_category(), "Benchmark write error");
+        }
+        data += written;
+        len -= written;
+    }
+}
+
+/* Reads exactly "len" bytes from the blocking "fd" into "dest" */
+inline void readExactly(int fd, char *dest, size_t len) {
+    while (len > 0) {
+        ssize_t bytesRead = read(fd, dest, len);
+        if (bytesRead <= 0) {
+            throw std::system_error(errno, std::generic_category(), "Benchmark read error");
+        }
+        dest += bytesRead;
+        len -= bytesRead;
+    }
+}
+} // namespace echo::bench
@@ -0,0 +1,191 @@
+#include <cstdio>
+#include <iostream>
+#include <sys/epoll.h>
+
+#include "bench_utils.hpp"
+
+using namespace echo;
+using namespace echo::bench;
+
+namespace {
+const char message[] = "ping\n";
+const size_t messageLen = sizeof(message) - 1;
+
+/* Time given to the last connections of a storm to get their response */
+const double drainSeconds = 5;
+
+/* Most connections opened before the responses are read again */
+const size_t maxOpenBatch = 256;
+
+/* Connection of the storm waiting to be connected or to get its response */
+struct PendingConnection {
+    Clock::time_point scheduled;
+    bool open = false;
+    bool sent = false;
+};
+
+/* Starts connecting a non-blocking socket to the dispatcher. Returns the socket, or -1 if the connection was refused
+ * (e.g a full accept queue) */
+int startConnect(bool overUnix) {
+    int fd = socket(overUnix ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    int result;
+    if (overUnix) {
+        struct sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, startUnixPath.c_str(), sizeof(address.sun_path) - 1);
+        result = connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    } else {
+        // Reset on close, so tens of thousands of connections don't use up the ports in TIME_WAIT
+        struct linger reset {1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+        int flag = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+        struct sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(startPort);
+        result = connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    }
+
+    if (result == -1 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Opens connections to a running dispatcher at "rate" per second for one second (over the Unix domain listener if
+ * "overUnix", the Internet one otherwise), no matter how fast earlier ones are served. Every connection sends one
+ * message and is closed once it got the response. Latencies run from the moment a connection was scheduled to its
+ * response, so a dispatcher falling behind shows up in them rather than slowing the storm down */
+void runBenchmark(const DispatcherProcess &dispatcher, const char *mode, bool overUnix, size_t rate) {
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<PendingConnection> pending;
+    std::vector<double> latencies;
+    size_t scheduled = 0;
+    size_t refused = 0;
+    size_t inFlight = 0;
+    char response[messageLen];
+    struct epoll_event events[256];
+
+    Clock::time_point lastResponse;
+    auto finish = [&](int fd, bool answered) {
+        if (answered) {
+            lastResponse = Clock::now();
+            latencies.emplace_back(std::chrono::duration<double, std::milli>(lastResponse - pending[fd].scheduled)
+                                       .count());
+        } else {
+            refused++;
+        }
+        close(fd);
+        pending[fd].open = false;
+        inFlight--;
+    };
+
+    double cpuBefore = dispatcher.getCpuSeconds();
+    auto start = Clock::now();
+    auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+    while (inFlight > 0 || scheduled < rate) {
+        double elapsed = secondsSince(start);
+        if (elapsed > 1 + drainSeconds) {
+            break;
+        }
+
+        // Connections that are due are opened, catching up if the previous iteration took long, but in limited
+        // batches so responses keep being read while the storm falls behind
+        auto now = Clock::now();
+        for (size_t opened = 0; opened < maxOpenBatch && scheduled < rate && start + scheduled * interval <= now;
+             opened++, scheduled++) {
+            int fd = startConnect(overUnix);
+            if (fd == -1) {
+                refused++;
+                continue;
+            }
+            if (static_cast<size_t>(fd) >= pending.size()) {
+                pending.resize(fd + 1);
+            }
+            pending[fd] = PendingConnection{start + scheduled * interval, true};
+            inFlight++;
+
+            struct epoll_event event {};
+            event.events = EPOLLOUT;
+            event.data.fd = fd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        }
+
+        int readyCount = epoll_wait(epollFd, events, 256, scheduled < rate ? 0 : 10);
+        for (int i = 0; i < readyCount; i++) {
+            int fd = events[i].data.fd;
+            if (!pending[fd].sent) {
+                int error = 0;
+                socklen_t errorLen = sizeof(error);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &errorLen);
+                if (error != 0 || send(fd, message, messageLen, MSG_NOSIGNAL) != static_cast<ssize_t>(messageLen)) {
+                    finish(fd, false);
+                    continue;
+                }
+                pending[fd].sent = true;
+
+                struct epoll_event event {};
+                event.events = EPOLLIN;
+                event.data.fd = fd;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+            } else {
+                ssize_t bytesRead = recv(fd, response, sizeof(response), 0);
+                if (bytesRead == -1 && errno == EAGAIN) {
+                    continue;
+                }
+                finish(fd, bytesRead > 0);
+            }
+        }
+    }
+    close(epollFd);
+
+    // Connections still waiting after the drain period count as failed
+    for (size_t fd = 0; fd < pending.size(); fd++) {
+        if (pending[fd].open) {
+            close(fd);
+            refused++;
+        }
+    }
+
+    double servedSeconds = std::chrono::duration<double>(lastResponse - start).count();
+    std::printf("%-10s %-6s %10zu %12.0f %10.3f %10.3f %10.3f %8zu %18.2f\n", mode, overUnix ? "UNIX" : "INET", rate,
+                latencies.size() / std::max(servedSeconds, 1.0), percentile(latencies, 50), percentile(latencies, 99),
+                percentile(latencies, 99.9), refused,
+                (dispatcher.getCpuSeconds() - cpuBefore) / std::max<size_t>(latencies.size(), 1) * 1e6);
+}
+} // namespace
+
+/* Storms the dispatcher's listeners with new connections at fixed rates and measures how long they wait to be
+ * accepted and handed over, as the time until their first response. Internet clients are stormed once more with the
+ * servers accepting them on SO_REUSEPORT sockets instead */
+int main() {
+    raiseFdLimit();
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::setvbuf(stdout, nullptr, _IOLBF, 0);
+    try {
+        std::printf("%-10s %-6s %10s %12s %10s %10s %10s %8s %18s\n", "accept", "via", "target/s", "served/s", "p50 ms",
+                    "p99 ms", "p99.9 ms", "failed", "dispatcher us/conn");
+        {
+            DispatcherProcess dispatcher({"--event-loop", "EPOLL"});
+            for (bool overUnix : {true, false}) {
+                for (size_t rate : {5000, 20000}) {
+                    runBenchmark(dispatcher, "dispatcher", overUnix, rate);
+                }
+            }
+        }
+
+        // The servers accept Internet clients themselves, so only those take a different path
+        DispatcherProcess dispatcher({"--event-loop", "EPOLL", "--reuseport", "HASH"});
+        for (size_t rate : {5000, 20000}) {
+            runBenchmark(dispatcher, "reuseport", false, rate);
+        }
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+
+#include "bench_utils.hpp"
+
+using namespace echo;
+using namespace echo::bench;
+
+namespace {
+/* Allocation counter of the process. Before the server is forked it points into memory shared with the child, after
+ * that the bench process switches to a private counter so only the server's allocations are counted */
+std::atomic<uint64_t> privateAllocationCount = 0;
+std::atomic<uint64_t> *allocationCount = &privateAllocationCount;
+
+const int pipelineDepth = 16;
+} // namespace
+
+void *operator new(size_t size) {
+    allocationCount->fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+namespace {
+/* Echoes "rounds" rounds of "pipelineDepth" pipelined messages of "payloadSize" bytes through a server running
+ * "eventLoopType" over a TCP loopback connection, reporting the server's heap allocations per message and its resident
+ * memory after the warm up and at the end, which should match once buffers are reused. With "makeSchema" the server
+ * responds with the schema it makes instead of echoing */
+void runBenchmark(const char *name, EventLoopType eventLoopType, size_t payloadSize, int rounds,
+                  AbstractResponseSchema (*makeSchema)() = nullptr) {
+    auto *sharedCount = static_cast<std::atomic<uint64_t> *>(
+        mmap(nullptr, sizeof(std::atomic<uint64_t>), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (sharedCount == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "Benchmark counter mapping error");
+    }
+    new (sharedCount) std::atomic<uint64_t>(0);
+
+    allocationCount = sharedCount;
+    {
+        ServerProcess server({eventLoopType, 1}, "/tmp/echo_bench_fifo", makeSchema ? makeSchema() : nullptr);
+        allocationCount = &privateAllocationCount;
+
+        int pair[2];
+        tcpSocketPair(pair);
+        fcntl(pair[1], F_SETFL, O_NONBLOCK);
+        setReceiveTimeout(pair[0], 10);
+        server.handOff(pair[1]);
+
+        std::string request;
+        size_t responseSize = 0;
+        for (int i = 0; i < pipelineDepth; i++) {
+            std::string message(payloadSize, 'a' + i % 26);
+            request += message + '\n';
+            if (makeSchema != nullptr) {
+                makeSchema()->generateResponse(message);
+            }
+            responseSize += message.size() + 1;
+        }
+        std::vector<char> response(responseSize);
+
+        auto echoRound = [&]() {
+            writeAll(pair[0], request.data(), request.size());
+            readExactly(pair[0], response.data(), response.size());
+        };
+
+        // Warm up, so that buffers grown once per connection are not counted
+        for (int i = 0; i < 10; i++) {
+            echoRound();
+        }
+        close(pair[1]);
+        size_t residentBefore = server.getResidentKiB();
+
+        uint64_t allocationsBefore = sharedCount->load();
+        auto start = Clock::now();
+        for (int round = 0; round < rounds; round++) {
+            echoRound();
+        }
+        double elapsed = secondsSince(start);
+        uint64_t allocations = sharedCount->load() - allocationsBefore;
+
+        double messages = static_cast<double>(rounds) * pipelineDepth;
+        std::printf("%-10s %10zu %14.0f %12.1f %14.3f %10zu %10zu\n", name, payloadSize, messages / elapsed,
+                    messages * (payloadSize + 1) / elapsed / (1 << 20), allocations / messages, residentBefore,
+                    server.getResidentKiB());
+        close(pair[0]);
+    }
+    munmap(sharedCount, sizeof(std::atomic<uint64_t>));
+}
+} // namespace
+
+int main() {
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::setvbuf(stdout, nullptr, _IOLBF, 0);
+    std::printf("%-10s %10s %14s %12s %14s %10s %10s\n", "mode", "payload", "msgs/s", "MiB/s", "allocs/msg",
+                "rss0 KiB", "rss KiB");
+    for (auto [payloadSize, rounds] : {std::pair<size_t, int>{32, 20000}, {4096, 5000}, {262144, 200}}) {
+        try {
+            runBenchmark("POLL", EventLoopType::POLL, payloadSize, rounds);
+            runBenchmark("EPOLL", EventLoopType::EPOLL, payloadSize, rounds);
+            runBenchmark("IO_URING", EventLoopType::IO_URING, payloadSize, rounds);
+            // Responses longer than short messages, written into the output of the connection
+            runBenchmark("PALINDROME", EventLoopType::EPOLL, payloadSize, rounds,
+                         []() -> AbstractResponseSchema { return std::make_unique<PalindromeResponseSchema>(); });
+        } catch (const std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "listener/schema_kernels.hpp"
+
+using namespace echo;
+using namespace echo::bench;
+
+namespace {
+/* Bytes processed per payload size and kernel, enough for a stable rate without running for long */
+const double bytesPerRun = 2e9;
+
+/* Characters the censor benchmarks take their censored sets from and build their messages of */
+const std::string printable = "etaoinshrdlucmfwypvbgkjqxzETAOINSHRDLUCMFWYPVBGKJQXZ0123456789 .,;:!?'\"()-_/@#$%&*+=<>";
+
+/* The byte at a time reverse the schema used before the kernels, kept out of line so it is measured like them */
+__attribute__((noinline)) void reverseBytewise(char *data, size_t size) { std::reverse(data, data + size); }
+
+/* Censored set of the std::remove based censor, which the censor kernels replaced */
+std::string removedChars;
+
+/* The censoring of the schema before the kernels, std::remove of its single character, generalized to a set */
+__attribute__((noinline)) size_t censorRemove([[maybe_unused]] const CensorTable &table, char *data, size_t size) {
+    if (removedChars.size() == 1) {
+        return std::remove(data, data + size, removedChars[0]) - data;
+    }
+    return std::remove_if(data, data + size, [](char c) { return removedChars.find(c) != std::string::npos; }) - data;
+}
+
+/* Reverses a message of "payloadSize" bytes over and over with "reverse", reporting its throughput. The message stays
+ * in the cache, so this is the cost of the kernel alone */
+void runReverseBenchmark(const char *name, ReverseKernel reverse, size_t payloadSize) {
+    std::vector<char> message(payloadSize);
+    for (size_t i = 0; i < payloadSize; i++) {
+        message[i] = static_cast<char>('a' + i % 26);
+    }
+
+    size_t rounds = std::max<size_t>(1, static_cast<size_t>(bytesPerRun / payloadSize));
+    auto start = Clock::now();
+    for (size_t round = 0; round < rounds; round++) {
+        reverse(message.data(), message.size());
+    }
+    double elapsed = secondsSince(start);
+
+    std::printf("%-10s %10zu %14.0f %10.2f\n", name, payloadSize, rounds / elapsed,
+                static_cast<double>(rounds) * payloadSize / elapsed / 1e9);
+}
+
+/* Censors the first "censoredCount" characters of "printable" from a message of "payloadSize" bytes of them over and
+ * over with "censor", reporting its throughput. Every round first restores the message, a copy every kernel pays */
+void runCensorBenchmark(const char *name, CensorKernel censor, size_t censoredCount, size_t payloadSize) {
+    std::vector<char> message(payloadSize);
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < payloadSize; i++) {
+        state ^= state << 13, state ^= state >> 7, state ^= state << 17;
+        message[i] = printable[state % printable.size()];
+    }
+    removedChars = printable.substr(0, censoredCount);
+    CensorTable table(removedChars);
+
+    std::vector<char> buffer(payloadSize);
+    size_t kept = 0;
+    size_t rounds = std::max<size_t>(1, static_cast<size_t>(bytesPerRun / 4 / payloadSize));
+    auto start = Clock::now();
+    for (size_t round = 0; round < rounds; round++) {
+        std::memcpy(buffer.data(), message.data(), payloadSize);
+        kept = censor(table, buffer.data(), payloadSize);
+    }
+    double elapsed = secondsSince(start);
+
+    std::printf("%-10s %8zu %10zu %8.0f%% %10.2f\n", name, censoredCount, payloadSize, 100.0 * kept / payloadSize,
+                static_cast<double>(rounds) * payloadSize / elapsed / 1e9);
+}
+
+/* Every level the CPU can run */
+std::vector<SimdLevel> getSupportedLevels() {
+    std::vector<SimdLevel> levels;
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSSE3, SimdLevel::AVX2}) {
+        if (level <= detectSimdLevel()) {
+            levels.emplace_back(level);
+        }
+    }
+    return levels;
+}
+} // namespace
+
+int main() {
+    std::setvbuf(stdout, nullptr, _IOLBF, 0);
+    std::printf("Detected %s\n", getSimdLevelName(detectSimdLevel()));
+    std::printf("%-10s %10s %14s %10s\n", "reverse", "payload", "msgs/s", "GB/s");
+    for (size_t payloadSize : {16, 64, 512, 4096, 65536}) {
+        runReverseBenchmark("BYTEWISE", reverseBytewise, payloadSize);
+        for (SimdLevel level : getSupportedLevels()) {
+            runReverseBenchmark(getSimdLevelName(level), getReverseKernel(level), payloadSize);
+        }
+    }
+
+    std::printf("\n%-10s %8s %10s %9s %10s\n", "censor", "chars", "payload", "kept", "GB/s");
+    for (size_t censoredCount : {1, 4, 16, 64}) {
+        for (size_t payloadSize : {64, 4096}) {
+            runCensorBenchmark("REMOVE", censorRemove, censoredCount, payloadSize);
+            for (SimdLevel level : getSupportedLevels()) {
+                runCensorBenchmark(getSimdLevelName(level), getCensorKernel(level), censoredCount, payloadSize);
+            }
+        }
+    }
+
+    return 0;
+}
\ No newline at end of file
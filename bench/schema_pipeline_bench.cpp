@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "CLI/tokens.hpp"
+#include "bench_utils.hpp"
+#include "listener/response_schema_factory.hpp"
+
+using namespace echo;
+using namespace echo::bench;
+
+namespace {
+/* Bytes processed per pipeline and payload size, enough for a stable rate without running for long */
+const double bytesPerRun = 5e8;
+
+/* Characters the messages are made of */
+const std::string printable = "etaoinshrdlucmfwypvbgkjqxzETAOINSHRDLUCMFWYPVBGKJQXZ0123456789 .,;:!?'\"()-_/@#$%&*+=<>";
+
+/* Pipelines of byte-wise stages, all of which fuse into a single pass */
+const std::vector<std::string> pipelines = {"CENSORED:CHARS=aeiou,REVERSE", "CENSORED:CHARS=aeiou:MASK=*,REVERSE",
+                                            "CENSORED:CHAR=a,CENSORED:CHAR=e,CENSORED:CHAR=i,REVERSE",
+                                            "CENSORED:CHARS=aeiou:MASK=*,CENSORED:CHARS=xyz",
+                                            "REVERSE,CENSORED:CHARS=0-9,REVERSE"};
+
+AbstractResponseSchema createSchema(const std::string &choice) {
+    AbstractTokens tokens = std::make_unique<RuntimeTokens>("--set-response-schema " + choice);
+    return ResponseSchemaFactory().createSchema(tokens);
+}
+
+/* Runs "stages" one after the other in place on a message of "payloadSize" bytes over and over, returning the
+ * throughput in GB/s. Every round first restores the message, a copy both ways of running a pipeline pay */
+double measureStages(const std::vector<AbstractResponseSchema> &stages, size_t payloadSize) {
+    std::vector<char> message(payloadSize);
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < payloadSize; i++) {
+        state ^= state << 13, state ^= state >> 7, state ^= state << 17;
+        message[i] = printable[state % printable.size()];
+    }
+
+    std::vector<char> buffer(payloadSize);
+    size_t rounds = std::max<size_t>(1, static_cast<size_t>(bytesPerRun / payloadSize));
+    auto start = Clock::now();
+    for (size_t round = 0; round < rounds; round++) {
+        std::memcpy(buffer.data(), message.data(), payloadSize);
+        size_t size = payloadSize;
+        for (const AbstractResponseSchema &stage : stages) {
+            size = stage->writeResponse(std::span<const char>(buffer.data(), size), buffer);
+        }
+    }
+    return static_cast<double>(rounds) * payloadSize / secondsSince(start) / 1e9;
+}
+
+/* Compares the stages of "pipeline" run one schema at a time, as a chain of separate schemas would, against the
+ * pipeline schema fusing them */
+void runPipelineBenchmark(const std::string &pipeline, size_t payloadSize) {
+    std::vector<AbstractResponseSchema> sequential;
+    for (size_t start = 0; start <= pipeline.size();) {
+        size_t end = std::min(pipeline.find(',', start), pipeline.size());
+        std::string stage = pipeline.substr(start, end - start);
+        std::replace(stage.begin(), stage.end(), ':', ' ');
+        sequential.emplace_back(createSchema(stage));
+        start = end + 1;
+    }
+    std::vector<AbstractResponseSchema> fused;
+    fused.emplace_back(createSchema("PIPELINE " + pipeline));
+
+    double sequentialRate = measureStages(sequential, payloadSize);
+    double fusedRate = measureStages(fused, payloadSize);
+    std::printf("%-54s %8zu %11.2f %11.2f %8.2fx\n", pipeline.c_str(), payloadSize, sequentialRate, fusedRate,
+                fusedRate / sequentialRate);
+}
+} // namespace
+
+int main() {
+    std::setvbuf(stdout, nullptr, _IOLBF, 0);
+    std::printf("Detected %s\n", getSimdLevelName(detectSimdLevel()));
+    std::printf("%-54s %8s %11s %11s %9s\n", "pipeline", "payload", "sequential", "fused", "speedup");
+    for (const std::string &pipeline : pipelines) {
+        for (size_t payloadSize : {64, 4096, 65536}) {
+            runPipelineBenchmark(pipeline, payloadSize);
+        }
+    }
+    return 0;
+}
\ No newline at end of file
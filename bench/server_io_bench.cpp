@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "bench_utils.hpp"
+
+using namespace echo;
+using namespace echo::bench;
+
+namespace {
+const char message[] = "benchmark message of 32 bytes.\n";
+const size_t messageLen = sizeof(message) - 1;
+const size_t handOffChunk = 1000;
+
+/* Connects "connections" clients to a server running "config" and measures echo throughput over "rounds" rounds, each
+ * round sending one message on every connection before reading all the responses */
+void runBenchmark(const char *name, const ServerConfig &config, size_t connections, int rounds) {
+    ServerProcess server(config);
+    std::vector<int> clients;
+    clients.reserve(connections);
+    char response[messageLen];
+
+    // Hand the connections over in chunks, so the bench process never holds both ends of every socket pair
+    while (clients.size() < connections) {
+        std::vector<int> serverEnds;
+        size_t chunkStart = clients.size();
+        for (size_t i = 0; i < handOffChunk && clients.size() < connections; i++) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == -1) {
+                throw std::system_error(errno, std::generic_category(), "Benchmark socket pair error");
+            }
+            fcntl(pair[1], F_SETFL, O_NONBLOCK);
+            setReceiveTimeout(pair[0], 10);
+            server.handOff(pair[1]);
+            clients.emplace_back(pair[0]);
+            serverEnds.emplace_back(pair[1]);
+        }
+
+        // A response proves the server duplicated the socket, so our copy of its end can be closed
+        for (size_t i = chunkStart; i < clients.size(); i++) {
+            writeAll(clients[i], message, messageLen);
+            readExactly(clients[i], response, sizeof(response));
+        }
+        for (int fd : serverEnds) {
+            close(fd);
+        }
+    }
+
+    std::vector<double> roundLatencies;
+    auto start = Clock::now();
+    for (int round = 0; round < rounds; round++) {
+        auto roundStart = Clock::now();
+        for (int fd : clients) {
+            writeAll(fd, message, messageLen);
+        }
+        for (int fd : clients) {
+            readExactly(fd, response, sizeof(response));
+        }
+        roundLatencies.emplace_back(secondsSince(roundStart) * 1e3);
+    }
+    double elapsed = secondsSince(start);
+
+    std::printf("%-10s %8zu %14.0f %14.3f %14.3f\n", name, connections, connections * rounds / elapsed,
+                percentile(roundLatencies, 50), percentile(roundLatencies, 99));
+
+    for (int fd : clients) {
+        close(fd);
+    }
+}
+} // namespace
+
+/* Usage: server_io_bench [server threads] */
+int main(int argc, char *argv[]) {
+    int reactorCount = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 1;
+    raiseFdLimit();
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::setvbuf(stdout, nullptr, _IOLBF, 0);
+    std::printf("server threads: %d\n", reactorCount);
+    std::printf("%-10s %8s %14s %14s %14s\n", "mode", "conns", "msgs/s", "round p50 ms", "round p99 ms");
+    for (auto [connections, rounds] : {std::pair<size_t, int>{1000, 200}, {10000, 40}}) {
+        try {
+            runBenchmark("POLL", {EventLoopType::POLL, reactorCount}, connections, rounds);
+            runBenchmark("EPOLL", {EventLoopType::EPOLL, reactorCount}, connections, rounds);
+            runBenchmark("IO_URING", {EventLoopType::IO_URING, reactorCount}, connections, rounds);
+        } catch (const std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <iostream>
+
+#include "bench_utils.hpp"
+
+using namespace echo;
+using namespace echo::bench;
+
+namespace {
+const char message[] = "ping\n";
+const size_t messageLen = sizeof(message) - 1;
+
+/* Servers of the dispatcher whose handoff latency is measured, and of the smaller one the memory is compared to */
+const int serverCount = 8;
+const int baselineServerCount = 1;
+
+/* Opens "connections" connections one at a time to a running dispatcher (over the Unix domain listener if "overUnix",
+ * the Internet one otherwise), each sending one message and closed once it got the response. Returns the latency of
+ * every connection in microseconds, from the start of the connect to the response, which is dominated by the accept
+ * and the handoff since the message itself is a single round trip */
+std::vector<double> measureHandoffs(bool overUnix, size_t connections) {
+    std::vector<double> latencies;
+    char response[messageLen];
+    for (size_t i = 0; i < connections; i++) {
+        auto start = Clock::now();
+        int fd = overUnix ? connectUnix(startUnixPath) : connectInet(startPort);
+        setReceiveTimeout(fd, 10);
+        writeAll(fd, message, messageLen);
+        readExactly(fd, response, sizeof(response));
+        latencies.emplace_back(secondsSince(start) * 1e6);
+        close(fd);
+    }
+    return latencies;
+}
+
+/* Runs a dispatcher whose servers run as "mode" (PROCESS or THREAD) and reports the latency of handing connections over
+ * to its servers and the memory every additional server costs */
+void runBenchmark(const char *mode) {
+    size_t baselineKiB;
+    {
+        DispatcherProcess dispatcher({"--event-loop", "EPOLL", "--workers", mode}, baselineServerCount);
+        baselineKiB = dispatcher.getProportionalSetKiB();
+    }
+
+    DispatcherProcess dispatcher({"--event-loop", "EPOLL", "--workers", mode}, serverCount);
+    size_t idleKiB = dispatcher.getProportionalSetKiB();
+
+    for (bool overUnix : {true, false}) {
+        std::vector<double> latencies = measureHandoffs(overUnix, 2000);
+        std::printf("%-8s %-6s %8d %10.1f %10.1f %12.1f %14.0f %14zu\n", mode, overUnix ? "UNIX" : "INET",
+                    serverCount, percentile(latencies, 50), percentile(latencies, 99), percentile(latencies, 99.9),
+                    static_cast<double>(idleKiB - std::min(idleKiB, baselineKiB)) / (serverCount - baselineServerCount),
+                    dispatcher.getProportionalSetKiB());
+    }
+}
+} // namespace
+
+/* Compares the servers running as processes forked by the dispatcher with servers running as its threads: the latency
+ * of connections handed over to the servers until their first response, the memory (proportional set size) of an idle
+ * server, and the memory of the whole dispatcher once it served the connections */
+int main() {
+    raiseFdLimit();
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::setvbuf(stdout, nullptr, _IOLBF, 0);
+    try {
+        std::printf("%-8s %-6s %8s %10s %10s %12s %14s %14s\n", "workers", "via", "servers", "p50 us", "p99 us",
+                    "p99.9 us", "KiB/server", "total KiB");
+        for (const char *mode : {"PROCESS", "THREAD"}) {
+            runBenchmark(mode);
+        }
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+    }
+
+    return 0;
+}
\ No newline at end of file
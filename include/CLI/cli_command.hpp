@@ -46,6 +46,118 @@ class ChangeResponseSchemaCliCommand : public CliCommand<Dispatcher> {
     void execute(AbstractTokens tokens) const override;
 };
 
+class EventLoopCliCommand : public CliCommand<Dispatcher> {
+  public:
+    EventLoopCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class ServerThreadsCliCommand : public CliCommand<Dispatcher> {
+  public:
+    ServerThreadsCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class MaxClientsCliCommand : public CliCommand<Dispatcher> {
+  public:
+    MaxClientsCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class ListenBacklogCliCommand : public CliCommand<Dispatcher> {
+  public:
+    ListenBacklogCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class HugePagesCliCommand : public CliCommand<Dispatcher> {
+  public:
+    HugePagesCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class HandoffCliCommand : public CliCommand<Dispatcher> {
+  public:
+    HandoffCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class ReusePortCliCommand : public CliCommand<Dispatcher> {
+  public:
+    ReusePortCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class RedirectCliCommand : public CliCommand<Dispatcher> {
+  public:
+    RedirectCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class WorkersCliCommand : public CliCommand<Dispatcher> {
+  public:
+    WorkersCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class PlacementCliCommand : public CliCommand<Dispatcher> {
+  public:
+    PlacementCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class BalancingCliCommand : public CliCommand<Dispatcher> {
+  public:
+    BalancingCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class AddServersCliCommand : public CliCommand<Dispatcher> {
+  public:
+    AddServersCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class RemoveServerCliCommand : public CliCommand<Dispatcher> {
+  public:
+    RemoveServerCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class AutoscaleCliCommand : public CliCommand<Dispatcher> {
+  public:
+    AutoscaleCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class ListServersCliCommand : public CliCommand<Dispatcher> {
+  public:
+    ListServersCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
+class FramingCliCommand : public CliCommand<Dispatcher> {
+  public:
+    FramingCliCommand(Dispatcher &app) : CliCommand<Dispatcher>(app){};
+
+    void execute(AbstractTokens tokens) const override;
+};
+
 class SendToServerCliCommand : public CliCommand<Client> {
   public:
     SendToServerCliCommand(Client &app) : CliCommand<Client>(app){};
@@ -23,6 +23,10 @@ class Tokens {
      * otherwise returns an empty string  */
     virtual std::string getChoiceArgument() const = 0;
 
+    /* Returns the token following the argument for the option's choice (e.g MASK=* after CHARS=abc) if found in
+     * "tokens", otherwise returns an empty string */
+    virtual std::string getNextChoiceArgument() const = 0;
+
     /* Returns "tokens" concatenated into a string, separated by the "delimiter" */
     std::string detokenize(char delimiter);
 
@@ -42,6 +46,8 @@ class RuntimeTokens : public Tokens {
     inline std::string getChoice() const override { return getTokenAtIndex(1); };
 
     inline std::string getChoiceArgument() const override { return getTokenAtIndex(2); };
+
+    inline std::string getNextChoiceArgument() const override { return getTokenAtIndex(3); };
 };
 
 class StartupTokens : public Tokens {
@@ -55,6 +61,12 @@ class StartupTokens : public Tokens {
     inline std::string getExecutable() const { return getTokenAtIndex(0); };
 
     inline std::string getChoiceArgument() const override { return getTokenAtIndex(3); };
+
+    inline std::string getNextChoiceArgument() const override { return getTokenAtIndex(4); };
+
+    /* Splits startup "args" (executable followed by any number of options) into one StartupTokens per option, each
+     * starting with the executable followed by the option (token starting with "--") and its choice/arguments */
+    static std::vector<std::unique_ptr<Tokens>> splitByOption(const std::vector<std::string> &args);
 };
 
 using AbstractTokens = std::unique_ptr<Tokens>;
@@ -31,9 +31,14 @@ class Client {
 
     inline AbstractSocket &getClientSocket() { return clientSocket; };
 
+    inline FrameDecoder &getResponseDecoder() { return responseDecoder; }
+
   private:
     AbstractSocket clientSocket;
 
+    /* Reassembles the server's responses, which may arrive split across reads */
+    FrameDecoder responseDecoder;
+
     /* inputToCommand maps user CLI inputs to their respective commands that hold command executors */
     std::unordered_map<std::string, AbstractCliCommand> inputToCommand;
 };
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "listener/server_load.hpp"
+
+namespace echo {
+
+/* Time the load of the servers is given to settle after the pool changed, before the autoscaler changes it again */
+const std::chrono::seconds autoscaleCooldown{5};
+
+/* Grows and shrinks the dispatcher's pool of servers between "minServers" and "maxServers", one server at a time, so
+ * that the average load score of the servers (see ServerLoadMonitor::getLoadScore) stays between "scaleDownLoad" and
+ * "scaleUpLoad" */
+class Autoscaler {
+  public:
+    Autoscaler(size_t minServers, size_t maxServers, double scaleDownLoad, double scaleUpLoad)
+        : minServers(minServers), maxServers(maxServers), scaleDownLoad(scaleDownLoad), scaleUpLoad(scaleUpLoad){};
+
+    /* Returns by how many servers the pool of "servers" should change at "now": 1 to start a server, -1 to retire one,
+     * or 0. A change is assumed to be carried out, so the next one waits for the cooldown */
+    int getPoolChange(const std::vector<ServerLoadMonitor> &servers, std::chrono::steady_clock::time_point now);
+
+    /* Returns the index of the server in "servers" (never empty) to retire, the one with the fewest clients since it
+     * drains the fastest */
+    static size_t pickServerToRetire(const std::vector<ServerLoadMonitor> &servers);
+
+    inline size_t getMinServers() const { return minServers; }
+
+    inline size_t getMaxServers() const { return maxServers; }
+
+  private:
+    size_t minServers;
+    size_t maxServers;
+    double scaleDownLoad;
+    double scaleUpLoad;
+
+    /* No change is made before this time */
+    std::chrono::steady_clock::time_point quietUntil;
+};
+} // namespace echo
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CLI/tokens.hpp"
+#include "listener/server_load.hpp"
+
+namespace echo {
+
+enum class BalancingType { ROUND_ROBIN, LEAST_CONNECTIONS, WEIGHTED, POWER_OF_TWO, UNKNOWN };
+
+/* Decides which server receives the next client accepted by the dispatcher */
+class IBalancingStrategy {
+  public:
+    virtual ~IBalancingStrategy(){};
+
+    /* Returns the index of the server in "servers" (never empty) that receives the next client */
+    virtual size_t pickServer(const std::vector<ServerLoadMonitor> &servers) = 0;
+};
+
+using AbstractBalancingStrategy = std::unique_ptr<IBalancingStrategy>;
+
+/* Every server in turn, regardless of its load */
+class RoundRobinStrategy : public IBalancingStrategy {
+  public:
+    size_t pickServer(const std::vector<ServerLoadMonitor> &servers) override;
+
+  private:
+    size_t nextIdx = 0;
+};
+
+/* The server with the fewest clients, ties going to the servers in turn */
+class LeastConnectionsStrategy : public IBalancingStrategy {
+  public:
+    size_t pickServer(const std::vector<ServerLoadMonitor> &servers) override;
+
+  private:
+    size_t nextIdx = 0;
+};
+
+/* Smooth weighted round robin: out of every "sum of weights" clients, every server receives as many as its weight,
+ * interleaved rather than in runs. The i-th weight belongs to the server with ID i (starting at 1), so weights stay
+ * with their servers as others join or leave the pool. Servers without a weight weigh 1 */
+class WeightedRoundRobinStrategy : public IBalancingStrategy {
+  public:
+    WeightedRoundRobinStrategy(std::vector<int> weights) : weights(std::move(weights)){};
+
+    size_t pickServer(const std::vector<ServerLoadMonitor> &servers) override;
+
+    inline const std::vector<int> &getWeights() const { return weights; }
+
+  private:
+    /* Credit a server accumulated towards its next client */
+    struct Credit {
+        int serverId;
+        int64_t weight;
+    };
+
+    /* Lines "currentWeights" up with "servers" after a pool change. Servers still in the pool keep their credit,
+     * newcomers start without any and the ones gone are dropped */
+    void followPool(const std::vector<ServerLoadMonitor> &servers);
+
+    int getWeight(int serverId) const;
+
+    std::vector<int> weights;
+
+    /* Credit of every server, in the order of the pool */
+    std::vector<Credit> currentWeights;
+};
+
+/* The less loaded (see ServerLoadMonitor::getLoadScore) of two servers chosen at random. Avoids both the herding of
+ * always picking the least loaded server based on slightly stale load and the cost of comparing every server */
+class PowerOfTwoChoicesStrategy : public IBalancingStrategy {
+  public:
+    size_t pickServer(const std::vector<ServerLoadMonitor> &servers) override;
+
+  private:
+    std::minstd_rand random{std::random_device{}()};
+};
+
+class BalancingStrategyFactory {
+  public:
+    /* Returns the balancing strategy chosen in "tokens" configured by its arguments, or nullptr if there is no such
+     * strategy or the arguments are invalid */
+    AbstractBalancingStrategy createStrategy(const AbstractTokens &tokens);
+
+    /* Returns strategy type based on the "choice" string */
+    static BalancingType getBalancingType(const std::string &choice);
+
+  private:
+    /* Parses the comma separated weights (e.g 4,2,1) of the weighted strategy */
+    std::unique_ptr<WeightedRoundRobinStrategy> newWeightedStrategy(const AbstractTokens &tokens);
+};
+} // namespace echo
\ No newline at end of file
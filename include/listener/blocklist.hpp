@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace echo {
+
+/* Longest blocked word, so that the length of a match fits a byte */
+const size_t maxBlockedWordLength = 255;
+
+/* Most transitions an automaton may have, so that a row offset fits the 24 bits a transition holds it in */
+const size_t maxBlocklistTransitions = 1 << 24;
+
+/* Aho-Corasick automaton of a list of blocked words, finding every occurrence of every word (ASCII letters matching
+ * regardless of case) in a single pass over a message, one table lookup per byte whatever the number of words.
+ * Failure links are resolved when the automaton is built, leaving a complete transition table in one flat array: a row
+ * per state and a column per class of bytes, bytes in no word sharing a single class. Every transition holds the row
+ * offset of the next state along with the length of the longest word ending in it, so the scan touches nothing else.
+ * Immutable once built, so threads may share it */
+class BlocklistAutomaton {
+  public:
+    /* Builds the automaton of "words", skipping empty ones. Throws std::length_error if a word is longer than
+     * maxBlockedWordLength or the table would exceed maxBlocklistTransitions */
+    explicit BlocklistAutomaton(const std::vector<std::string> &words);
+
+    /* Removes every occurrence of a blocked word from the "size" bytes of "message" in place, or replaces its bytes
+     * with "mask" if there is one. Occurrences may overlap. Returns the length of the result */
+    size_t filter(char *message, size_t size, std::optional<char> mask) const;
+
+    inline size_t getStateCount() const { return transitions.size() / classCount; }
+
+  private:
+    /* Class of every byte, its column in the transition table */
+    uint8_t byteClasses[256] = {};
+    size_t classCount = 1;
+
+    /* Row offset of the next state (state * classCount) shifted left by 8, ORed with the length of the longest word
+     * ending there, at the row offset of a state plus the class of a byte. The start state is row 0 */
+    std::vector<uint32_t> transitions;
+};
+
+/* Reads the blocked words of the file at "path", one per line. Blank lines and lines starting with '#' are skipped.
+ * Returns std::nullopt if the file can't be read, holds no word or holds one longer than maxBlockedWordLength */
+std::optional<std::vector<std::string>> readBlocklist(const std::string &path);
+} // namespace echo
\ No newline at end of file
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <sys/uio.h>
+#include <vector>
+
+#include "socket/buffer_pool.hpp"
+#include "socket/framing.hpp"
+
+namespace echo {
+
+/* Once the unsent output of a connection grows past the high-water mark, reading from that client pauses until the
+ * output drains below the low-water mark */
+const size_t outputHighWaterMark = 64 * 1024;
+const size_t outputLowWaterMark = 16 * 1024;
+
+/* Responses at least this large are sent with MSG_ZEROCOPY on connections that support it. Below that, pinning the
+ * pages and handling the completion costs more than the copy it saves */
+const size_t zeroCopyThreshold = 64 * 1024;
+
+/* Minimum size of the blocks holding output copied into a connection */
+const size_t outputBlockSize = 16 * 1024;
+
+/* State of a single client connection of a server: the output the client hasn't accepted yet and the flow control
+ * flags derived from it */
+class Connection {
+  public:
+    /* Both received and unsent bytes are kept in buffers taken from "pool", or from the heap if there is no pool */
+    Connection(int fd, FramingType framing = FramingType::LINE, BufferPool *pool = nullptr)
+        : fd(fd), pool(pool), decoder(framing, pool){};
+
+    /* Appends a copy of "data" to the unsent output */
+    void queueOutput(std::string_view data);
+
+    /* Appends "payload" framed the same way as the client's messages to the unsent output */
+    void queueFrame(std::string_view payload);
+
+    /* Reserves room at the end of the unsent output for a frame, framed the same way as the client's messages, whose
+     * payload holds up to "maxPayloadSize" bytes, and returns the part the payload is to be written to. Nothing is sent
+     * or queued before "commitFrame" */
+    std::span<char> reserveFrame(size_t maxPayloadSize);
+
+    /* Completes the frame reserved last with its first "payloadSize" bytes of payload and queues it */
+    void commitFrame(size_t payloadSize);
+
+    /* Appends "data" to the unsent output without copying it, merging it with the previous view if they are adjacent.
+     * "data" has to stay valid until it is sent, or until "materializeViews" or "pinViews" is called */
+    void queueView(std::string_view data);
+
+    /* Copies the unsent part of all views into output owned by the connection */
+    void materializeViews();
+
+    /* Takes over "storage", the memory all unsent views point into, keeping it alive until they are sent and, with
+     * zero-copy enabled, until the kernel reports it no longer needs the pages */
+    void pinViews(Buffer storage);
+
+    /* Fills up to "maxCount" entries of "iov" with the front blocks of unsent output and returns their number. Pinned
+     * blocks are never gathered together with other blocks. "zeroCopy" tells whether the gathered blocks should be sent
+     * with MSG_ZEROCOPY */
+    size_t gatherOutput(struct iovec *iov, size_t maxCount, bool &zeroCopy) const;
+
+    /* Counts a successful send of pinned output with MSG_ZEROCOPY */
+    void recordZeroCopySend();
+
+    /* Handles a zero-copy completion notification covering all sends up to the "lastCompleted"-th one */
+    void completeZeroCopySends(uint32_t lastCompleted);
+
+    inline bool hasZeroCopyInFlight() const { return zeroCopySends != zeroCopyCompleted; }
+
+    inline bool isZeroCopyEnabled() const { return zeroCopyEnabled; }
+
+    inline void setZeroCopyEnabled(bool enabled) { zeroCopyEnabled = enabled; }
+
+    /* Reassembles the frames received from the client */
+    inline FrameDecoder &getDecoder() { return decoder; }
+
+    /* Returns the oldest contiguous block of unsent output (empty if there is nothing to send) */
+    std::string_view getFrontOutput() const;
+
+    /* Marks the first "bytes" of the unsent output as sent */
+    void consumeOutput(size_t bytes);
+
+    /* Drops all unsent output, e.g once the client is known to be gone. Pinned buffers stay until the zero-copy sends
+     * that could reference them are complete, and a front block in flight until "finishFrontSend" */
+    void discardOutput();
+
+    inline size_t getPendingBytes() const { return pendingBytes; }
+
+    inline bool hasPendingOutput() const { return pendingBytes > 0; }
+
+    inline bool isAboveHighWaterMark() const { return pendingBytes > outputHighWaterMark; }
+
+    inline bool isBelowLowWaterMark() const { return pendingBytes <= outputLowWaterMark; }
+
+    /* While the front output is handed to the kernel (asynchronous sends), newly queued output goes to a separate
+     * block, so the bytes in flight are never moved */
+    inline void setFrontInFlight(bool inFlight) { frontInFlight = inFlight; }
+
+    inline bool isFrontInFlight() const { return frontInFlight; }
+
+    /* Marks the asynchronous send of the front output as complete. Returns true if the output was discarded while the
+     * send was in flight, the completion then only releasing the block it was reading from */
+    bool finishFrontSend();
+
+    inline int getFd() const { return fd; }
+
+    inline bool isReadPaused() const { return readPaused; }
+
+    inline void setReadPaused(bool paused) { readPaused = paused; }
+
+    /* Events currently watched on the connection by the event loop */
+    inline uint32_t getWatchedEvents() const { return watchedEvents; }
+
+    inline void setWatchedEvents(uint32_t events) { watchedEvents = events; }
+
+    /* Whether a (multishot) receive is armed on the connection (IO_URING data path) */
+    inline bool isReceiving() const { return receiving; }
+
+    inline void setReceiving(bool isReceiving) { receiving = isReceiving; }
+
+    /* Whether the connection is done and only waits for outstanding requests before being closed */
+    inline bool isClosing() const { return closing; }
+
+    inline void setClosing(bool isClosing) { closing = isClosing; }
+
+  private:
+    /* Block of unsent output, either the first "ownedSize" bytes of a buffer owned by the connection or a view into
+     * memory kept alive elsewhere */
+    struct OutputBlock {
+        Buffer owned;
+        size_t ownedSize = 0;
+        const char *view = nullptr;
+        size_t viewSize = 0;
+
+        /* Set for views into a pinned buffer, holding its id */
+        bool pinned = false;
+        uint64_t pinnedBufferId = 0;
+
+        inline std::string_view getBytes() const {
+            return view != nullptr ? std::string_view(view, viewSize) : std::string_view(owned.getData(), ownedSize);
+        }
+
+        inline bool isBorrowed() const { return view != nullptr && !pinned; }
+    };
+
+    /* Memory holding pinned views, released once none of its views is unsent and all zero-copy sends issued up to the
+     * last one that could have referenced it are complete */
+    struct PinnedBuffer {
+        Buffer storage;
+        size_t unsentBlocks;
+        uint32_t sendsIssued;
+    };
+
+    /* Drops the front block once fully sent, releasing pinned buffers that are no longer needed */
+    void popFrontBlock();
+
+    void releasePinnedBuffers();
+
+    /* Whether owned output can be appended to the last block */
+    bool canAppendToBack() const;
+
+    int fd;
+    BufferPool *pool;
+
+    FrameDecoder decoder;
+
+    /* Unsent output split into blocks, starting at index "outputHead". Owned output is appended to the last block
+     * whenever possible. Sent blocks are dropped by moving the head, so the vector only allocates while it grows */
+    std::vector<OutputBlock> outputBlocks;
+    size_t outputHead = 0;
+
+    /* Front block discarded while its asynchronous send was in flight, kept until the send completes */
+    std::optional<OutputBlock> discardedFront;
+
+    /* Views being materialized, kept around to reuse its capacity */
+    std::vector<std::string_view> materializing;
+
+    /* Pinned buffers in the order they were pinned, the front one having the id "firstPinnedBufferId" */
+    std::deque<PinnedBuffer> pinnedBuffers;
+    uint64_t firstPinnedBufferId = 0;
+
+    /* Zero-copy sends issued and completed, wrapping around like the kernel's notification counter */
+    uint32_t zeroCopySends = 0;
+    uint32_t zeroCopyCompleted = 0;
+    bool zeroCopyEnabled = false;
+
+    /* Number of bytes of the first block that have already been sent */
+    size_t frontOffset = 0;
+
+    size_t pendingBytes = 0;
+    bool frontInFlight = false;
+    bool readPaused = false;
+    uint32_t watchedEvents = 0;
+    bool receiving = false;
+    bool closing = false;
+};
+} // namespace echo
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "listener/connection.hpp"
+
+namespace echo {
+
+/* Generations wrap around after this many bits, so a handle fits into 56 bits of e.g io_uring user data */
+const uint32_t connectionGenerationBits = 24;
+
+/* Reference to a connection that never resolves to a later connection reusing the same file descriptor */
+struct ConnectionHandle {
+    int fd;
+    uint32_t generation;
+};
+
+/* Connections of a reactor indexed by their socket. Inserting, finding and removing a connection is O(1) without
+ * hashing, and a connection never moves while it is in the table, so references to it stay valid until it is removed.
+ * Slots are allocated in pages that are kept once allocated, so connection churn doesn't allocate memory */
+class ConnectionTable {
+  public:
+    ConnectionTable() = default;
+    ConnectionTable(const ConnectionTable &) = delete;
+    ConnectionTable &operator=(const ConnectionTable &) = delete;
+
+    /* Adds a connection on the socket "fd", which must not be in the table yet, and returns it */
+    Connection &insert(int fd, FramingType framing, BufferPool *pool);
+
+    /* Returns the connection on the socket "fd", or nullptr if there is none */
+    Connection *find(int fd);
+
+    /* Returns the connection referred to by "handle", or nullptr if it has been removed since */
+    Connection *find(ConnectionHandle handle);
+
+    /* Returns the handle of the connection on the socket "fd" */
+    ConnectionHandle getHandle(int fd) const;
+
+    /* Removes the connection on the socket "fd", invalidating its handles */
+    void erase(int fd);
+
+    inline size_t size() const { return count; }
+
+    /* Calls "function" with every connection in the table */
+    template <typename F> void forEach(F function) {
+        for (auto &page : pages) {
+            for (size_t i = 0; page != nullptr && i < slotsPerPage; i++) {
+                if (page[i].connection.has_value()) {
+                    function(*page[i].connection);
+                }
+            }
+        }
+    }
+
+  private:
+    static const size_t slotsPerPage = 1024;
+
+    struct Slot {
+        std::optional<Connection> connection;
+        uint32_t generation = 0;
+    };
+
+    /* Returns the slot of "fd", or nullptr if its page hasn't been allocated */
+    Slot *findSlot(int fd) const;
+
+    std::vector<std::unique_ptr<Slot[]>> pages;
+    size_t count = 0;
+};
+} // namespace echo
\ No newline at end of file
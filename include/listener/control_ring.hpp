@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace echo {
+
+/* Size of a cache line. Data written by different threads or processes is kept on separate ones, so that writing one
+ * doesn't invalidate the others in the caches of their readers */
+const size_t cacheLineSize = 64;
+
+/* Bytes of messages a control ring holds at most, including a 4 byte length per message */
+const size_t controlRingCapacity = 64 * 1024;
+
+/* Single-producer single-consumer ring of messages, meant to live in memory shared by two processes. Messages are stored
+ * as their length followed by their bytes, wrapping around the end of the ring. The producer only writes "tail" and the
+ * consumer only "head", each on its own cache line, so neither side takes a lock or makes a syscall. The ring doesn't
+ * wake the consumer up, the producer has to notify it some other way */
+class ControlRing {
+  public:
+    /* Appends "message". Returns false if the ring has no room for it. Must only be called by the producer */
+    bool push(std::string_view message);
+
+    /* Takes the oldest message out of the ring into "message". Returns false if the ring is empty. Must only be called
+     * by the consumer */
+    bool pop(std::string &message);
+
+  private:
+    /* Copies "size" bytes from "bytes" into the ring starting at stream position "position" */
+    void copyIn(uint64_t position, const void *bytes, size_t size);
+
+    /* Copies "size" bytes out of the ring starting at stream position "position" into "bytes" */
+    void copyOut(uint64_t position, void *bytes, size_t size) const;
+
+    /* Bytes consumed and produced since the ring was created, the ring holding the ones in between */
+    alignas(cacheLineSize) std::atomic<uint64_t> head = 0;
+    alignas(cacheLineSize) std::atomic<uint64_t> tail = 0;
+
+    alignas(cacheLineSize) char data[controlRingCapacity];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+} // namespace echo
\ No newline at end of file
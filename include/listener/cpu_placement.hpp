@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace echo {
+
+/* How the dispatcher places its servers on the CPUs it is allowed to run on */
+enum class PlacementPolicy {
+    NONE, // servers run wherever the scheduler moves them
+    CORE, // every server is pinned to as many CPUs of a single NUMA node as it has reactors
+    NODE, // every server is pinned to all CPUs of a NUMA node
+    UNKNOWN
+};
+
+/* CPUs the dispatcher is allowed to run on, along with the NUMA node of each */
+struct CpuTopology {
+    std::vector<int> cpus;
+    std::vector<int> cpuNodes; // node of the CPU at the same index of "cpus"
+
+    /* Reads the topology from the dispatcher's affinity mask and sysfs. CPUs are on node 0 if the system reports no
+     * NUMA nodes */
+    static CpuTopology detect();
+};
+
+/* CPUs a server is pinned to and the NUMA node they belong to */
+struct ServerPlacement {
+    std::vector<int> cpus;
+    int node;
+};
+
+/* Splits the CPUs of a topology into slots, one per server, and hands out the least used one to every new server so
+ * that servers spread over the nodes first and only share CPUs once every slot is taken */
+class CpuPlacement {
+  public:
+    /* Slots of "cpusPerServer" CPUs for CORE (a node with fewer CPUs making a single slot), of whole nodes for NODE.
+     * Slots alternate between the nodes */
+    CpuPlacement(PlacementPolicy policy, const CpuTopology &topology, size_t cpusPerServer);
+
+    /* Returns the slot used by the fewest servers, "slotUses" holding the slot of every placed server */
+    size_t pickSlot(const std::vector<int> &slotUses) const;
+
+    /* Returns the slot containing "cpu", or -1 if none does */
+    int findSlot(int cpu) const;
+
+    /* Pins the calling thread, and the threads it starts later, to the CPUs of "slot" and prefers the memory of their
+     * node for their allocations (the whole server, called first thing in a server process or thread). Throws an error
+     * if the CPUs can't be set */
+    void bindCallingThread(size_t slot) const;
+
+    inline const ServerPlacement &getPlacement(size_t slot) const { return slots[slot]; }
+
+    inline size_t getSlotCount() const { return slots.size(); }
+
+    /* Returns policy type based on the "choice" string */
+    static PlacementPolicy getPlacementPolicy(const std::string &choice);
+
+  private:
+    std::vector<ServerPlacement> slots;
+
+    /* Memory is only bound on systems with more than one node, where it can be remote */
+    bool bindMemory = false;
+};
+
+/* Parses a CPU list in the kernel's format (e.g "0-3,8,10-11"). Returns an empty list if it is malformed */
+std::vector<int> parseCpuList(std::string_view list);
+
+/* Formats sorted "cpus" in the kernel's CPU list format */
+std::string formatCpuList(const std::vector<int> &cpus);
+} // namespace echo
\ No newline at end of file
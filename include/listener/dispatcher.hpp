@@ -1,10 +1,19 @@
 #pragma once
 
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "CLI/cli_command.hpp"
+#include "listener/autoscaler.hpp"
+#include "listener/balancing_strategy.hpp"
+#include "listener/cpu_placement.hpp"
 #include "listener/listener.hpp"
+#include "listener/schema_descriptor.hpp"
 #include "listener/server.hpp"
+#include "listener/server_channel.hpp"
 
 namespace echo {
 
@@ -12,13 +21,45 @@ const int startPort = 6000; // port of the dispatcher (server ports follow it)
 const std::string startUnixPath = "/tmp/unix_socket";
 const std::string startPipePath = "/tmp/fifo";
 
+/* Connections accepted from a single listener per wakeup. Bounded so that a connection storm on one listener can't
+ * starve the other one or delay handing the accepted clients over */
+const size_t maxAcceptBatch = 256;
+
+/* Interval at which the dispatcher applies requested pool changes, runs the autoscaler and respawns crashed servers */
+const int supervisionIntervalMs = 100;
+
+/* A server exiting less than "minServerUptime" after being started is respawned only "crashRespawnDelay" later, so
+ * that a server failing to start doesn't keep the dispatcher forking */
+const std::chrono::seconds minServerUptime{1};
+const std::chrono::seconds crashRespawnDelay{1};
+
+/* How the servers run. PROCESS forks every server, isolating it from the dispatcher and the other servers. THREAD runs
+ * every server on a thread of the dispatcher: servers start without a fork and clients reach them through a lock-free
+ * ring (see InProcessPipe) rather than a pipe, with no copy of their sockets, but a server crashing takes the dispatcher
+ * down with it */
+enum class WorkerMode { PROCESS, THREAD, UNKNOWN };
+
+/* Server process of the pool. "pidFd" is watched by the dispatcher and becomes readable once the process exits, and
+ * unlike the PID it can't end up referring to another process. A server thread has the dispatcher's PID and an eventfd
+ * signalled once the thread is done in place of the pidfd. "restarts" counts how many times a server with this ID
+ * was respawned after crashing. "placementSlot" is the slot of the CPUs it is pinned to (see CpuPlacement), -1 if the
+ * servers aren't placed */
+struct ServerHandle {
+    int pid;
+    int id;
+    int pidFd;
+    int restarts;
+    std::chrono::steady_clock::time_point startedAt;
+    int placementSlot = -1;
+};
+
 using InputToCommandMap = std::unordered_map<std::string, std::unique_ptr<CliCommand<Dispatcher>>>;
 using DispatcherHelpCliCommand = HelpCliCommand<Dispatcher>;
 
 //-----------------------------------------------------------------------------------------------------------------------------
 class Dispatcher : public Listener {
   public:
-    Dispatcher(int initServerCount = 1);
+    Dispatcher(int initServerCount = 1, EventLoopType eventLoopType = EventLoopType::POLL);
     ~Dispatcher();
     Dispatcher(const Dispatcher &) = delete;
     void operator=(const Dispatcher &) = delete;
@@ -27,7 +68,7 @@ class Dispatcher : public Listener {
 
     static void signalHandler(int signum);
 
-    /* Starts up the dispatcher REPL and server processes */
+    /* Starts up the server processes and the dispatcher REPL */
     void start();
 
     /* Executes the command found in "tokens" if command has been setup inside "inputToCommand".
@@ -35,11 +76,83 @@ class Dispatcher : public Listener {
      */
     bool executeCommand(AbstractTokens tokens);
 
-    inline const std::vector<std::pair<int, int>> &getServers() { return servers; }
+    /* Gives "descriptor" the next schema version and sends it to every server, retiring ones included, remembering it
+     * so that servers started later switch to it too. Returns the version, or throws an error if necessary. Can be
+     * called from any thread */
+    uint64_t setResponseSchema(SchemaDescriptor descriptor);
+
+    /* Starts "count" more servers, along with the initial ones if the dispatcher isn't started yet. Can be called from
+     * any thread, the servers being started by the dispatcher's thread */
+    void addServers(int count);
+
+    /* Retires the server with ID "serverId": it receives no new clients and exits once its current clients are gone.
+     * Can be called from any thread, the server being retired by the dispatcher's thread */
+    void removeServer(int serverId);
+
+    /* Replaces the autoscaler growing and shrinking the pool of servers, nullptr turning autoscaling off. Can be
+     * called at any time, from any thread */
+    void setAutoscaler(std::unique_ptr<Autoscaler> newAutoscaler);
+
+    /* Sets the event loop backend used by the dispatcher and its servers. Returns false if the servers are already
+     * running, in which case nothing is changed */
+    bool setEventLoopType(EventLoopType type);
+
+    /* Sets the number of reactor threads of every server. Returns false if the servers are already running, in which
+     * case nothing is changed */
+    bool setServerThreadCount(int threadCount);
+
+    /* Sets the number of clients every server serves at most. Returns false if the servers are already running, in
+     * which case nothing is changed */
+    bool setMaxClients(int maxClients);
+
+    /* Backs the buffer pools of the servers with huge pages. Returns false if the servers are already running, in which
+     * case nothing is changed */
+    bool setHugePages(bool enabled);
+
+    /* Chooses how client sockets are handed over to the servers. Returns false if the servers are already running, in
+     * which case nothing is changed */
+    bool setHandoffTransport(HandoffTransport transport);
 
-    inline int getServerPidAtIdx(int idx) const { return servers[idx].first; }
+    /* Makes every server accept the Internet clients itself on a SO_REUSEPORT socket of the dispatcher's port, spread
+     * by the kernel according to "steering", while Unix domain clients are still handed over by the dispatcher. Returns
+     * false if the servers are already running, in which case nothing is changed */
+    bool setReusePortSteering(ReusePortSteering steering);
 
-    inline int getServerIdAtIdx(int idx) const { return servers[idx].second; }
+    /* Makes the dispatcher answer every client with the address of the server chosen for it (see redirectPrefix)
+     * instead of handing the connection over, and the servers accept the clients reconnecting to their own listeners.
+     * Returns false if the servers are already running, in which case nothing is changed */
+    bool setRedirect(bool enabled);
+
+    /* Makes the Unix domain listeners if "unixListeners", or else the Internet ones, speak "framing". Returns false if
+     * the servers are already running, in which case nothing is changed */
+    bool setFraming(bool unixListeners, FramingType framing);
+
+    /* Runs the servers according to "mode". Returns false if the servers are already running, in which case nothing is
+     * changed */
+    bool setWorkerMode(WorkerMode mode);
+
+    /* Returns the worker mode named "choice" (PROCESS or THREAD), or UNKNOWN */
+    static WorkerMode getWorkerMode(const std::string &choice);
+
+    /* Places the servers on the CPUs according to "policy", each preferring the memory of its NUMA node, and if
+     * "incomingCpu" hands every Internet client to a server placed on the CPU that received it (SO_INCOMING_CPU).
+     * Returns false if the servers are already running, in which case nothing is changed */
+    bool setPlacement(PlacementPolicy policy, bool incomingCpu);
+
+    /* Replaces the strategy choosing the server of every new client. Can be called at any time, from any thread */
+    void setBalancingStrategy(AbstractBalancingStrategy strategy);
+
+    /* Prints every server along with its load and stats, read from the memory shared with it. Can be called from any
+     * thread */
+    void listServers();
+
+    inline bool isStarted() const { return started; }
+
+    inline const std::vector<ServerHandle> &getServers() { return servers; }
+
+    inline int getServerPidAtIdx(int idx) const { return servers[idx].pid; }
+
+    inline int getServerIdAtIdx(int idx) const { return servers[idx].id; }
 
     inline std::string serverIdToPipePath(int idx) const { return startPipePath + std::to_string(idx); }
 
@@ -52,24 +165,152 @@ class Dispatcher : public Listener {
     /* Listens for user input in a REPL, triggering requested commands until requested to stop */
     void cliInputHandler(std::stop_token token);
 
-    /* Spins up another server process and populates serverPids with the newly created PID */
+    /* Spins up a server process with a new ID and adds it to the pool */
     void startServer();
 
-    /* Finds a suitable server for an incoming client connection and forwards it to the appropriate process */
+    /* Spins up a server with ID "serverId", respawned "restarts" times before, and adds it to the pool. Returns false
+     * if the server couldn't be started */
+    bool spawnServer(int serverId, int restarts);
+
+    /* Starts the server of "spawnServer" on a thread of the dispatcher, publishing its load to "loadMonitor" and placed
+     * on "placementSlot" (-1 if not placed) */
+    bool spawnServerThread(int serverId, int restarts, ServerLoadMonitor loadMonitor, int placementSlot);
+
+    /* Returns the placement slot of a new server, -1 if the servers aren't placed */
+    int pickPlacementSlot();
+
+    /* Sets up the listeners "server" with ID "serverId" placed on "placementSlot" accepts clients from itself */
+    void prepareServer(Server &server, int serverId, int placementSlot);
+
+    /* Adds the started server "process" to the pool along with its "channel" and "loadMonitor", and sends it the
+     * latest response schema */
+    void addToPool(const ServerHandle &process, std::unique_ptr<ServerChannel> channel, ServerLoadMonitor loadMonitor);
+
+    /* Applies the pool changes requested since the last call and the ones of the autoscaler, and respawns the crashed
+     * servers that are due. Does nothing if the last call was less than "supervisionIntervalMs" ago */
+    void superviseServers();
+
+    /* Stops handing clients to the server with ID "serverId" and asks it to retire */
+    void retireServer(int serverId);
+
+    /* Queues the control message of type "type" followed by "payload" to the server "server" through "channel" and
+     * waits until it is written, unless the server is gone. "poolMutex" has to be held */
+    void sendControlMessage(ServerChannel &channel, const ServerHandle &server, ControlMessageType type,
+                            std::string_view payload = {});
+
+    /* Server taken out of the pool, along with the memory and channel shared with it */
+    struct RemovedServer {
+        ServerHandle process;
+        ServerLoadMonitor monitor;
+        std::unique_ptr<ServerChannel> channel;
+    };
+
+    /* Takes the server at "idx" out of the pool. "poolMutex" has to be held */
+    RemovedServer removeFromPool(size_t idx);
+
+    /* Handles the servers whose pidfd the latest poll reported as readable: crashed servers leave the pool right away
+     * and are queued for a respawn, retired servers are forgotten */
+    void handleExitedServers();
+
+    /* Reaps the exited server "server" and removes the files it may have left behind. Returns a description of how it
+     * exited */
+    std::string reapServer(const ServerHandle &server);
+
+    /* Accepts the pending connections of every ready listener and queues each client to the channel of the server
+     * chosen for it */
     void forwardIncomingConnections();
 
+    /* Returns the index of the server for the new client "clientFd": the one with the fewest clients among the servers
+     * placed on the CPU that received it if clients are steered to their incoming CPU, the balancing strategy's choice
+     * otherwise or if no server is placed there. "poolMutex" has to be held */
+    size_t pickServer(int clientFd);
+
+    /* Sends the client "clientFd" accepted by "listener" the address of the server at "serverIdx" and closes it */
+    void redirectClient(int clientFd, const ISocket &listener, size_t serverIdx);
+
+    /* Writes the messages queued to every server channel, all clients queued to a server since the last call costing a
+     * single write */
+    void flushServerChannels();
+
     /* inputToCommand maps user CLI inputs to their respective commands that hold command executors */
     InputToCommandMap inputToCommand;
 
     //-----------------------------------------------------------------------------------------------------------------------------
+    int initServerCount;
+
     int latestServerId = 0;
 
-    /* (TODO:to be deleted after introducing more balancing methods) variable tracking what is the index of a PID inside
-     * serverPids that last received a client connection request  */
-    int lastReceivingServerIdx = 0;
+    /* True once the server processes have been started */
+    bool started = false;
+
+    /* Configuration every server process is started with */
+    ServerConfig serverConfig;
+
+    /* How client sockets reach the servers, see HandoffTransport */
+    HandoffTransport handoffTransport = HandoffTransport::SOCKETPAIR;
+
+    /* How the kernel spreads Internet clients over the servers' SO_REUSEPORT sockets, NONE if the dispatcher accepts
+     * them. "inetFraming" is the framing of the Internet listener the servers take over */
+    ReusePortSteering reusePortSteering = ReusePortSteering::NONE;
+    FramingType inetFraming = FramingType::LINE;
+
+    /* True if clients are redirected to their server rather than handed over */
+    bool redirectClients = false;
+
+    /* How the servers run, and the servers running as threads by the eventfd standing in for their pidfd. A thread is
+     * declared after its server, so that it is joined before the server is destroyed */
+    WorkerMode workerMode = WorkerMode::PROCESS;
+    struct WorkerThread {
+        std::unique_ptr<Server> server;
+        std::jthread thread;
+    };
+    std::unordered_map<int, WorkerThread> workerThreads;
+
+    /* How the servers are placed on the CPUs and whether clients go to the server placed on the CPU that received them.
+     * "cpuPlacement" is only created along with the servers, once their number of reactors is known */
+    PlacementPolicy placementPolicy = PlacementPolicy::NONE;
+    bool steerToIncomingCpu = false;
+    std::unique_ptr<CpuPlacement> cpuPlacement;
+
+    /* Latest response schema, replayed to every newly started server unless it is still the default one */
+    SchemaDescriptor responseSchema;
+    std::string encodedResponseSchema;
+
+    /* Strategy choosing the server of every new client, fed by "serverLoads". Replaced at runtime by the CLI thread.
+     * "poolMutex" also guards changes to the pool of servers, which only the dispatcher's thread makes */
+    std::mutex poolMutex;
+    AbstractBalancingStrategy balancingStrategy = std::make_unique<RoundRobinStrategy>();
+
+    /* Pool changes requested by the CLI thread and the autoscaler, applied by the dispatcher's thread */
+    std::mutex poolChangesMutex;
+    int requestedServers = 0;
+    std::vector<int> serverIdsToRetire;
+    std::unique_ptr<Autoscaler> autoscaler;
+
+    /* Earliest time of the next supervision of the servers */
+    std::chrono::steady_clock::time_point nextSupervision;
+
+    /* Processes running the currently active servers */
+    std::vector<ServerHandle> servers;
+
+    /* Channel to the server at the same index of "servers", and whether the channel's pipe is watched for POLLOUT
+     * because it was full on the latest flush */
+    std::vector<std::unique_ptr<ServerChannel>> serverChannels;
+    std::vector<bool> channelOutputWatched;
+
+    /* Load published by the server at the same index of "servers" */
+    std::vector<ServerLoadMonitor> serverLoads;
+
+    /* Servers asked to retire, whose channel is kept open until they exit since a server would take it closing as a
+     * request to shut down right away */
+    std::vector<RemovedServer> retiringServers;
 
-    /* Pairs <ProcessId, ServerId> representing processes running the currently active servers */
-    // TODO: consider using pidfd instead of the pid for better safety
-    std::vector<std::pair<int, int>> servers;
+    /* Servers that exited without being asked to, respawned with the same ID once "respawnAt" is reached */
+    struct CrashedServer {
+        int id;
+        int restarts;
+        std::chrono::steady_clock::time_point respawnAt;
+    };
+    std::vector<CrashedServer> crashedServers;
 };
 } // namespace echo
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <sys/epoll.h>
+#include <vector>
+
+namespace echo {
+
+/* IO_URING is a completion-based data path of the server rather than a readiness backend, wherever readiness waiting is
+ * still needed with it (e.g dispatcher listeners), epoll is used */
+enum class EventLoopType { POLL, EPOLL, IO_URING, UNKNOWN };
+
+/* File descriptor reported as ready by an event loop. "events" always uses the poll(2) flags (POLLIN, POLLOUT, POLLHUP,
+ * POLLERR), no matter which backend produced it */
+struct ReadyEvent {
+    int fd;
+    uint32_t events;
+};
+
+class IEventLoop {
+  public:
+    virtual ~IEventLoop(){};
+
+    /* Starts watching "fd" for "events" */
+    virtual void add(int fd, uint32_t events) = 0;
+
+    /* Replaces the events watched on an already added "fd" with "events" */
+    virtual void modify(int fd, uint32_t events) = 0;
+
+    /* Stops watching "fd". Must be called before "fd" is closed */
+    virtual void remove(int fd) = 0;
+
+    /* Blocks for up to "timeoutMs" (-1 meaning indefinitely) and fills "ready" with the file descriptors that have
+     * pending events. Returns the number of ready file descriptors, -1 if interrupted by a signal, or throws an error if
+     * necessary */
+    virtual int wait(std::vector<ReadyEvent> &ready, int timeoutMs = -1) = 0;
+
+    /* Returns true if readiness is only reported on state changes, in which case every ready file descriptor has to be
+     * drained until EAGAIN */
+    virtual bool isEdgeTriggered() const = 0;
+};
+
+/* poll(2) backend. Every wait passes the whole watched set to the kernel and scans it for ready entries, so the cost is
+ * O(watched fds) per wakeup */
+class PollEventLoop : public IEventLoop {
+  public:
+    void add(int fd, uint32_t events) override;
+    void modify(int fd, uint32_t events) override;
+    void remove(int fd) override;
+    int wait(std::vector<ReadyEvent> &ready, int timeoutMs = -1) override;
+
+    inline bool isEdgeTriggered() const override { return false; }
+
+  private:
+    std::vector<struct pollfd> fdsToPoll;
+
+    /* Index of every watched fd inside "fdsToPoll" (-1 if not watched), indexed by the fd so removals don't need a
+     * search */
+    std::vector<int> fdToIdx;
+};
+
+/* epoll(7) backend. Only the ready file descriptors are returned by the kernel, so the cost is O(ready fds) per wakeup */
+class EpollEventLoop : public IEventLoop {
+  public:
+    EpollEventLoop(bool edgeTriggered);
+    ~EpollEventLoop();
+    EpollEventLoop(const EpollEventLoop &) = delete;
+    EpollEventLoop &operator=(const EpollEventLoop &) = delete;
+
+    void add(int fd, uint32_t events) override;
+    void modify(int fd, uint32_t events) override;
+    void remove(int fd) override;
+    int wait(std::vector<ReadyEvent> &ready, int timeoutMs = -1) override;
+
+    inline bool isEdgeTriggered() const override { return edgeTriggered; }
+
+  private:
+    void control(int operation, int fd, uint32_t events);
+
+    int epollFd;
+    const bool edgeTriggered;
+    std::vector<struct epoll_event> epollEvents;
+};
+
+using AbstractEventLoop = std::unique_ptr<IEventLoop>;
+
+class EventLoopFactory {
+  public:
+    /* Returns a new event loop of "type". Edge triggering is only honored by backends that support it */
+    static AbstractEventLoop createEventLoop(EventLoopType type, bool edgeTriggered = false);
+
+    /* Returns the event loop type matching "choice" (e.g POLL), or UNKNOWN if there is no such type */
+    static EventLoopType getEventLoopType(const std::string &choice);
+};
+} // namespace echo
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <vector>
+
+namespace echo {
+
+/* Minimal io_uring instance talking to the kernel through raw syscalls. It owns the submission/completion rings and an
+ * optional ring of provided buffers used by multishot receives (requires Linux 6.0 or higher) */
+class IoUring {
+  public:
+    IoUring(unsigned entries);
+    ~IoUring();
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    /* Returns a cleared submission queue entry, submitting the already queued ones first if the queue is full */
+    struct io_uring_sqe *getSqe();
+
+    /* Submits all queued entries and waits until at least "waitNr" completions are available. Returns the number of
+     * submitted entries, -1 if interrupted by a signal, or throws an error if necessary */
+    int submitAndWait(unsigned waitNr);
+
+    /* Calls "handler" for every available completion queue entry, marking them as seen. Returns the number of handled
+     * entries */
+    template <typename F> unsigned forEachCompletion(F handler);
+
+    /* Registers a ring of "count" provided buffers of "size" bytes under "groupId" or throws an error if necessary */
+    void registerBufferRing(uint16_t groupId, unsigned count, unsigned size);
+
+    /* Returns the provided buffer "bufferId" picked by the kernel for a completed receive */
+    inline char *getBuffer(uint16_t bufferId) { return &bufferMemory[static_cast<size_t>(bufferId) * bufferSize]; }
+
+    /* Gives "bufferId" back to the kernel. Recycled buffers become visible to the kernel on the next commit */
+    void recycleBuffer(uint16_t bufferId);
+
+    /* Publishes all buffers recycled since the previous commit */
+    void commitBuffers();
+
+    inline uint16_t getBufferGroupId() const { return bufferGroupId; }
+
+    inline unsigned getBufferSize() const { return bufferSize; }
+
+    /* Queues a multishot poll for "events" on "fd" tagged with "userData" */
+    void preparePollMultishot(int fd, uint32_t events, uint64_t userData);
+
+    /* Queues a multishot receive on "fd" picking its buffers from the registered buffer ring */
+    void prepareRecvMultishot(int fd, uint64_t userData);
+
+    /* Queues a send of "len" bytes from "data" to "fd". "data" has to stay valid until the completion arrives */
+    void prepareSend(int fd, const void *data, size_t len, uint64_t userData);
+
+    /* Queues the cancellation of the request tagged with "targetUserData" */
+    void prepareCancel(uint64_t targetUserData, uint64_t userData);
+
+  private:
+    int ringFd;
+
+    /* Submission ring */
+    void *sqRingPtr;
+    size_t sqRingSize;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned *sqArray;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    unsigned sqeTail = 0;
+
+    /* Completion ring (shares the submission ring mapping when the kernel supports it) */
+    void *cqRingPtr;
+    size_t cqRingSize;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe *cqes;
+
+    /* Provided buffer ring */
+    struct io_uring_buf *bufferRing = nullptr;
+    size_t bufferRingSize = 0;
+    unsigned bufferRingMask = 0;
+    uint16_t bufferRingTail = 0;
+    uint16_t bufferGroupId = 0;
+    unsigned bufferSize = 0;
+    std::vector<char> bufferMemory;
+};
+
+template <typename F> unsigned IoUring::forEachCompletion(F handler) {
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    unsigned handled = 0;
+
+    for (; head != tail; head++, handled++) {
+        handler(cqes[head & cqMask]);
+    }
+
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    return handled;
+}
+} // namespace echo
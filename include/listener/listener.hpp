@@ -1,13 +1,20 @@
 #pragma once
 
+#include "listener/event_loop.hpp"
 #include "socket/socket.hpp"
-#include <sys/poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
 #include <vector>
 
 namespace echo {
 
+/* Default length of the queue of connections waiting to be accepted by a listener socket. The kernel caps it to
+ * net.core.somaxconn */
+const int defaultListenBacklog = SOMAXCONN;
+
 class Listener {
   public:
+    Listener(EventLoopType eventLoopType = EventLoopType::POLL) : eventLoopType(eventLoopType){};
     virtual ~Listener();
 
     /* Sets up the "listener" and adds it to the tracked socket state */
@@ -15,24 +22,51 @@ class Listener {
 
     inline const std::vector<AbstractSocket> &getListenerPool() const { return listenerPool; }
 
+    inline EventLoopType getEventLoopType() const { return eventLoopType; }
+
+    /* Sets the backlog of the listener sockets, which only takes effect if they aren't prepared yet */
+    inline void setListenBacklog(int backlog) { listenBacklog = backlog; }
+
+    /* Raises the soft limit of open file descriptors of the process to "wanted", or as close to it as the hard limit
+     * allows. The limit is never lowered */
+    static void raiseOpenFileLimit(rlim_t wanted);
+
   protected:
     //-----------------------------------------------------------------------------------------------------------------------------
-    /* Prepares listener sockets inside the listener pool */
+    /* Prepares listener sockets inside the listener pool and registers them with the listener event loop */
     void prepareListenerSockets();
 
-    /* Polls all file descriptors from pollFds, returning the number of file descriptors with events or throwing an
-     * error if necessary */
-    int pollListenerSockets();
+    /* Makes the bound "listener" listen for connections with a non-blocking accept, or throws an error if necessary */
+    void startListening(ISocket &listener);
+
+    /* Closes every listener socket (removing the files of Unix domain ones) and empties the listener pool. Sockets have
+     * to be removed from the event loops watching them first */
+    void closeListenerSockets();
+
+    /* Waits up to "timeoutMs" (-1 meaning indefinitely) for events on the listener sockets, filling "readyListeners"
+     * and returning the number of listeners with events (-1 if interrupted) or throwing an error if necessary */
+    int pollListenerSockets(int timeoutMs = -1);
+
+    /* Returns the listener whose socket is "fd", or nullptr if there is no such listener */
+    ISocket *findListener(int fd) const;
 
     /* Finds a suitable server for an incoming client connection and forwards it to the appropriate process */
     void forwardIncomingConnection();
 
     //-----------------------------------------------------------------------------------------------------------------------------
 
+    /* Backend used to wait for events on the listener sockets */
+    EventLoopType eventLoopType;
+
+    int listenBacklog = defaultListenBacklog;
+
     /* Sockets listening for requests */
     std::vector<AbstractSocket> listenerPool;
 
-    /* listener fds to poll for events */
-    std::vector<struct pollfd> listenerFds;
+    /* Event loop watching the listener sockets (created once the listeners are prepared) */
+    AbstractEventLoop listenerEventLoop;
+
+    /* Listener sockets reported as ready by the latest poll */
+    std::vector<ReadyEvent> readyListeners;
 };
-} // namespace echo
\ No newline at end of file
+} // namespace echo
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "listener/connection.hpp"
+#include "listener/connection_table.hpp"
+#include "listener/event_loop.hpp"
+#include "listener/io_uring.hpp"
+#include "listener/response_schema.hpp"
+#include "listener/server_config.hpp"
+#include "socket/buffer_pool.hpp"
+
+namespace echo {
+
+class Server;
+
+/* Event loop of a server thread. Every client connection belongs to exactly one reactor, which does all of the
+ * connection's I/O and runs the response schema on its messages, so connection state is never shared between threads */
+class Reactor {
+  public:
+    /* Reactor number "idx" of "server". The first one also watches the dispatcher->server pipe of the server, and the
+     * listeners the server accepts clients from itself if it has any */
+    Reactor(Server &server, const ServerConfig &config, size_t idx);
+    ~Reactor();
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    /* Runs the reactor on the calling thread until "stop" is called or the server shuts down, or throws an error if
+     * necessary */
+    void run();
+
+    /* Makes "run" return as soon as possible. Can be called from any thread */
+    void stop();
+
+    /* Stops watching the server's listener socket "fd", which can be closed right after. Has to be called on the
+     * reactor's thread */
+    void stopWatching(int fd);
+
+    /* Hands the client socket "clientFd" speaking "framing" over to the reactor. Can be called from any thread */
+    void enqueueClient(int clientFd, FramingType framing);
+
+    /* Number of clients currently served by the reactor or waiting to be added to it. Can be called from any thread */
+    inline size_t getClientCount() const { return clientCount.load(std::memory_order_relaxed); }
+
+    /* Occupancy of the reactor's buffer pool. Can be called from any thread */
+    inline BufferPoolStats getBufferPoolStats() const { return bufferPool.getStats(); }
+
+  private:
+    //-----------------------------------------------------------------------------------------------------------------------------
+    /* Runs the POLL/EPOLL data path until stopped */
+    void runEventLoop();
+
+    /* Runs the IO_URING data path until stopped: every iteration submits all queued requests (receive re-arms and
+     * batched sends) and reaps completions with a single io_uring_enter */
+    void runCompletionLoop();
+
+    /* Returns true once the reactor should stop running */
+    bool isStopRequested() const;
+
+    /* Adds every client handed over by "enqueueClient" to the data path */
+    void drainHandoffQueue();
+
+    /* Registers the client socket "clientFd" speaking "framing" with the data path of the reactor */
+    void addClient(int clientFd, FramingType framing);
+
+    /* Publishes the reactor's share of the server's load and its stats, including the latency of the batch of work that
+     * started at "batchStart" */
+    void publishLoad(std::chrono::steady_clock::time_point batchStart);
+
+    /* Picks up the server's response schema if it changed since the last call */
+    void refreshResponseSchema();
+
+    /* Goes over all ready file descriptors and handles incoming data if there is any */
+    void handleIncomingData();
+
+    /* Receives everything available from "connection" and queues the responses to it, closing the connection if the
+     * client is done */
+    void handleClientData(Connection &connection);
+
+    /* Responds to every complete frame buffered in "connection", in place where the schema allows it, and queues the
+     * responses without copying them. Returns false if the client broke the framing and the connection should be closed
+     */
+    bool processFrames(Connection &connection);
+
+    /* Sends as much of the pending output of "connection" as the socket accepts, gathering several blocks per sendmsg,
+     * and updates the watched events accordingly. Returns false if the client is gone and the connection has been
+     * closed, or the connection is closing and only waits for its output to drain */
+    bool flushOutput(Connection &connection);
+
+    /* Drops the unsent output of "connection", whose client is gone or broke the framing, and closes it as soon as the
+     * kernel is done with its zero-copy sends */
+    void abandonClient(Connection &connection);
+
+    /* Closes the closing "connection" once all of its output is sent and all of its zero-copy sends are complete,
+     * otherwise keeps watching it until they are. Returns true if it has been closed */
+    bool closeClientIfDone(Connection &connection);
+
+    /* Watches POLLIN unless reading is paused or the connection is closing, and POLLOUT only while output is pending */
+    void updateWatchedEvents(Connection &connection);
+
+    /* Reads the zero-copy completion notifications of "connection" from its socket error queue */
+    void drainZeroCopyCompletions(Connection &connection);
+
+    /* Receives up to "size" bytes from "clientFd" and returns number of bytes read (0 if the client is gone), -1 if
+     * there is nothing left to read, or throws an error if necessary */
+    int receiveFromClient(int clientFd, char *buffer, size_t size);
+
+    /* Closes the socket "clientFd" and removes it from tracked client socket state  */
+    void closeClientConnection(int clientFd);
+
+    /* Handles a single completion of the IO_URING data path */
+    void handleCompletion(const struct io_uring_cqe &cqe);
+
+    /* Starts sending the output queued to "connection" in the IO_URING data path, pausing its receive past the
+     * high-water mark */
+    void submitUringQueuedOutput(Connection &connection);
+
+    /* Hands the front output of "connection" to the kernel unless a send to that client is already in flight */
+    void submitUringSend(Connection &connection);
+
+    /* Closes "connection" in the IO_URING data path once the kernel no longer holds any request on it */
+    void closeUringClientIfDone(Connection &connection);
+
+    //-----------------------------------------------------------------------------------------------------------------------------
+    Server &server;
+    EventLoopType eventLoopType;
+    size_t idx;
+    bool watchPipe;
+
+    /* eventfd signalled by other threads when a client is handed over or the reactor should stop */
+    int wakeFd;
+
+    std::atomic<bool> stopRequested = false;
+
+    /* Clients handed over by other threads, waiting to be added to the data path */
+    std::mutex handoffMutex;
+    std::vector<std::pair<int, FramingType>> handoffQueue;
+
+    std::atomic<size_t> clientCount = 0;
+
+    /* Reactor's snapshot of the server's response schema and the version it was taken at */
+    std::shared_ptr<IResponseSchema> responseSchema;
+    uint64_t responseSchemaVersion = 0;
+
+    /* Event loop watching the wake fd, the pipe and the server's listeners (if watched) and the sockets of the
+     * reactor's clients. When it is edge-triggered, every ready fd is drained until EAGAIN */
+    AbstractEventLoop eventLoop;
+
+    /* File descriptors reported as ready by the latest poll */
+    std::vector<ReadyEvent> readyFds;
+
+    /* Pool of the receive and output buffers of the reactor's connections. Declared before them so it outlives them */
+    BufferPool bufferPool;
+
+    /* Buffer pool usage last added to the server's load */
+    int64_t publishedBufferedBytes = 0;
+
+    /* Traffic since the stats were last published */
+    uint64_t unpublishedMessages = 0;
+    uint64_t unpublishedBytesReceived = 0;
+    uint64_t unpublishedBytesSent = 0;
+
+    /* State of every client of the reactor, indexed by its socket */
+    ConnectionTable connections;
+
+    /* io_uring instance driving the data path in IO_URING mode. It is created by "run", since the ring has to be used
+     * by the thread that created it */
+    std::unique_ptr<IoUring> ring;
+};
+} // namespace echo
@@ -1,40 +1,140 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "listener/blocklist.hpp"
+#include "listener/schema_kernels.hpp"
 
 namespace echo {
 
+/* Rules turning a message into its response. A schema is shared by every reactor of a server and never changes once
+ * made, so responses are generated through const methods */
 class IResponseSchema {
   public:
     virtual ~IResponseSchema(){};
 
-    /* Modifies "message" based on the rules of the concrete schema */
-    virtual void generateResponse(std::string &message) = 0;
+    /* Writes the response to "message" into "response" and returns its length. "response" either starts at the same
+     * byte as "message", to respond in place, or doesn't overlap it, and holds at least
+     * getMaxResponseSize(message.size()) bytes. Writes nothing anywhere else and allocates nothing */
+    virtual size_t writeResponse(std::span<const char> message, std::span<char> response) const = 0;
+
+    /* Returns the longest response to a message of "messageSize" bytes. Schemas whose responses are never longer than
+     * their message can respond in place */
+    virtual size_t getMaxResponseSize(size_t messageSize) const { return messageSize; }
+
+    /* Replaces "message" with its response (the string interface of the schemas, built on "writeResponse") */
+    void generateResponse(std::string &message) const;
 };
 
-enum class SchemaType { EQUIVALENT, REVERSE, CENSORED, PALINDROME, UNKNOWN };
+enum class SchemaType { EQUIVALENT, REVERSE, CENSORED, PALINDROME, BLOCKLIST, PIPELINE, UNKNOWN };
 
 class EquivalentResponseSchema : public IResponseSchema {
   public:
-    void generateResponse(std::string &message) override;
+    size_t writeResponse(std::span<const char> message, std::span<char> response) const override;
 };
 
+/* Reverses messages with the fastest kernel the CPU supports, picked when the first schema is made */
 class ReverseResponseSchema : public IResponseSchema {
   public:
-    void generateResponse(std::string &message) override;
+    ReverseResponseSchema() : reverse(getReverseKernel()){};
+    size_t writeResponse(std::span<const char> message, std::span<char> response) const override;
+
+  private:
+    const ReverseKernel reverse;
 };
 
+/* Removes every censored character from messages in a single pass, or replaces it with "mask" if there is one, with
+ * the fastest kernels the CPU supports */
 class CensoredResponseSchema : public IResponseSchema {
   public:
-    CensoredResponseSchema(const char censored) : censoredChar(censored){};
-    void generateResponse(std::string &message) override;
+    CensoredResponseSchema(const char censored) : CensoredResponseSchema(std::string_view(&censored, 1)){};
+    CensoredResponseSchema(std::string_view censoredChars, std::optional<char> mask = std::nullopt)
+        : table(censoredChars), mask(mask), censor(getCensorKernel()), maskCensored(getMaskKernel()){};
+    size_t writeResponse(std::span<const char> message, std::span<char> response) const override;
 
   private:
-    const char censoredChar;
+    const CensorTable table;
+    const std::optional<char> mask;
+    const CensorKernel censor;
+    const MaskKernel maskCensored;
 };
 
+/* Tells whether messages are palindromes, ignoring case and all but letters and digits */
 class PalindromeResponseSchema : public IResponseSchema {
   public:
-    void generateResponse(std::string &message) override;
+    size_t writeResponse(std::span<const char> message, std::span<char> response) const override;
+    size_t getMaxResponseSize(size_t messageSize) const override;
+};
+
+/* Removes every blocked word from messages, or replaces its characters with "mask" if there is one. The automaton is
+ * read only, so every reactor of the server shares the schema */
+class BlocklistResponseSchema : public IResponseSchema {
+  public:
+    BlocklistResponseSchema(BlocklistAutomaton automaton, std::optional<char> mask = std::nullopt)
+        : automaton(std::move(automaton)), mask(mask){};
+    size_t writeResponse(std::span<const char> message, std::span<char> response) const override;
+
+  private:
+    const BlocklistAutomaton automaton;
+    const std::optional<char> mask;
+};
+
+/* Byte-wise stages (EQUIVALENT, REVERSE and CENSORED, every byte of whose response depends on a single byte of the
+ * message) composed into one: what every byte value turns into, and whether the bytes end up reversed. Reversing
+ * commutes with the other byte-wise stages, so only whether an odd number of stages reverse matters */
+struct ByteStages {
+    /* Outcome of the byte values a stage removes */
+    static constexpr int16_t removedByte = -1;
+
+    /* Outcome of every byte value, the byte it turns into or "removedByte" */
+    std::array<int16_t, 256> outcomes;
+    bool reverses = false;
+
+    /* No stage, every byte staying itself */
+    ByteStages();
+
+    inline void appendReverse() { reverses = !reverses; }
+
+    /* Appends a stage removing the bytes of "censoredChars", or replacing them with "mask" if there is one */
+    void appendCensor(std::string_view censoredChars, std::optional<char> mask);
+};
+
+/* Runs composed byte-wise stages in a single pass over the message. Compositions removing one set of bytes and
+ * masking another with a single character (any run of CENSORED stages masking with the same character, and of
+ * REVERSE) run the fused kernel specialized for them, others a lookup of the outcome of every byte */
+class FusedResponseSchema : public IResponseSchema {
+  public:
+    explicit FusedResponseSchema(const ByteStages &stages);
+    size_t writeResponse(std::span<const char> message, std::span<char> response) const override;
+
+  private:
+    const ByteStages stages;
+    const ReverseKernel reverse;
+    FusedCensorTables tables;
+
+    /* Kernel of the composition, or nullptr if it needs the lookup */
+    FusedKernel kernel = nullptr;
+};
+
+/* Runs schemas one after the other, every stage responding to the response of the previous one. The factory fuses
+ * consecutive byte-wise stages into a FusedResponseSchema, so that only the stages it can't fuse (PALINDROME and
+ * BLOCKLIST, which look at more than a byte at a time) take a pass of their own */
+class PipelineResponseSchema : public IResponseSchema {
+  public:
+    PipelineResponseSchema(std::vector<std::unique_ptr<IResponseSchema>> stages) : stages(std::move(stages)){};
+    size_t writeResponse(std::span<const char> message, std::span<char> response) const override;
+    size_t getMaxResponseSize(size_t messageSize) const override;
+
+  private:
+    const std::vector<std::unique_ptr<IResponseSchema>> stages;
 };
 } // namespace echo
\ No newline at end of file
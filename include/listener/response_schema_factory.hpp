@@ -1,7 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 
+#include "listener/schema_descriptor.hpp"
 #include "listener/server.hpp"
 
 namespace echo {
@@ -11,10 +13,45 @@ class ResponseSchemaFactory {
     /* Returns appropriate response schema based on the schema type and arguments provided in "tokens" */
     AbstractResponseSchema createSchema(const AbstractTokens &tokens);
 
+    /* Returns the response schema described by "descriptor", or nullptr if its argument doesn't suit its type */
+    AbstractResponseSchema createSchema(const SchemaDescriptor &descriptor);
+
+    /* Compiles the schema type and arguments provided in "tokens" into a descriptor (of version 0). Returns
+     * std::nullopt if they don't describe a schema */
+    std::optional<SchemaDescriptor> compileDescriptor(const AbstractTokens &tokens);
+
   private:
+    /* Returns the censored schema of a descriptor "argument" compiled by "compileCensoredArgument", or nullptr if it
+     * isn't one */
+    AbstractResponseSchema createCensoredSchema(const std::string &argument);
+
+    /* Compiles the arguments of a censored schema, "CHAR=c" or "CHARS=" followed by characters and ranges (e.g
+     * "CHARS=a-z0-9_") optionally followed by "MASK=c" to replace the censored characters with "c" rather than remove
+     * them, into its descriptor argument: the distinct censored characters, then a NUL byte and the mask if masking.
+     * Returns std::nullopt if they are malformed */
+    std::optional<std::string> compileCensoredArgument(const std::string &charsArgument,
+                                                       const std::string &maskArgument);
+
+    /* Returns the blocklist schema of a descriptor "argument" compiled by "compileBlocklistArgument", or nullptr if it
+     * isn't one or its file can't be loaded */
+    AbstractResponseSchema createBlocklistSchema(const std::string &argument);
+
+    /* Compiles the arguments of a blocklist schema, "FILE=path" optionally followed by "MASK=c", into its descriptor
+     * argument: the absolute path of the blocklist, then a NUL byte and the mask if masking. Returns std::nullopt if
+     * they are malformed or the file doesn't hold a blocklist */
+    std::optional<std::string> compileBlocklistArgument(const std::string &fileArgument,
+                                                        const std::string &maskArgument);
+
+    /* Returns the pipeline schema of a descriptor "argument" compiled by "compilePipelineArgument", with its
+     * consecutive byte-wise stages fused, or nullptr if it isn't one or a stage can't be made */
+    AbstractResponseSchema createPipelineSchema(const std::string &argument);
+
+    /* Compiles the stages of a pipeline schema, separated by ',' and each a schema type followed by its arguments
+     * separated by ':' (e.g "CENSORED:CHARS=a-z:MASK=*,REVERSE"), into its descriptor argument: the descriptor of every
+     * stage prefixed with its size. Returns std::nullopt if a stage is malformed or a pipeline itself */
+    std::optional<std::string> compilePipelineArgument(const std::string &stagesArgument);
+
     /* Returns schema type based on the "choice" string (reduces number of string comparisons in the factory) */
     SchemaType getSchemaType(const std::string &choice);
-
-    std::unique_ptr<CensoredResponseSchema> newCensoredSchema(const AbstractTokens &tokens);
 };
 } // namespace echo
\ No newline at end of file
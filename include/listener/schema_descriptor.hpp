@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "listener/response_schema.hpp"
+
+namespace echo {
+
+/* Compact binary description of a response schema, compiled once by the dispatcher from the command choosing it and
+ * sent to every server, which builds the schema from it without parsing anything. "argument" holds the configuration of
+ * the schema in a form of its own (e.g the censored character), and "version" orders the schema changes of the
+ * dispatcher, 0 being the default schema servers start with */
+struct SchemaDescriptor {
+    uint64_t version = 0;
+    SchemaType type = SchemaType::EQUIVALENT;
+    std::string argument;
+
+    /* Returns the version, the type and the argument packed into bytes */
+    std::string encode() const;
+
+    /* Unpacks bytes produced by "encode". Returns std::nullopt if they don't hold a descriptor */
+    static std::optional<SchemaDescriptor> decode(std::string_view bytes);
+};
+} // namespace echo
\ No newline at end of file
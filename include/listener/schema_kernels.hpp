@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace echo {
+
+/* Widest vector instructions a kernel may use, ordered so that a CPU supporting a level supports every lower one */
+enum class SimdLevel {
+    SCALAR, // plain C++, runs anywhere
+    SSSE3,  // 128 bit byte shuffles
+    AVX2    // 256 bit byte shuffles
+};
+
+/* Returns the highest level the CPU supports, read from CPUID once */
+SimdLevel detectSimdLevel();
+
+/* Returns a printable name of "level" */
+const char *getSimdLevelName(SimdLevel level);
+
+/* Reverses the "size" bytes of "data" in place */
+using ReverseKernel = void (*)(char *data, size_t size);
+
+/* Returns the reverse kernel of "level", which must not be above the level the CPU supports */
+ReverseKernel getReverseKernel(SimdLevel level);
+
+/* Returns the fastest reverse kernel the CPU supports */
+ReverseKernel getReverseKernel();
+
+/* Set of censored bytes, laid out as the tables the censor kernels look bytes up in */
+struct CensorTable {
+    /* An empty set */
+    CensorTable() = default;
+
+    /* Builds the tables of the bytes in "chars" (in any order, repeats allowed) */
+    explicit CensorTable(std::string_view chars);
+
+    inline bool contains(char c) const {
+        auto byte = static_cast<uint8_t>(c);
+        return (bitmap[byte / 64] >> (byte % 64)) & 1;
+    }
+
+    /* Bit of every censored byte value, for the scalar kernels */
+    uint64_t bitmap[4] = {};
+
+    /* Nibble tables of the vector kernels, which look a byte's low nibble up in "lowNibbleBits" (the first table for
+     * bytes below 0x80, the second for the others) and find the byte censored if the result has bit "high nibble % 8"
+     * set. Exact for any set, unlike a single pair of nibble tables */
+    alignas(16) uint8_t lowNibbleBits[2][16] = {};
+};
+
+/* Removes the bytes of "table" from the "size" bytes of "data" in place, keeping the order of the others. Returns the
+ * number of bytes left */
+using CensorKernel = size_t (*)(const CensorTable &table, char *data, size_t size);
+
+/* Replaces the bytes of "table" among the "size" bytes of "data" with "mask" */
+using MaskKernel = void (*)(const CensorTable &table, char mask, char *data, size_t size);
+
+/* Returns the censor kernel of "level", which must not be above the level the CPU supports */
+CensorKernel getCensorKernel(SimdLevel level);
+
+/* Returns the fastest censor kernel the CPU supports */
+CensorKernel getCensorKernel();
+
+/* Returns the mask kernel of "level", which must not be above the level the CPU supports */
+MaskKernel getMaskKernel(SimdLevel level);
+
+/* Returns the fastest mask kernel the CPU supports */
+MaskKernel getMaskKernel();
+
+/* Byte-wise stages of a pipeline composed into one: the bytes of "removed" are dropped and those of "masked" replaced
+ * with "mask". No byte is in both */
+struct FusedCensorTables {
+    CensorTable removed;
+    CensorTable masked;
+    char mask = '\0';
+};
+
+/* Drops and masks the bytes of "tables" among the "size" bytes of "in" in a single pass, writing the others to "out"
+ * (reversed for the kernels that reverse), which is either "in" or doesn't overlap it and holds "size" bytes. Returns
+ * the number of bytes written */
+using FusedKernel = size_t (*)(const FusedCensorTables &tables, const char *in, size_t size, char *out);
+
+/* Returns the fused kernel of "level" specialized for whether it removes bytes, masks bytes and reverses them. "level"
+ * must not be above the level the CPU supports */
+FusedKernel getFusedKernel(SimdLevel level, bool removes, bool masks, bool reverses);
+
+/* Returns the fastest fused kernel the CPU supports, specialized the same way */
+FusedKernel getFusedKernel(bool removes, bool masks, bool reverses);
+} // namespace echo
\ No newline at end of file
@@ -1,98 +1,194 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <poll.h>
+#include <span>
 #include <stop_token>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include "CLI/cli_command.hpp"
 #include "listener/listener.hpp"
+#include "listener/reactor.hpp"
 #include "listener/response_schema.hpp"
+#include "listener/server_channel.hpp"
+#include "listener/server_config.hpp"
+#include "listener/server_load.hpp"
 #include "socket/socket.hpp"
 
 namespace echo {
 
-const std::byte newClientFdPipeFlag = std::byte(0x01);
-const std::byte commandPipeFlag = std::byte(0x02);
-
 using ResponseSchemaCliCommand = ChangeResponseSchemaCliCommand;
 using AbstractResponseSchema = std::unique_ptr<IResponseSchema>;
 
 //-----------------------------------------------------------------------------------------------------------------------------
 class Server : public Listener {
   public:
-    Server(std::string pipeName);
+    /* Receives clients and commands from the dispatcher through the FIFO at "pipeName", which has to exist already */
+    Server(std::string pipeName, const ServerConfig &config = ServerConfig());
+
+    /* Receives clients and commands from the dispatcher through "channelFd", the server's end of a SOCK_SEQPACKET
+     * socketpair, with client sockets attached as SCM_RIGHTS */
+    Server(int channelFd, const ServerConfig &config = ServerConfig());
+
+    /* Runs as a thread of the dispatcher, receiving clients and commands through "pipe". Signals are left to the
+     * dispatcher, which stops the server itself */
+    Server(std::shared_ptr<InProcessPipe> pipe, const ServerConfig &config = ServerConfig());
     ~Server();
     Server(const Server &) = delete;
     void operator=(const Server &) = delete;
-    Server(Server &&) = default;
+    Server(Server &&) = delete;
     Server &operator=(Server &&) = delete;
 
     static void signalHandler(int signum);
 
-    /* Sets up the socket listeners and starts the polling process with appropriate stopping handlers  */
+    /* Returns true once the server process has been asked to terminate */
+    static bool isShutdownRequested();
+
+    /* Starts the reactor threads and runs the first reactor on the calling thread until shutdown. Rethrows the error of
+     * the first reactor that failed, once all of them stopped */
     void start();
 
-    inline void setResponseSchema(AbstractResponseSchema schema) { responseSchema = std::move(schema); };
+    /* Makes "start" return as soon as possible. Can be called from any thread */
+    void stop();
 
-    inline const AbstractResponseSchema &getResponseSchema() const { return responseSchema; }
+    /* Replaces the response schema shared by all reactors. Reactors pick it up before processing their next read, while
+     * messages already being processed finish with the previous schema */
+    void setResponseSchema(AbstractResponseSchema schema);
 
-    inline const std::vector<int> &getClientPool() const { return clientPool; }
+    /* Returns the current response schema. Can be called from any thread */
+    std::shared_ptr<IResponseSchema> getResponseSchema() const;
 
-    inline const struct pollfd &getPipePollFd() const { return fdsToPoll[0]; }
+    /* Incremented on every response schema change, so reactors only lock when the schema actually changed */
+    inline uint64_t getResponseSchemaVersion() const { return responseSchemaVersion.load(std::memory_order_acquire); }
 
-    inline const int getClientFdStartIdx() const { return 1; }
+    /* Number of clients currently connected to the server across all reactors */
+    size_t getClientCount() const;
 
-  private:
-    //-----------------------------------------------------------------------------------------------------------------------------
-    void handleClientData(int clientIdx);
+    /* Occupancy of the buffer pools of all reactors */
+    BufferPoolStats getBufferPoolStats() const;
+
+    inline int getReactorCount() const { return reactors.size(); }
 
-    /* polls the "fdsToPoll", returning the number of ready fds or throws an error if necessary  */
-    int pollFileDescriptors();
+    /* Makes the reactors publish the load and stats of the server to "sharedBlock" (e.g memory shared with the
+     * dispatcher) instead of keeping them to the server, and the server take its commands out of its ring. Has to be
+     * called before "start" */
+    inline void shareControlBlock(ServerControlBlock &sharedBlock) { controlBlock = &sharedBlock; }
 
-    /* accepts incoming client connections from the pipe if there are any pending */
+    /* Live load of the server, updated by its reactors */
+    inline ServerLoad &getLoad() const { return controlBlock->load; }
+
+    /* Version of the response schema descriptor the server switched to last, see SchemaDescriptor */
+    inline uint64_t getSchemaDescriptorVersion() const {
+        return controlBlock->schemaVersion.load(std::memory_order_acquire);
+    }
+
+    /* Stats slot of the reactor at "reactorIdx" */
+    inline ReactorStats &getReactorStats(size_t reactorIdx) const {
+        return controlBlock->reactorStats[reactorIdx % statsSlotCount];
+    }
+
+    inline int getPipeFd() const { return pipeFd; }
+
+    /* Makes the server accept the clients of "listener" itself, next to the ones handed over by the dispatcher (e.g a
+     * SO_REUSEPORT socket the kernel balances between the servers, or the server's own address clients are redirected
+     * to). Binds and starts listening on it, or throws an error if necessary. Has to be called before "start" */
+    void acceptClientsFrom(AbstractSocket listener);
+
+    /* accepts incoming client connections and commands from the pipe if there are any pending. Called by the reactor
+     * watching the pipe */
     void acceptPipeData();
 
-    /* Goes over all listeners and handles incoming data if there is any */
-    void handleIncomingData();
+    /* Stops taking new clients: the server's own listeners are closed, while clients the dispatcher handed over before
+     * asking the server to retire are still served. The server stops once it has no clients left. Has to be called on
+     * the thread of the reactor watching the pipe */
+    void retire();
+
+    inline bool isRetiring() const { return retiring.load(std::memory_order_relaxed); }
+
+    /* Stops the reactors if the server is retiring and has no clients left. Can be called from any thread */
+    void stopIfDrained();
 
-    /* Receives data from socket of pollFdIdx and returns number of bytes read or throws an error if necessary, closing
-     * the connection to that socket */
-    int receiveFromClient(int pollFdIdx, char *buffer);
+    /* Accepts every connection pending on the server's own listener with socket "fd". Returns false if the server has
+     * no such listener. Called by the reactor watching the pipe */
+    bool acceptListenerClients(int fd);
 
-    /* Closes the socket of a client of id "pollFdIdx" and removes it from tracked client socket state  */
-    void closeClientConnection(int pollFdIdx);
+  private:
+    //-----------------------------------------------------------------------------------------------------------------------------
+    /* Hands the newly received client socket "clientFd" speaking "framing" over to the next reactor (round robin) */
+    void addClient(int clientFd, FramingType framing);
 
     /* Takes client socket "fd" of another process, duplicates it for current process and returns it, or throws an error
      * if necessary */
     int duplicateClientFd(int fd);
 
-    /* Takes a command without knowing its type (runtime command / startup command) and sets the response schema
-     * if it can be deduced from the command
-     *
-     * TODO: This is a bit hacky since it potentially tries all token types. Try to think of something better
-     */
-    void setResponseSchemaFromCommand(std::string command);
+    /* Carries out "message", taken out of the command ring (see ControlMessageType) */
+    void handleControlMessage(std::string_view message);
+
+    /* Creates the reactors of the server */
+    void createReactors(const ServerConfig &config);
+
+    /* Receives the packets waiting on the socketpair along with the client sockets attached to them */
+    void receiveChannelPackets();
 
-    /* Read "size" bytes into "dest" from the (dispatcher->server) pipe.
-     * Return bytes read. Throw a system error with "errorMsg" if necessary
-     */
-    template <typename T> ssize_t readPipe(T *dest, std::string errorMsg, ssize_t size = sizeof(T));
+    /* Takes every chunk of messages out of the ring of "inProcessPipe" */
+    void receiveRingChunks();
+
+    /* Handles every complete message among the first "size" bytes of "data" read from the pipe and returns the number
+     * of bytes they take up. Clients are taken from "fds" in order if the sockets were passed along with the messages,
+     * unused ones are closed */
+    size_t handlePipeMessages(const std::byte *data, size_t size, std::span<const int> fds = {});
 
     //-----------------------------------------------------------------------------------------------------------------------------
-    /* name of the pipe from which the server receives new client socket file descriptors from the dispatcher */
+    /* name of the pipe from which the server receives new client socket file descriptors from the dispatcher, empty
+     * when they are received through a socketpair */
     std::string pipeName;
 
-    /* Response schema dictates the way server is going to respond in */
-    AbstractResponseSchema responseSchema;
+    /* Response schema dictates the way server is going to respond in. Reactors hold on to the schema they use, so it is
+     * only destroyed once no reactor is using it anymore */
+    std::shared_ptr<IResponseSchema> responseSchema;
+    mutable std::mutex responseSchemaMutex;
+    std::atomic<uint64_t> responseSchemaVersion = 0;
+
+    /* dispatcher->server pipe (or socketpair) file descriptor */
+    int pipeFd;
+
+    /* True if client sockets arrive attached to the messages rather than as fd numbers to duplicate */
+    bool receivesFds = false;
+
+    /* Pipe of a server running as a thread of the dispatcher, whose doorbell is "pipeFd", or nullptr. Client fd
+     * numbers received through it are the server's own already */
+    std::shared_ptr<InProcessPipe> inProcessPipe;
+
+    /* Bytes read from the pipe, of which the first "pipeBufferSize" ones hold the start of a message that hasn't been
+     * fully read yet */
+    std::vector<std::byte> pipeBuffer;
+    size_t pipeBufferSize = 0;
+
+    /* pidfd of the dispatcher, opened on the first client handed over */
+    int parentPidFd = -1;
+
+    /* Reactors serving the clients of the server. The first one runs on the thread calling "start" and also watches the
+     * pipe */
+    std::vector<std::unique_ptr<Reactor>> reactors;
+
+    /* Index of the reactor that receives the next client */
+    size_t nextReactorIdx = 0;
+
+    /* True once the server was asked to retire */
+    std::atomic<bool> retiring = false;
+
+    /* Limit of clients served at once, see ServerConfig */
+    int maxClients;
 
-    /* clientPool contains client socket file descriptors of clients connected to this server */
-    std::vector<int> clientPool;
+    /* Where the load and stats of the server are published and its commands taken from, "ownControlBlock" unless shared
+     * with the dispatcher */
+    std::unique_ptr<ServerControlBlock> ownControlBlock = std::make_unique<ServerControlBlock>();
+    ServerControlBlock *controlBlock = ownControlBlock.get();
 
-    /* pollFds contains the file descriptors to poll with the following format:
-     * First element is the dispatcher->server pipe file descriptor.
-     * The rest of the elements are file descriptors of currently active clients on this server
-     */
-    std::vector<struct pollfd> fdsToPoll;
     //-----------------------------------------------------------------------------------------------------------------------------
 };
 } // namespace echo
\ No newline at end of file
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "listener/control_ring.hpp"
+#include "socket/framing.hpp"
+
+namespace echo {
+
+/* newClientFdPipeFlag is followed by the client fd and the FramingType of the listener that accepted it. Over a
+ * socketpair the fd number is meaningless, the client sockets of a packet are attached to it in the order of their
+ * messages. commandPipeFlag stands alone and tells the server to take the next command out of its command ring, so
+ * that commands stay in order with the clients around them while the pipe only carries a byte for them */
+const std::byte newClientFdPipeFlag = std::byte(0x01);
+const std::byte commandPipeFlag = std::byte(0x02);
+
+/* First byte of every message of the command ring. SET_RESPONSE_SCHEMA is followed by an encoded SchemaDescriptor,
+ * while RETIRE, asking the server to stop taking new clients and to exit once its current clients are gone, stands
+ * alone */
+enum class ControlMessageType : char { SET_RESPONSE_SCHEMA = 1, RETIRE = 2 };
+
+/* Packets sent over a socketpair channel hold whole messages of at most this many bytes in total (unless a single
+ * message is larger), and at most "maxFdsPerPacket" client sockets */
+const size_t maxChannelPacketSize = 128 * 1024;
+const size_t maxFdsPerPacket = 64;
+
+/* How client sockets reach the servers. With PIDFD, the dispatcher writes the fd number into a FIFO and the server
+ * copies the socket out of the dispatcher with pidfd_getfd, so the dispatcher can never tell when to close its copy.
+ * With SOCKETPAIR, the sockets themselves are passed as SCM_RIGHTS over a Unix socketpair, and the dispatcher closes
+ * its copy as soon as they are sent */
+enum class HandoffTransport { PIDFD, SOCKETPAIR, UNKNOWN };
+
+/* Messages pushed to an InProcessPipe at once are at most this many bytes (unless a single message is larger) */
+const size_t maxRingChunkSize = 4096;
+
+/* Stands in for the dispatcher->server pipe of a server running as a thread of the dispatcher (see WorkerMode). The
+ * messages otherwise written to the pipe are pushed to "ring" in chunks of whole messages, and the eventfd "doorbellFd",
+ * which the server watches in place of the pipe, is signalled after every batch of chunks. The eventfd "spaceFd" goes
+ * the other way, signalled by the server once it took chunks out of a ring the dispatcher found full. Client sockets are
+ * shared by the two, so their fd numbers are handed over as they are */
+class InProcessPipe {
+  public:
+    /* Creates the eventfds, or throws an error if necessary */
+    InProcessPipe();
+    ~InProcessPipe();
+    InProcessPipe(const InProcessPipe &) = delete;
+    InProcessPipe &operator=(const InProcessPipe &) = delete;
+
+    /* Wakes the server up, which then takes everything out of the ring */
+    void ring();
+
+    /* Resets the doorbell. Has to be called by the server before it takes the chunks out of the ring, so a chunk
+     * pushed in between rings again */
+    void resetDoorbell();
+
+    /* Asks the server to signal "spaceFd" the next time it takes chunks out of the ring, resetting it first. Has to be
+     * called by the dispatcher after finding the ring full and before trying to push again, so that the server either
+     * made room already or signals once it does */
+    void wantSpace();
+
+    /* Signals "spaceFd" if the dispatcher is waiting for room in the ring. Has to be called by the server after it took
+     * chunks out of the ring */
+    void signalSpace();
+
+    inline int getDoorbellFd() const { return doorbellFd; }
+
+    inline int getSpaceFd() const { return spaceFd; }
+
+    inline ControlRing &getChunks() { return chunks; }
+
+  private:
+    ControlRing chunks;
+    int doorbellFd;
+    int spaceFd;
+
+    /* True while the dispatcher waits for room in the ring. Keeps the server from writing "spaceFd" after every batch
+     * when nobody waits for it */
+    std::atomic<bool> spaceWanted = false;
+};
+
+/* Dispatcher's end of the dispatcher->server pipe of a single server. The pipe is opened once and kept open for the
+ * lifetime of the server. Messages are queued and written in batches, so a burst of clients handed over to the server
+ * costs a single write (or a sendmsg per "maxFdsPerPacket" clients over a socketpair). Commands themselves go through
+ * "commandRing", shared with the server, which the channel produces to. Messages can be queued and flushed from any
+ * thread, but commands only from one at a time */
+class ServerChannel {
+  public:
+    /* Opens the pipe at "pipePath", which has to exist already, or throws an error if necessary */
+    ServerChannel(const std::string &pipePath, ControlRing &commandRing);
+
+    /* Takes over "socketFd", the dispatcher's end of a SOCK_SEQPACKET socketpair. Client sockets are passed to the
+     * server through it and closed once sent */
+    ServerChannel(int socketFd, ControlRing &commandRing);
+
+    /* Pushes to "pipe", shared with a server running as a thread of the dispatcher. Client sockets are owned by the
+     * server once pushed */
+    ServerChannel(std::shared_ptr<InProcessPipe> pipe, ControlRing &commandRing);
+    ~ServerChannel();
+    ServerChannel(const ServerChannel &) = delete;
+    ServerChannel &operator=(const ServerChannel &) = delete;
+
+    /* Queues handing the client socket "clientFd" speaking "framing" over to the server */
+    void queueClient(int clientFd, FramingType framing);
+
+    /* Queues the control message of type "type" followed by "payload" for the server. Returns false if the server's
+     * command ring is full */
+    bool queueControlMessage(ControlMessageType type, std::string_view payload = {});
+
+    /* Writes as much of the queued messages as the pipe accepts without blocking. Returns true if nothing is left
+     * queued, or throws an error if necessary. Messages to a server that closed its end are dropped */
+    bool flush();
+
+    /* Writes all queued messages, waiting for the server to read from the pipe if it is full. Gives up and drops the
+     * messages if the server process behind the pidfd "serverPidFd" exits in the meantime. The queue isn't locked
+     * while waiting, so that the wait only holds the caller's locks, none of which the server ever takes */
+    void flushBlocking(int serverPidFd);
+
+    bool hasQueuedData();
+
+    inline int getFd() const { return fd; }
+
+    /* Returns the fd to watch for "getSpaceEvents" until "flush" can write more: the pipe or socketpair itself for
+     * POLLOUT, or the space eventfd of an InProcessPipe for POLLIN, its doorbell being always writable */
+    inline int getSpaceFd() const { return inProcessPipe != nullptr ? inProcessPipe->getSpaceFd() : fd; }
+
+    inline short getSpaceEvents() const { return inProcessPipe != nullptr ? POLLIN : POLLOUT; }
+
+    /* Returns the transport named "choice" (PIDFD or SCM_RIGHTS), or UNKNOWN */
+    static HandoffTransport getHandoffTransport(const std::string &choice);
+
+  private:
+    /* Drops the queued messages, closing the client sockets they hand over */
+    void dropQueued();
+
+    /* Unlocked version of "flush" */
+    bool flushQueued();
+
+    /* "flushQueued" over a socketpair, sending whole messages in packets that carry their client sockets */
+    bool sendQueuedPackets();
+
+    /* "flushQueued" to an InProcessPipe, pushing whole messages in chunks */
+    bool pushQueuedChunks();
+
+    int fd;
+
+    ControlRing &commandRing;
+
+    /* True if "fd" is a socketpair passing client sockets rather than a pipe */
+    bool passesFds = false;
+
+    /* Pipe of a server thread, whose doorbell is "fd", or nullptr */
+    std::shared_ptr<InProcessPipe> inProcessPipe;
+
+    /* Messages not written yet, starting at "queuedOffset" */
+    std::mutex queueMutex;
+    std::vector<std::byte> queued;
+    size_t queuedOffset = 0;
+
+    /* End offset in "queued" of every queued message and the client socket it hands over (-1 for commands), starting
+     * at "queuedMessageIdx". Only used when passing fds or pushing to an InProcessPipe */
+    std::vector<std::pair<size_t, int>> queuedMessages;
+    size_t queuedMessageIdx = 0;
+};
+} // namespace echo
\ No newline at end of file
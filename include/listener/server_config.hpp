@@ -0,0 +1,23 @@
+#pragma once
+
+#include "listener/event_loop.hpp"
+
+namespace echo {
+
+/* Default limit of clients served by a single server process at once */
+const int defaultMaxClients = 128 * 1024;
+
+/* Configuration of a server process */
+struct ServerConfig {
+    EventLoopType eventLoopType = EventLoopType::POLL;
+
+    /* Number of reactor threads serving the clients of the server, each with its own event loop (or io_uring) */
+    int reactorCount = 1;
+
+    /* Clients handed to the server beyond this many are refused (closed right away) */
+    int maxClients = defaultMaxClients;
+
+    /* Whether the buffer pools of the reactors are backed by huge pages */
+    bool hugePages = false;
+};
+} // namespace echo
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "listener/control_ring.hpp"
+
+namespace echo {
+
+/* Output and reassembly bytes a server buffers that weigh as much as one more client in load scores */
+const size_t bufferedBytesPerClient = 64 * 1024;
+
+/* Stats slots of a server. Reactors beyond the first "statsSlotCount" ones share the slots */
+const size_t statsSlotCount = 16;
+
+/* Buckets of the latency histogram. Bucket 0 counts batches of work taking less than 1 us, bucket i the ones taking
+ * [2^(i-1), 2^i) us, and the last one all the longer ones */
+const size_t latencyBucketCount = 16;
+
+/* Live load of a server, updated by its reactors without locks and read by the dispatcher to balance clients. It lives
+ * in memory shared by both processes, so it only holds lock-free atomics */
+struct alignas(cacheLineSize) ServerLoad {
+    /* Clients handed over to the server so far, including the refused ones */
+    std::atomic<uint64_t> receivedClients = 0;
+
+    /* Clients currently served or waiting to be added to a reactor */
+    std::atomic<int64_t> activeClients = 0;
+
+    /* Bytes of the reactors' buffers in use, i.e messages not fully received or responded to and unsent responses */
+    std::atomic<int64_t> bufferedBytes = 0;
+
+    /* Moving average of the time reactors take to handle a batch of ready sockets or completions, in nanoseconds */
+    std::atomic<int64_t> latencyNanos = 0;
+};
+
+static_assert(std::atomic<int64_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free);
+
+/* Traffic of the reactors of a server using the same stats slot. Reactors add to it once per batch of work, and every
+ * slot has cache lines of its own so that reactors don't contend over them */
+struct alignas(cacheLineSize) ReactorStats {
+    std::atomic<uint64_t> messages = 0;
+    std::atomic<uint64_t> bytesReceived = 0;
+    std::atomic<uint64_t> bytesSent = 0;
+
+    /* Batches of work handled, by how long they took (see latencyBucketCount) */
+    std::atomic<uint64_t> latencyBuckets[latencyBucketCount] = {};
+};
+
+/* Totals of the stats slots of a server */
+struct ServerStats {
+    uint64_t messages = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t bytesSent = 0;
+    std::array<uint64_t, latencyBucketCount> latencyBuckets{};
+
+    /* Returns the upper bound in microseconds of the bucket holding the "percentile" of the batch latencies, 0 if no
+     * batch was handled yet, or infinity for the last bucket */
+    double getLatencyPercentileMicros(double percentile) const;
+};
+
+/* Returns the latency bucket of a batch of work that took "latencyNanos" */
+size_t toLatencyBucket(int64_t latencyNanos);
+
+/* Everything a server shares with the dispatcher: its load and stats, which the server writes and the dispatcher reads,
+ * and the ring carrying the dispatcher's commands to the server */
+struct ServerControlBlock {
+    ServerLoad load;
+    ReactorStats reactorStats[statsSlotCount];
+
+    /* Version of the response schema descriptor the server switched to last, 0 for the default schema */
+    alignas(cacheLineSize) std::atomic<uint64_t> schemaVersion = 0;
+
+    ControlRing commands;
+};
+
+/* Dispatcher's view of the load of a single server. The ServerControlBlock is mapped as shared memory before the server
+ * is forked, and reading it costs no syscalls. Clients handed over to the server that it hasn't received yet are
+ * counted by the dispatcher itself, so a burst of clients isn't balanced against stale numbers */
+class ServerLoadMonitor {
+  public:
+    /* Maps a zeroed ServerControlBlock to be shared with the server with ID "serverId" forked afterwards, or throws an
+     * error if necessary */
+    explicit ServerLoadMonitor(int serverId = 0);
+    ~ServerLoadMonitor();
+    ServerLoadMonitor(const ServerLoadMonitor &) = delete;
+    ServerLoadMonitor &operator=(const ServerLoadMonitor &) = delete;
+    ServerLoadMonitor(ServerLoadMonitor &&other) noexcept;
+    ServerLoadMonitor &operator=(ServerLoadMonitor &&other) noexcept;
+
+    inline int getServerId() const { return serverId; }
+
+    /* Memory shared with the server */
+    inline ServerControlBlock &getControlBlock() const { return *controlBlock; }
+
+    /* Load the server publishes to */
+    inline ServerLoad &getLoad() const { return controlBlock->load; }
+
+    /* Sums up the stats slots of the server */
+    ServerStats getStats() const;
+
+    /* Counts a client handed over to the server */
+    inline void recordDispatchedClient() { dispatchedClients++; }
+
+    /* Clients served by the server, including the ones still on their way to it */
+    uint64_t getClientCount() const;
+
+    inline uint64_t getBufferedBytes() const {
+        int64_t bufferedBytes = getLoad().bufferedBytes.load(std::memory_order_relaxed);
+        return bufferedBytes > 0 ? bufferedBytes : 0;
+    }
+
+    inline double getLatencyMicros() const { return getLoad().latencyNanos.load(std::memory_order_relaxed) / 1e3; }
+
+    /* Single number ordering servers by how loaded they are. Every client counts, and so does every
+     * "bufferedBytesPerClient" bytes the server holds. A server whose reactors take long to get through their work
+     * counts proportionally more (twice as much at 1 ms per batch) */
+    double getLoadScore() const;
+
+  private:
+    ServerControlBlock *controlBlock;
+    int serverId;
+
+    uint64_t dispatchedClients = 0;
+};
+} // namespace echo
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace echo {
+
+class BufferPool;
+
+/* Smallest and largest buffer sizes served from size classes. Larger buffers are mapped and unmapped one by one */
+const size_t minPooledBufferSize = 1024;
+const size_t maxPooledBufferSize = 32 * 1024 * 1024;
+
+/* Size of the slabs small buffers are carved out of, matching the size of a huge page */
+const size_t slabSize = 2 * 1024 * 1024;
+
+/* Memory block taken from a BufferPool and handed back to it when destroyed. Without a pool the block comes from the
+ * heap */
+class Buffer {
+  public:
+    Buffer() = default;
+    Buffer(BufferPool *pool, char *data, size_t capacity) : pool(pool), data(data), capacity(capacity){};
+    ~Buffer() { reset(); }
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+    Buffer(Buffer &&other) noexcept { *this = std::move(other); }
+    Buffer &operator=(Buffer &&other) noexcept;
+
+    /* Gives the block back to where it came from, leaving the buffer empty */
+    void reset();
+
+    inline char *getData() const { return data; }
+
+    inline size_t getCapacity() const { return capacity; }
+
+  private:
+    BufferPool *pool = nullptr;
+    char *data = nullptr;
+    size_t capacity = 0;
+};
+
+/* Snapshot of the memory held by a BufferPool */
+struct BufferPoolStats {
+    /* Bytes mapped for slabs and large buffers */
+    size_t reservedBytes;
+
+    /* Bytes of buffers currently handed out, and their highest value so far */
+    size_t usedBytes;
+    size_t usedHighWaterMark;
+
+    size_t slabCount;
+};
+
+/* Allocator of the buffers of a single reactor. Buffers are rounded up to a power of two size class. Freed buffers go
+ * to the free list of their class and are reused, so once the pool has grown to the working set, acquiring and
+ * releasing buffers never calls into malloc or the kernel. Memory is only returned to the OS when the pool is
+ * destroyed. Acquiring and releasing must happen on one thread, the statistics can be read from any thread */
+class BufferPool {
+  public:
+    /* With "hugePages", slabs are backed by huge pages if the system has some reserved, and by transparent huge pages
+     * otherwise */
+    BufferPool(bool hugePages = false) : hugePages(hugePages){};
+    ~BufferPool();
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    /* Returns a buffer of at least "size" bytes or throws an error if necessary */
+    Buffer acquire(size_t size);
+
+    /* Returns a buffer of at least "size" bytes from "pool", or from the heap if "pool" is nullptr */
+    static Buffer allocate(BufferPool *pool, size_t size);
+
+    BufferPoolStats getStats() const;
+
+  private:
+    friend class Buffer;
+
+    static const size_t classCount = 16;
+
+    /* Freed buffers of a size class, linked through their first bytes */
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    /* Takes back a buffer handed out by "acquire" */
+    void release(char *data, size_t capacity);
+
+    /* Maps "size" bytes of memory for the pool or throws an error if necessary */
+    char *mapMemory(size_t size);
+
+    bool hugePages;
+
+    std::array<FreeBlock *, classCount> freeLists{};
+
+    /* Part of the latest slab that has not been carved into buffers yet */
+    char *slabCursor = nullptr;
+    size_t slabRemaining = 0;
+
+    /* Every mapping of the pool, unmapped on destruction */
+    std::vector<std::pair<char *, size_t>> mappings;
+
+    std::atomic<size_t> reservedBytes = 0;
+    std::atomic<size_t> usedBytes = 0;
+    std::atomic<size_t> usedHighWaterMark = 0;
+    std::atomic<size_t> slabCount = 0;
+};
+} // namespace echo
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "socket/buffer_pool.hpp"
+
+namespace echo {
+
+/* LINE frames end with '\n', LENGTH frames start with a 4 byte big-endian payload length */
+enum class FramingType : uint8_t { LINE, LENGTH, UNKNOWN };
+
+/* Frames larger than this are treated as a protocol violation */
+const size_t maxFrameSize = 16 * 1024 * 1024;
+
+const size_t lengthHeaderSize = sizeof(uint32_t);
+
+class Framing {
+  public:
+    /* Appends "payload" encoded as a frame of "type" to "out" */
+    static void appendFrame(std::string &out, FramingType type, std::string_view payload);
+
+    /* Writes the bytes preceding a payload of "payloadSize" in a frame of "type" (the length header of LENGTH frames)
+     * to "dest", which must hold at least "lengthHeaderSize" bytes. Returns the number of bytes written */
+    static size_t encodeHeader(FramingType type, size_t payloadSize, char *dest);
+
+    /* Returns the bytes following a payload in a frame of "type" (the delimiter of LINE frames) */
+    static std::string_view frameTrailer(FramingType type);
+
+    /* Turns the first "payloadSize" bytes of a payload decoded in place back into a complete frame of "type", rewriting
+     * the length header before it or the delimiter after it, and returns the frame. "payloadSize" must not exceed the
+     * size of the decoded payload */
+    static std::string_view sealFrameInPlace(FramingType type, char *payload, size_t payloadSize);
+
+    /* Returns the framing type matching "choice" (e.g LINE), or UNKNOWN if there is no such type */
+    static FramingType getFramingType(const std::string &choice);
+};
+
+/* Payload of a complete frame located inside the reassembly buffer of a FrameDecoder */
+struct FrameView {
+    char *payload;
+    size_t payloadSize;
+};
+
+/* Reassembles frames of a single byte stream that arrive split across, or coalesced within, reads */
+class FrameDecoder {
+  public:
+    /* The reassembly buffer is taken from "pool", or from the heap if there is no pool */
+    FrameDecoder(FramingType type = FramingType::LINE, BufferPool *pool = nullptr) : type(type), pool(pool){};
+
+    /* Appends "len" received bytes of "data" to the reassembly buffer */
+    void feed(const char *data, size_t len);
+
+    /* Returns space for at least "minLen" bytes at the end of the reassembly buffer, so that they can be received into
+     * it directly. "getFeedCapacity" tells how much space there really is, "commitFeed" appends the bytes written to it
+     */
+    char *getFeedBuffer(size_t minLen);
+
+    inline size_t getFeedCapacity() const { return buffer.getCapacity() - size; }
+
+    inline void commitFeed(size_t len) { size += len; }
+
+    /* Copies the payload of the next complete frame into "payload". Returns false if no complete frame is buffered or
+     * the stream is oversized */
+    bool nextFrame(std::string &payload);
+
+    /* Same as above, but leaves the payload inside the reassembly buffer where it may be modified in place. The view
+     * stays valid until the buffer is fed or detached */
+    bool nextFrame(FrameView &frame);
+
+    /* Gives up the reassembly buffer holding the already extracted frames, so frame views into it stay valid for as
+     * long as the caller keeps it. Bytes of incomplete frames move to a new buffer */
+    Buffer detachBuffer();
+
+    /* Hands the reassembly buffer back while it holds no bytes, so idle streams hold no memory */
+    void releaseIdleBuffer();
+
+    /* Returns true once the stream contains a frame larger than "maxFrameSize", after which it can't be decoded */
+    inline bool isOversized() const { return oversized; }
+
+    inline FramingType getType() const { return type; }
+
+    inline size_t getBufferedBytes() const { return size - consumed; }
+
+  private:
+    /* Locates the next complete frame without consuming it. Returns false if there is none */
+    bool findFrame(FrameView &frame, size_t &frameEnd);
+
+    /* Drops the already consumed prefix of the buffer once it dominates the buffer */
+    void compact();
+
+    /* Moves the unconsumed bytes into a new buffer of at least "minCapacity" bytes */
+    void reallocate(size_t minCapacity);
+
+    FramingType type;
+    BufferPool *pool;
+
+    /* Reassembly buffer, with "size" bytes written into it */
+    Buffer buffer;
+    size_t size = 0;
+
+    /* Bytes at the start of "buffer" that belong to already extracted frames */
+    size_t consumed = 0;
+
+    /* Position from which to continue searching for a LINE delimiter, so no byte is scanned twice */
+    size_t scanned = 0;
+
+    bool oversized = false;
+};
+} // namespace echo
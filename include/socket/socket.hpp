@@ -2,12 +2,18 @@
 
 #include <memory>
 
+#include "socket/framing.hpp"
+
 #define INVALID_SOCKET_FD -1
 
 namespace echo {
 
 const int bufferSize = 1024;
 
+/* Start of the line a dispatcher in redirect mode answers every client with, followed by the address of the server the
+ * client should connect to instead (a Unix domain socket path, or a port on the host the client connected to) */
+const std::string redirectPrefix = "REDIRECT ";
+
 class ISocket {
   public:
     ISocket() : socketFd(INVALID_SOCKET_FD){};
@@ -24,7 +30,9 @@ class ISocket {
     /*Sets up the initial socket options*/
     virtual void initOptions(int socketFd) = 0;
 
-    /*Accepts the incoming connection to the server and returns the incoming socket fd. */
+    /* Accepts a pending connection without blocking and returns its socket, which is non-blocking and close-on-exec
+     * already. Returns INVALID_SOCKET_FD once no connection is pending, or throws an error if necessary. The listening
+     * socket has to be non-blocking */
     virtual int setupNewConnection() = 0;
 
     /* Connects to the server of "serverAddress" */
@@ -32,8 +40,14 @@ class ISocket {
 
     inline virtual int getsocketFd() const { return socketFd; };
 
+    /* Framing of the messages exchanged over this socket (and, for listeners, over the connections it accepts) */
+    inline FramingType getFraming() const { return framing; }
+
+    inline void setFraming(FramingType type) { framing = type; }
+
   protected:
     int socketFd;
+    FramingType framing = FramingType::LINE;
 };
 
 class UnixSocket : public ISocket {
@@ -51,15 +65,38 @@ class UnixSocket : public ISocket {
     const std::string socketPath;
 };
 
+/* How the kernel spreads the connections of a SO_REUSEPORT group over its listening sockets */
+enum class ReusePortSteering {
+    NONE,   // not part of a SO_REUSEPORT group
+    CPU,    // the socket at the index of the CPU that received the connection, modulo the group size
+    HASH,   // the socket at the index of the connection's flow hash, modulo the group size
+    UNKNOWN
+};
+
 class InetSocket : public ISocket {
   public:
     InetSocket(int port);
 
+    /* Socket that can share "port" with other sockets of the same user setting "reusePort" (SO_REUSEPORT) */
+    InetSocket(int port, bool reusePort);
+
     void bind() override;
     void initOptions(int socketFd) override;
     int setupNewConnection() override;
     void connectToServer(const std::string &serverAddress) override;
 
+    /* Makes the SO_REUSEPORT group of the socket steer its connections over its "groupSize" sockets according to
+     * "steering", by attaching a classic BPF program, or throws an error if necessary. The socket has to be listening
+     * already, since a socket with a program attached before couldn't join the group anymore */
+    void steerReusePortGroup(ReusePortSteering steering, int groupSize);
+
+    /* Makes the SO_REUSEPORT group of the socket prefer it for the connections received on "cpu" (SO_INCOMING_CPU),
+     * or throws an error if necessary. Only used by groups without a steering program */
+    void setIncomingCpu(int cpu);
+
+    /* Returns steering type based on the "choice" string */
+    static ReusePortSteering getReusePortSteering(const std::string &choice);
+
   private:
     int port;
 };
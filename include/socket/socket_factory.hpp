@@ -6,5 +6,10 @@ namespace echo {
 class SocketFactory {
   public:
     static AbstractSocket createClientSocket(int argc, char *argv[]);
+
+  private:
+    /* Reads the redirect line the dispatcher answered on "dispatcherSocket" with and returns a socket of the same kind
+     * connected to the server it names, on "host" for Internet sockets, or throws an error if necessary */
+    static AbstractSocket followRedirect(const ISocket &dispatcherSocket, const std::string &host);
 };
 } // namespace echo
\ No newline at end of file
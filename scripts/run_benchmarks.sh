@@ -0,0 +1,11 @@
+#!/bin/bash
+
+# (Re)build first
+mkdir -p build
+cd build
+cmake .. -DWITH_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=Release
+make
+cd ..
+
+# Find and run all benchmark files
+find build/bench -type f -name "*_bench" -exec {} \;
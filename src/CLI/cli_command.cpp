@@ -1,4 +1,5 @@
 #include <csignal>
+#include <cstdio>
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
@@ -19,59 +20,216 @@ CLI_COMMAND_TYPE void HelpCliCommand<APP_T>::execute([[maybe_unused]] AbstractTo
         std::cout << "During runtime: "
                   << "[OPTION]";
         std::cout << "--set-response-schema "
-                  << "EQUIVALENT/REVERSE/CENSORED CHAR=c/PALINDROME" << std::endl;
+                  << "EQUIVALENT/REVERSE/CENSORED CHAR=c/CENSORED CHARS=a-z0-9 [MASK=c]/PALINDROME/"
+                  << "BLOCKLIST FILE=path [MASK=c]/PIPELINE STAGE,STAGE... (e.g CENSORED:CHAR=x,REVERSE)\n";
+        std::cout << "--balancing "
+                  << "ROUND_ROBIN/LEAST_CONNECTIONS/POWER_OF_TWO/WEIGHTED W1,W2,...\n";
+        std::cout << "--add-servers N, --remove-server ID, --autoscale MIN,MAX LOW,HIGH/OFF, --list-servers\n";
+        std::cout << "Startup only: "
+                  << "--event-loop POLL/EPOLL/IO_URING, --framing INET/UNIX LINE/LENGTH, --server-threads N, "
+                  << "--huge-pages, --max-clients N, --listen-backlog N, --handoff PIDFD/SCM_RIGHTS, "
+                  << "--reuseport CPU/HASH, --redirect, --placement CORE/NODE/OFF [INCOMING_CPU], "
+                  << "--workers PROCESS/THREAD" << std::endl;
     } else if constexpr (std::same_as<APP_T, Client>) {
-        std::string correctFormat = " (<Unix_domain_socket_address> | <Internet_domain_address> <port_number>)";
+        std::string correctFormat =
+            " (<Unix_domain_socket_address> | <Internet_domain_address> <port_number>) [LINE/LENGTH] [REDIRECT]";
         std::cout << "Usage: "
                   << "./echo_client " << correctFormat << std::endl;
     }
 }
 
 void ChangeResponseSchemaCliCommand::execute(AbstractTokens tokens) const {
-    auto servers = app.getServers();
-    for (int i = 0; i < servers.size(); i++) {
-        int pipeFd = open(app.serverIdToPipePath(app.getServerIdAtIdx(i)).c_str(), O_WRONLY);
-        if (pipeFd == -1) {
-            throw std::system_error(errno, std::generic_category(), "Failed to open the dispatcher->server pipe");
-        }
+    // Compiled once here rather than by every server
+    std::optional<SchemaDescriptor> descriptor = ResponseSchemaFactory().compileDescriptor(tokens);
+    if (!descriptor.has_value()) {
+        std::cout << "Unknown response schema or its configuration" << std::endl;
+        return;
+    }
 
-        auto command = tokens->detokenize(' ');
-        uint16_t commandLen = command.size();
+    uint64_t version = app.setResponseSchema(std::move(*descriptor));
+    std::cout << "Rolling out response schema version " << version << std::endl;
+}
 
-        std::vector<std::byte> commandBuf;
-        commandBuf.resize(sizeof(commandPipeFlag) + sizeof(commandLen) + commandLen);
-        commandBuf[0] = commandPipeFlag;
-        std::memcpy(&commandBuf[sizeof(commandPipeFlag)], &commandLen, sizeof(commandLen));
-        std::memcpy(&commandBuf[sizeof(commandPipeFlag) + sizeof(commandLen)], command.c_str(), commandLen);
+void EventLoopCliCommand::execute(AbstractTokens tokens) const {
+    EventLoopType type = EventLoopFactory::getEventLoopType(tokens->getChoice());
+    if (type == EventLoopType::UNKNOWN) {
+        std::cout << "Unknown event loop type: " << tokens->getChoice() << std::endl;
+    } else if (!app.setEventLoopType(type)) {
+        std::cout << "The event loop can only be chosen on startup" << std::endl;
+    }
+}
 
-        ssize_t bytesWritten = write(pipeFd, commandBuf.data(), commandBuf.size());
-        if (bytesWritten == -1) {
-            close(pipeFd);
-            throw std::system_error(errno, std::generic_category(), "Failed to write to the dispatcher->server pipe");
-        }
+void ServerThreadsCliCommand::execute(AbstractTokens tokens) const {
+    int threadCount = std::atoi(tokens->getChoice().c_str());
+    if (threadCount < 1) {
+        std::cout << "Usage: --server-threads N (N >= 1)" << std::endl;
+    } else if (!app.setServerThreadCount(threadCount)) {
+        std::cout << "The number of server threads can only be chosen on startup" << std::endl;
+    }
+}
+
+void MaxClientsCliCommand::execute(AbstractTokens tokens) const {
+    int maxClients = std::atoi(tokens->getChoice().c_str());
+    if (maxClients < 1) {
+        std::cout << "Usage: --max-clients N (N >= 1)" << std::endl;
+    } else if (!app.setMaxClients(maxClients)) {
+        std::cout << "The client limit can only be chosen on startup" << std::endl;
+    }
+}
+
+void ListenBacklogCliCommand::execute(AbstractTokens tokens) const {
+    int backlog = std::atoi(tokens->getChoice().c_str());
+    if (backlog < 1) {
+        std::cout << "Usage: --listen-backlog N (N >= 1)" << std::endl;
+    } else if (app.isStarted()) {
+        std::cout << "The listen backlog can only be chosen on startup" << std::endl;
+    } else {
+        app.setListenBacklog(backlog);
+    }
+}
 
-        close(pipeFd);
+void HugePagesCliCommand::execute(AbstractTokens tokens) const {
+    if (!app.setHugePages(true)) {
+        std::cout << "Huge pages can only be enabled on startup" << std::endl;
+    }
+}
+
+void HandoffCliCommand::execute(AbstractTokens tokens) const {
+    HandoffTransport transport = ServerChannel::getHandoffTransport(tokens->getChoice());
+    if (transport == HandoffTransport::UNKNOWN) {
+        std::cout << "Usage: --handoff PIDFD/SCM_RIGHTS" << std::endl;
+    } else if (!app.setHandoffTransport(transport)) {
+        std::cout << "The handoff transport can only be chosen on startup" << std::endl;
+    }
+}
+
+void ReusePortCliCommand::execute(AbstractTokens tokens) const {
+    ReusePortSteering steering = InetSocket::getReusePortSteering(tokens->getChoice());
+    if (steering == ReusePortSteering::UNKNOWN) {
+        std::cout << "Usage: --reuseport CPU/HASH" << std::endl;
+    } else if (!app.setReusePortSteering(steering)) {
+        std::cout << "The reuseport mode can only be chosen on startup" << std::endl;
+    }
+}
+
+void RedirectCliCommand::execute(AbstractTokens tokens) const {
+    if (!app.setRedirect(true)) {
+        std::cout << "The redirect mode can only be chosen on startup" << std::endl;
+    }
+}
+
+void WorkersCliCommand::execute(AbstractTokens tokens) const {
+    WorkerMode mode = Dispatcher::getWorkerMode(tokens->getChoice());
+    if (mode == WorkerMode::UNKNOWN) {
+        std::cout << "Usage: --workers PROCESS/THREAD" << std::endl;
+    } else if (!app.setWorkerMode(mode)) {
+        std::cout << "The worker mode can only be chosen on startup" << std::endl;
+    }
+}
+
+void PlacementCliCommand::execute(AbstractTokens tokens) const {
+    PlacementPolicy policy = CpuPlacement::getPlacementPolicy(tokens->getChoice());
+    std::string argument = tokens->getChoiceArgument();
+    bool incomingCpu = argument == "INCOMING_CPU";
+    if (policy == PlacementPolicy::UNKNOWN || (!argument.empty() && !incomingCpu) ||
+        (policy == PlacementPolicy::NONE && incomingCpu)) {
+        std::cout << "Usage: --placement CORE/NODE/OFF [INCOMING_CPU]" << std::endl;
+    } else if (!app.setPlacement(policy, incomingCpu)) {
+        std::cout << "The placement can only be chosen on startup" << std::endl;
+    }
+}
+
+void BalancingCliCommand::execute(AbstractTokens tokens) const {
+    BalancingStrategyFactory strategyFactory;
+    AbstractBalancingStrategy strategy = strategyFactory.createStrategy(tokens);
+    if (strategy == nullptr) {
+        std::cout << "Usage: --balancing ROUND_ROBIN/LEAST_CONNECTIONS/POWER_OF_TWO/WEIGHTED W1,W2,..." << std::endl;
+        return;
+    }
+    app.setBalancingStrategy(std::move(strategy));
+}
+
+void AddServersCliCommand::execute(AbstractTokens tokens) const {
+    int count = std::atoi(tokens->getChoice().c_str());
+    if (count < 1) {
+        std::cout << "Usage: --add-servers N (N >= 1)" << std::endl;
+        return;
+    }
+    app.addServers(count);
+}
+
+void RemoveServerCliCommand::execute(AbstractTokens tokens) const {
+    int serverId = std::atoi(tokens->getChoice().c_str());
+    if (serverId < 1) {
+        std::cout << "Usage: --remove-server ID (ID >= 1)" << std::endl;
+        return;
+    }
+    app.removeServer(serverId);
+}
+
+void AutoscaleCliCommand::execute(AbstractTokens tokens) const {
+    if (tokens->getChoice() == "OFF") {
+        app.setAutoscaler(nullptr);
+        return;
+    }
+
+    // Both arguments are a comma separated pair, of pool sizes and of average load scores
+    size_t minServers = 0;
+    size_t maxServers = 0;
+    double scaleDownLoad = 0;
+    double scaleUpLoad = 0;
+    bool parsed = std::sscanf(tokens->getChoice().c_str(), "%zu,%zu", &minServers, &maxServers) == 2 &&
+                  std::sscanf(tokens->getChoiceArgument().c_str(), "%lf,%lf", &scaleDownLoad, &scaleUpLoad) == 2;
+    if (!parsed || minServers < 1 || maxServers < minServers || scaleDownLoad < 0 || scaleUpLoad <= scaleDownLoad) {
+        std::cout << "Usage: --autoscale MIN,MAX LOW,HIGH (1 <= MIN <= MAX, 0 <= LOW < HIGH) or --autoscale OFF"
+                  << std::endl;
+        return;
+    }
+    app.setAutoscaler(std::make_unique<Autoscaler>(minServers, maxServers, scaleDownLoad, scaleUpLoad));
+}
+
+void ListServersCliCommand::execute([[maybe_unused]] AbstractTokens tokens) const { app.listServers(); }
+
+void FramingCliCommand::execute(AbstractTokens tokens) const {
+    std::string listenerType = tokens->getChoice();
+    FramingType framing = Framing::getFramingType(tokens->getChoiceArgument());
+    if (framing == FramingType::UNKNOWN || (listenerType != "INET" && listenerType != "UNIX")) {
+        std::cout << "Usage: --framing INET/UNIX LINE/LENGTH" << std::endl;
+    } else if (!app.setFraming(listenerType == "UNIX", framing)) {
+        std::cout << "The framing can only be chosen on startup" << std::endl;
     }
 }
 
 void SendToServerCliCommand::execute(AbstractTokens tokens) const {
     char buffer[bufferSize];
-    int clientFd = app.getClientSocket()->getsocketFd();
-    std::string userInput = tokens->detokenize(' ');
+    AbstractSocket &socket = app.getClientSocket();
+    int clientFd = socket->getsocketFd();
+
+    std::string request;
+    Framing::appendFrame(request, socket->getFraming(), tokens->detokenize(' '));
 
-    int bytesSent = send(clientFd, userInput.c_str(), userInput.length(), 0);
-    if (bytesSent == -1) {
-        std::cerr << "Couldn't send data to server. " << errno << std::endl;
+    for (size_t offset = 0; offset < request.length();) {
+        int bytesSent = send(clientFd, request.c_str() + offset, request.length() - offset, MSG_NOSIGNAL);
+        if (bytesSent == -1) {
+            std::cerr << "Couldn't send data to server. " << errno << std::endl;
+            return;
+        }
+        offset += bytesSent;
     }
 
-    int bytesRead = recv(clientFd, buffer, sizeof(buffer), 0);
-    if (bytesRead <= 0) {
-        std::cout << "Connection to the server terminated." << std::endl;
-        Client::signalHandler(SIGTERM);
-        return;
+    // Responses larger than the buffer arrive in several reads
+    std::string response;
+    FrameDecoder &decoder = app.getResponseDecoder();
+    while (!decoder.nextFrame(response)) {
+        int bytesRead = recv(clientFd, buffer, sizeof(buffer), 0);
+        if (bytesRead <= 0 || decoder.isOversized()) {
+            std::cout << "Connection to the server terminated." << std::endl;
+            Client::signalHandler(SIGTERM);
+            return;
+        }
+        decoder.feed(buffer, bytesRead);
     }
 
-    std::string response(buffer, bytesRead);
     std::cout << "Server Response: " << response << std::endl;
 }
 
@@ -24,4 +24,28 @@ std::string Tokens::detokenize(char delimiter) {
     }
     return result;
 }
+
+std::vector<AbstractTokens> StartupTokens::splitByOption(const std::vector<std::string> &args) {
+    std::vector<AbstractTokens> result;
+    if (args.empty()) {
+        return result;
+    }
+
+    std::vector<std::string> current;
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i].starts_with("--") && !current.empty()) {
+            result.emplace_back(std::make_unique<StartupTokens>(current));
+            current.clear();
+        }
+        if (current.empty()) {
+            current.emplace_back(args[0]);
+        }
+        current.emplace_back(args[i]);
+    }
+
+    if (!current.empty()) {
+        result.emplace_back(std::make_unique<StartupTokens>(current));
+    }
+    return result;
+}
 } // namespace echo
\ No newline at end of file
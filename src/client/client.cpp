@@ -13,7 +13,8 @@ std::condition_variable clientShutdownCV;
 std::mutex clientShutdownMutex;
 } // namespace
 
-Client::Client(AbstractSocket socket) : clientSocket(std::move(socket)) {
+Client::Client(AbstractSocket socket)
+    : clientSocket(std::move(socket)), responseDecoder(clientSocket ? clientSocket->getFraming() : FramingType::LINE) {
     inputToCommand["--help"] = std::make_unique<ClientHelpCliCommand>(*this);
     inputToCommand["send-to-server"] = std::make_unique<SendToServerCliCommand>(*this);
 };
@@ -0,0 +1,45 @@
+#include "listener/autoscaler.hpp"
+
+namespace echo {
+
+int Autoscaler::getPoolChange(const std::vector<ServerLoadMonitor> &servers,
+                              std::chrono::steady_clock::time_point now) {
+    if (now < quietUntil) {
+        return 0;
+    }
+
+    int change = 0;
+    if (servers.size() < minServers) {
+        change = 1;
+    } else if (servers.size() > maxServers) {
+        change = -1;
+    } else if (!servers.empty()) {
+        double totalLoad = 0;
+        for (const ServerLoadMonitor &server : servers) {
+            totalLoad += server.getLoadScore();
+        }
+
+        double averageLoad = totalLoad / servers.size();
+        if (averageLoad > scaleUpLoad && servers.size() < maxServers) {
+            change = 1;
+        } else if (averageLoad < scaleDownLoad && servers.size() > minServers) {
+            change = -1;
+        }
+    }
+
+    if (change != 0) {
+        quietUntil = now + autoscaleCooldown;
+    }
+    return change;
+}
+
+size_t Autoscaler::pickServerToRetire(const std::vector<ServerLoadMonitor> &servers) {
+    size_t picked = 0;
+    for (size_t i = 1; i < servers.size(); i++) {
+        if (servers[i].getClientCount() < servers[picked].getClientCount()) {
+            picked = i;
+        }
+    }
+    return picked;
+}
+} // namespace echo
\ No newline at end of file
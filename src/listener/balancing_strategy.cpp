@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <charconv>
+#include <unordered_map>
+
+#include "listener/balancing_strategy.hpp"
+
+namespace echo {
+
+size_t RoundRobinStrategy::pickServer(const std::vector<ServerLoadMonitor> &servers) {
+    size_t picked = nextIdx % servers.size();
+    nextIdx = picked + 1;
+    return picked;
+}
+
+size_t LeastConnectionsStrategy::pickServer(const std::vector<ServerLoadMonitor> &servers) {
+    size_t picked = nextIdx % servers.size();
+    uint64_t fewestClients = servers[picked].getClientCount();
+
+    for (size_t i = 1; i < servers.size() && fewestClients > 0; i++) {
+        size_t idx = (nextIdx + i) % servers.size();
+        uint64_t clients = servers[idx].getClientCount();
+        if (clients < fewestClients) {
+            picked = idx;
+            fewestClients = clients;
+        }
+    }
+
+    nextIdx = picked + 1;
+    return picked;
+}
+
+size_t WeightedRoundRobinStrategy::pickServer(const std::vector<ServerLoadMonitor> &servers) {
+    bool poolChanged = currentWeights.size() != servers.size();
+    for (size_t i = 0; i < servers.size() && !poolChanged; i++) {
+        poolChanged = currentWeights[i].serverId != servers[i].getServerId();
+    }
+    if (poolChanged) {
+        followPool(servers);
+    }
+
+    size_t picked = 0;
+    int64_t totalWeight = 0;
+    for (size_t i = 0; i < servers.size(); i++) {
+        int weight = getWeight(currentWeights[i].serverId);
+        currentWeights[i].weight += weight;
+        totalWeight += weight;
+        if (currentWeights[i].weight > currentWeights[picked].weight) {
+            picked = i;
+        }
+    }
+
+    currentWeights[picked].weight -= totalWeight;
+    return picked;
+}
+
+void WeightedRoundRobinStrategy::followPool(const std::vector<ServerLoadMonitor> &servers) {
+    std::vector<Credit> credits;
+    credits.reserve(servers.size());
+    for (const ServerLoadMonitor &server : servers) {
+        auto kept = std::find_if(currentWeights.begin(), currentWeights.end(),
+                                 [&server](const Credit &credit) { return credit.serverId == server.getServerId(); });
+        credits.emplace_back(Credit{server.getServerId(), kept != currentWeights.end() ? kept->weight : 0});
+    }
+    currentWeights = std::move(credits);
+}
+
+int WeightedRoundRobinStrategy::getWeight(int serverId) const {
+    return serverId >= 1 && static_cast<size_t>(serverId) <= weights.size() ? weights[serverId - 1] : 1;
+}
+
+size_t PowerOfTwoChoicesStrategy::pickServer(const std::vector<ServerLoadMonitor> &servers) {
+    if (servers.size() == 1) {
+        return 0;
+    }
+
+    size_t first = random() % servers.size();
+    size_t second = random() % (servers.size() - 1);
+    if (second >= first) {
+        second++;
+    }
+    return servers[second].getLoadScore() < servers[first].getLoadScore() ? second : first;
+}
+
+AbstractBalancingStrategy BalancingStrategyFactory::createStrategy(const AbstractTokens &tokens) {
+    switch (getBalancingType(tokens->getChoice())) {
+    case BalancingType::ROUND_ROBIN:
+        return std::make_unique<RoundRobinStrategy>();
+    case BalancingType::LEAST_CONNECTIONS:
+        return std::make_unique<LeastConnectionsStrategy>();
+    case BalancingType::WEIGHTED:
+        return newWeightedStrategy(tokens);
+    case BalancingType::POWER_OF_TWO:
+        return std::make_unique<PowerOfTwoChoicesStrategy>();
+    default:
+        return nullptr;
+    }
+}
+
+BalancingType BalancingStrategyFactory::getBalancingType(const std::string &choice) {
+    static const std::unordered_map<std::string, BalancingType> choiceToType = {
+        {"ROUND_ROBIN", BalancingType::ROUND_ROBIN},
+        {"LEAST_CONNECTIONS", BalancingType::LEAST_CONNECTIONS},
+        {"WEIGHTED", BalancingType::WEIGHTED},
+        {"POWER_OF_TWO", BalancingType::POWER_OF_TWO}};
+
+    auto it = choiceToType.find(choice);
+    if (it != choiceToType.end()) {
+        return it->second;
+    } else {
+        return BalancingType::UNKNOWN;
+    }
+}
+
+std::unique_ptr<WeightedRoundRobinStrategy>
+BalancingStrategyFactory::newWeightedStrategy(const AbstractTokens &tokens) {
+    std::string arg = tokens->getChoiceArgument();
+    std::vector<int> weights;
+
+    const char *position = arg.data();
+    const char *end = arg.data() + arg.size();
+    while (position < end) {
+        int weight;
+        auto [next, error] = std::from_chars(position, end, weight);
+        if (error != std::errc() || weight < 1 || (next != end && *next != ',')) {
+            return nullptr;
+        }
+        weights.emplace_back(weight);
+        position = next + 1;
+    }
+
+    if (weights.empty()) {
+        return nullptr;
+    }
+    return std::make_unique<WeightedRoundRobinStrategy>(std::move(weights));
+}
+} // namespace echo
\ No newline at end of file
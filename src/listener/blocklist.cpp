@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "listener/blocklist.hpp"
+
+namespace echo {
+
+namespace {
+inline uint8_t foldCase(char c) { return static_cast<uint8_t>(std::tolower(static_cast<unsigned char>(c))); }
+
+/* Length of the longest word ending at every byte of the message being filtered, per thread since threads share the
+ * automaton. Grows to the longest message filtered and stays, so filtering doesn't allocate once warmed up */
+thread_local std::vector<uint8_t> matchLengths;
+} // namespace
+
+BlocklistAutomaton::BlocklistAutomaton(const std::vector<std::string> &words) {
+    for (const std::string &word : words) {
+        if (word.size() > maxBlockedWordLength) {
+            throw std::length_error("Blocked word longer than " + std::to_string(maxBlockedWordLength) + " bytes");
+        }
+        for (char c : word) {
+            uint8_t folded = foldCase(c);
+            if (byteClasses[folded] == 0) {
+                byteClasses[folded] = classCount++;
+            }
+        }
+    }
+    for (int byte = 0; byte < 256; byte++) {
+        byteClasses[byte] = byteClasses[foldCase(static_cast<char>(byte))];
+    }
+
+    // Trie of the words, with -1 for missing edges, and the length of the word ending at every state (0 if none)
+    std::vector<int32_t> edges(classCount, -1);
+    std::vector<uint8_t> wordLengths(1, 0);
+    for (const std::string &word : words) {
+        size_t state = 0;
+        for (char c : word) {
+            size_t edge = state * classCount + byteClasses[static_cast<uint8_t>(c)];
+            if (edges[edge] == -1) {
+                edges[edge] = wordLengths.size();
+                wordLengths.emplace_back(0);
+                edges.resize(edges.size() + classCount, -1);
+            }
+            state = edges[edge];
+        }
+        wordLengths[state] = word.size();
+    }
+    if (edges.size() > maxBlocklistTransitions) {
+        throw std::length_error("Blocklist automaton over " + std::to_string(maxBlocklistTransitions) + " transitions");
+    }
+
+    // Breadth first, so that the failure state of every state (its longest proper suffix in the trie) is complete
+    // before the state's own edges are. A missing edge then becomes the edge of the failure state, and a state matches
+    // its own word or, failing that, the longest word its failure state matches
+    std::vector<uint32_t> failures(wordLengths.size(), 0);
+    std::vector<uint32_t> queue;
+    for (size_t c = 0; c < classCount; c++) {
+        int32_t &edge = edges[c];
+        if (edge == -1) {
+            edge = 0;
+        } else {
+            queue.emplace_back(edge);
+        }
+    }
+    for (size_t next = 0; next < queue.size(); next++) {
+        uint32_t state = queue[next];
+        if (wordLengths[state] == 0) {
+            wordLengths[state] = wordLengths[failures[state]];
+        }
+        for (size_t c = 0; c < classCount; c++) {
+            int32_t &edge = edges[state * classCount + c];
+            int32_t failureEdge = edges[failures[state] * classCount + c];
+            if (edge == -1) {
+                edge = failureEdge;
+            } else {
+                failures[edge] = failureEdge;
+                queue.emplace_back(edge);
+            }
+        }
+    }
+
+    transitions.resize(edges.size());
+    for (size_t i = 0; i < edges.size(); i++) {
+        transitions[i] = (static_cast<uint32_t>(edges[i] * classCount) << 8) | wordLengths[edges[i]];
+    }
+}
+
+size_t BlocklistAutomaton::filter(char *message, size_t size, std::optional<char> mask) const {
+    if (matchLengths.size() < size) {
+        matchLengths.resize(size);
+    }
+
+    uint32_t row = 0;
+    uint32_t anyMatch = 0;
+    for (size_t i = 0; i < size; i++) {
+        uint32_t transition = transitions[row + byteClasses[static_cast<uint8_t>(message[i])]];
+        row = transition >> 8;
+        matchLengths[i] = transition & 0xff;
+        anyMatch |= transition & 0xff;
+    }
+    if (anyMatch == 0) {
+        return size;
+    }
+
+    // Backwards, a word ending at a byte covers it and the bytes before it, so the bytes left to censor only shrink by
+    // one per byte or grow to a longer word
+    size_t censoring = 0;
+    if (mask.has_value()) {
+        for (size_t i = size; i-- > 0;) {
+            censoring = std::max<size_t>(censoring, matchLengths[i]);
+            if (censoring > 0) {
+                message[i] = *mask;
+                censoring--;
+            }
+        }
+        return size;
+    }
+
+    // Removal packs the kept bytes at the end of the message, then moves them to the front
+    char *kept = message + size;
+    for (size_t i = size; i-- > 0;) {
+        censoring = std::max<size_t>(censoring, matchLengths[i]);
+        if (censoring > 0) {
+            censoring--;
+        } else {
+            *--kept = message[i];
+        }
+    }
+    size_t keptSize = message + size - kept;
+    std::memmove(message, kept, keptSize);
+    return keptSize;
+}
+
+std::optional<std::vector<std::string>> readBlocklist(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        return std::nullopt;
+    }
+
+    std::vector<std::string> words;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        if (line.size() > maxBlockedWordLength) {
+            return std::nullopt;
+        }
+        words.emplace_back(std::move(line));
+    }
+    if (file.bad() || words.empty()) {
+        return std::nullopt;
+    }
+    return words;
+}
+} // namespace echo
\ No newline at end of file
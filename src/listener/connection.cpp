@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cstring>
+
+#include "listener/connection.hpp"
+
+namespace echo {
+
+void Connection::queueOutput(std::string_view data) {
+    if (data.empty()) {
+        return;
+    }
+
+    pendingBytes += data.size();
+
+    if (canAppendToBack()) {
+        OutputBlock &back = outputBlocks.back();
+        size_t copied = std::min(data.size(), back.owned.getCapacity() - back.ownedSize);
+        std::memcpy(back.owned.getData() + back.ownedSize, data.data(), copied);
+        back.ownedSize += copied;
+        data.remove_prefix(copied);
+    }
+
+    if (!data.empty()) {
+        OutputBlock &block = outputBlocks.emplace_back();
+        block.owned = BufferPool::allocate(pool, std::max(data.size(), outputBlockSize));
+        std::memcpy(block.owned.getData(), data.data(), data.size());
+        block.ownedSize = data.size();
+    }
+}
+
+void Connection::queueFrame(std::string_view payload) {
+    char header[lengthHeaderSize];
+    queueOutput(std::string_view(header, Framing::encodeHeader(decoder.getType(), payload.size(), header)));
+    queueOutput(payload);
+    queueOutput(Framing::frameTrailer(decoder.getType()));
+}
+
+std::span<char> Connection::reserveFrame(size_t maxPayloadSize) {
+    size_t headerSize = decoder.getType() == FramingType::LENGTH ? lengthHeaderSize : 0;
+    size_t frameSize = headerSize + maxPayloadSize + Framing::frameTrailer(decoder.getType()).size();
+    if (!canAppendToBack() || outputBlocks.back().owned.getCapacity() - outputBlocks.back().ownedSize < frameSize) {
+        // The room left in the back block stays unused, rather than split the frame over two blocks
+        OutputBlock &block = outputBlocks.emplace_back();
+        block.owned = BufferPool::allocate(pool, std::max(frameSize, outputBlockSize));
+    }
+    OutputBlock &back = outputBlocks.back();
+    return std::span<char>(back.owned.getData() + back.ownedSize + headerSize, maxPayloadSize);
+}
+
+void Connection::commitFrame(size_t payloadSize) {
+    OutputBlock &back = outputBlocks.back();
+    char *frame = back.owned.getData() + back.ownedSize;
+    size_t headerSize = Framing::encodeHeader(decoder.getType(), payloadSize, frame);
+    std::string_view trailer = Framing::frameTrailer(decoder.getType());
+    std::memcpy(frame + headerSize + payloadSize, trailer.data(), trailer.size());
+
+    size_t frameSize = headerSize + payloadSize + trailer.size();
+    back.ownedSize += frameSize;
+    pendingBytes += frameSize;
+}
+
+void Connection::queueView(std::string_view data) {
+    if (data.empty()) {
+        return;
+    }
+
+    bool canExtendBack = outputBlocks.size() > outputHead && outputBlocks.back().isBorrowed() &&
+                         outputBlocks.back().view + outputBlocks.back().viewSize == data.data() &&
+                         !(frontInFlight && outputBlocks.size() == outputHead + 1);
+    if (canExtendBack) {
+        outputBlocks.back().viewSize += data.size();
+    } else {
+        OutputBlock &block = outputBlocks.emplace_back();
+        block.view = data.data();
+        block.viewSize = data.size();
+    }
+    pendingBytes += data.size();
+}
+
+void Connection::materializeViews() {
+    // Views are only queued after the last materialization or pinning, so they all sit at the back
+    size_t firstBorrowed = outputBlocks.size();
+    while (firstBorrowed > outputHead && outputBlocks[firstBorrowed - 1].isBorrowed()) {
+        firstBorrowed--;
+    }
+    if (firstBorrowed == outputBlocks.size()) {
+        return;
+    }
+
+    materializing.clear();
+    for (size_t i = firstBorrowed; i < outputBlocks.size(); i++) {
+        materializing.emplace_back(outputBlocks[i].getBytes().substr(i == outputHead ? frontOffset : 0));
+        pendingBytes -= materializing.back().size();
+    }
+
+    outputBlocks.erase(outputBlocks.begin() + firstBorrowed, outputBlocks.end());
+    if (firstBorrowed == outputHead) {
+        frontOffset = 0;
+    }
+    for (std::string_view view : materializing) {
+        queueOutput(view);
+    }
+}
+
+void Connection::pinViews(Buffer storage) {
+    uint64_t bufferId = firstPinnedBufferId + pinnedBuffers.size();
+    size_t pinnedBlocks = 0;
+
+    for (size_t i = outputHead; i < outputBlocks.size(); i++) {
+        OutputBlock &block = outputBlocks[i];
+        if (block.isBorrowed()) {
+            block.pinned = true;
+            block.pinnedBufferId = bufferId;
+            pinnedBlocks++;
+        }
+    }
+
+    if (pinnedBlocks > 0) {
+        pinnedBuffers.emplace_back(PinnedBuffer{std::move(storage), pinnedBlocks, zeroCopySends});
+    }
+}
+
+size_t Connection::gatherOutput(struct iovec *iov, size_t maxCount, bool &zeroCopy) const {
+    size_t count = 0;
+    zeroCopy = outputBlocks.size() > outputHead && outputBlocks[outputHead].pinned && zeroCopyEnabled;
+
+    for (size_t i = outputHead; i < outputBlocks.size(); i++) {
+        const OutputBlock &block = outputBlocks[i];
+        if (count == maxCount || (block.pinned && zeroCopyEnabled) != zeroCopy) {
+            break;
+        }
+
+        std::string_view bytes = block.getBytes().substr(count == 0 ? frontOffset : 0);
+        iov[count].iov_base = const_cast<char *>(bytes.data());
+        iov[count].iov_len = bytes.size();
+        count++;
+    }
+
+    return count;
+}
+
+void Connection::recordZeroCopySend() {
+    zeroCopySends++;
+
+    // Any pinned buffer with unsent views could have been referenced by the send
+    for (PinnedBuffer &buffer : pinnedBuffers) {
+        if (buffer.unsentBlocks > 0) {
+            buffer.sendsIssued = zeroCopySends;
+        }
+    }
+}
+
+void Connection::completeZeroCopySends(uint32_t lastCompleted) {
+    zeroCopyCompleted = lastCompleted + 1;
+    releasePinnedBuffers();
+}
+
+std::string_view Connection::getFrontOutput() const {
+    if (outputBlocks.size() == outputHead) {
+        return {};
+    }
+    return outputBlocks[outputHead].getBytes().substr(frontOffset);
+}
+
+void Connection::consumeOutput(size_t bytes) {
+    pendingBytes -= bytes;
+
+    while (bytes > 0) {
+        size_t frontRemaining = outputBlocks[outputHead].getBytes().size() - frontOffset;
+        if (bytes < frontRemaining) {
+            frontOffset += bytes;
+            break;
+        }
+
+        bytes -= frontRemaining;
+        popFrontBlock();
+    }
+}
+
+void Connection::discardOutput() {
+    size_t firstDropped = outputHead;
+    if (frontInFlight && outputHead < outputBlocks.size()) {
+        // The kernel still reads from the front block of an asynchronous send
+        discardedFront = std::move(outputBlocks[outputHead]);
+        firstDropped++;
+    }
+    for (size_t i = firstDropped; i < outputBlocks.size(); i++) {
+        if (outputBlocks[i].pinned) {
+            pinnedBuffers[outputBlocks[i].pinnedBufferId - firstPinnedBufferId].unsentBlocks--;
+        }
+    }
+    outputBlocks.clear();
+    outputHead = 0;
+    frontOffset = 0;
+    pendingBytes = 0;
+
+    // The kernel keeps the pages of zero-copy sends from being freed but not from being overwritten, so buffers that
+    // sends still in flight reference are only released once their completions arrive, like after a full send
+    releasePinnedBuffers();
+}
+
+bool Connection::finishFrontSend() {
+    frontInFlight = false;
+    if (!discardedFront.has_value()) {
+        return false;
+    }
+
+    if (discardedFront->pinned) {
+        pinnedBuffers[discardedFront->pinnedBufferId - firstPinnedBufferId].unsentBlocks--;
+    }
+    discardedFront.reset();
+    releasePinnedBuffers();
+    return true;
+}
+
+void Connection::popFrontBlock() {
+    OutputBlock &front = outputBlocks[outputHead];
+    if (front.pinned) {
+        pinnedBuffers[front.pinnedBufferId - firstPinnedBufferId].unsentBlocks--;
+    }
+    front.owned.reset();
+    outputHead++;
+
+    if (outputHead == outputBlocks.size()) {
+        outputBlocks.clear();
+        outputHead = 0;
+    } else if (outputHead > outputBlocks.size() / 2) {
+        outputBlocks.erase(outputBlocks.begin(), outputBlocks.begin() + outputHead);
+        outputHead = 0;
+    }
+    frontOffset = 0;
+    releasePinnedBuffers();
+}
+
+bool Connection::canAppendToBack() const {
+    if (outputBlocks.size() == outputHead) {
+        return false;
+    }
+    const OutputBlock &back = outputBlocks.back();
+    return back.view == nullptr && back.ownedSize < back.owned.getCapacity() &&
+           !(frontInFlight && outputBlocks.size() == outputHead + 1);
+}
+
+void Connection::releasePinnedBuffers() {
+    while (!pinnedBuffers.empty() && pinnedBuffers.front().unsentBlocks == 0 &&
+           static_cast<int32_t>(zeroCopyCompleted - pinnedBuffers.front().sendsIssued) >= 0) {
+        pinnedBuffers.pop_front();
+        firstPinnedBufferId++;
+    }
+}
+} // namespace echo
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "listener/connection_table.hpp"
+
+namespace echo {
+
+Connection &ConnectionTable::insert(int fd, FramingType framing, BufferPool *pool) {
+    size_t pageIdx = static_cast<size_t>(fd) / slotsPerPage;
+    if (pageIdx >= pages.size()) {
+        pages.resize(pageIdx + 1);
+    }
+    if (pages[pageIdx] == nullptr) {
+        pages[pageIdx] = std::make_unique<Slot[]>(slotsPerPage);
+    }
+
+    count++;
+    return pages[pageIdx][fd % slotsPerPage].connection.emplace(fd, framing, pool);
+}
+
+Connection *ConnectionTable::find(int fd) {
+    Slot *slot = findSlot(fd);
+    return slot != nullptr && slot->connection.has_value() ? &*slot->connection : nullptr;
+}
+
+Connection *ConnectionTable::find(ConnectionHandle handle) {
+    Slot *slot = findSlot(handle.fd);
+    if (slot == nullptr || slot->generation != handle.generation || !slot->connection.has_value()) {
+        return nullptr;
+    }
+    return &*slot->connection;
+}
+
+ConnectionHandle ConnectionTable::getHandle(int fd) const {
+    Slot *slot = findSlot(fd);
+    return {fd, slot != nullptr ? slot->generation : 0};
+}
+
+void ConnectionTable::erase(int fd) {
+    Slot *slot = findSlot(fd);
+    if (slot == nullptr || !slot->connection.has_value()) {
+        return;
+    }
+
+    slot->connection.reset();
+    slot->generation = (slot->generation + 1) & ((1u << connectionGenerationBits) - 1);
+    count--;
+}
+
+ConnectionTable::Slot *ConnectionTable::findSlot(int fd) const {
+    size_t pageIdx = static_cast<size_t>(fd) / slotsPerPage;
+    if (fd < 0 || pageIdx >= pages.size() || pages[pageIdx] == nullptr) {
+        return nullptr;
+    }
+    return &pages[pageIdx][fd % slotsPerPage];
+}
+} // namespace echo
\ No newline at end of file
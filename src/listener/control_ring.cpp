@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cstring>
+
+#include "listener/control_ring.hpp"
+
+namespace echo {
+
+bool ControlRing::push(std::string_view message) {
+    uint32_t messageLen = message.size();
+    size_t totalLen = sizeof(messageLen) + messageLen;
+
+    uint64_t produced = tail.load(std::memory_order_relaxed);
+    uint64_t consumed = head.load(std::memory_order_acquire);
+    if (controlRingCapacity - (produced - consumed) < totalLen) {
+        return false;
+    }
+
+    copyIn(produced, &messageLen, sizeof(messageLen));
+    copyIn(produced + sizeof(messageLen), message.data(), messageLen);
+
+    // Published only once the message is whole, the consumer never sees part of it
+    tail.store(produced + totalLen, std::memory_order_release);
+    return true;
+}
+
+bool ControlRing::pop(std::string &message) {
+    uint64_t consumed = head.load(std::memory_order_relaxed);
+    uint64_t produced = tail.load(std::memory_order_acquire);
+    if (consumed == produced) {
+        return false;
+    }
+
+    uint32_t messageLen;
+    copyOut(consumed, &messageLen, sizeof(messageLen));
+    message.resize(messageLen);
+    copyOut(consumed + sizeof(messageLen), message.data(), messageLen);
+
+    // The producer may only reuse the space once the message has been copied out
+    head.store(consumed + sizeof(messageLen) + messageLen, std::memory_order_release);
+    return true;
+}
+
+void ControlRing::copyIn(uint64_t position, const void *bytes, size_t size) {
+    size_t offset = position % controlRingCapacity;
+    size_t firstPart = std::min(size, controlRingCapacity - offset);
+    std::memcpy(data + offset, bytes, firstPart);
+    std::memcpy(data, static_cast<const char *>(bytes) + firstPart, size - firstPart);
+}
+
+void ControlRing::copyOut(uint64_t position, void *bytes, size_t size) const {
+    size_t offset = position % controlRingCapacity;
+    size_t firstPart = std::min(size, controlRingCapacity - offset);
+    std::memcpy(bytes, data + offset, firstPart);
+    std::memcpy(static_cast<char *>(bytes) + firstPart, data, size - firstPart);
+}
+} // namespace echo
\ No newline at end of file
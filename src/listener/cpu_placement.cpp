@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <linux/mempolicy.h>
+#include <map>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <system_error>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "listener/cpu_placement.hpp"
+
+namespace echo {
+
+namespace {
+const std::string nodeSysfsPath = "/sys/devices/system/node/";
+
+std::string readFirstLine(const std::string &path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+} // namespace
+
+CpuTopology CpuTopology::detect() {
+    CpuTopology topology;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Failed to read the CPU affinity of the dispatcher");
+    }
+
+    std::unordered_map<int, int> cpuToNode;
+    for (int node : parseCpuList(readFirstLine(nodeSysfsPath + "online"))) {
+        for (int cpu : parseCpuList(readFirstLine(nodeSysfsPath + "node" + std::to_string(node) + "/cpulist"))) {
+            cpuToNode[cpu] = node;
+        }
+    }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            topology.cpus.emplace_back(cpu);
+            auto node = cpuToNode.find(cpu);
+            topology.cpuNodes.emplace_back(node != cpuToNode.end() ? node->second : 0);
+        }
+    }
+    return topology;
+}
+
+CpuPlacement::CpuPlacement(PlacementPolicy policy, const CpuTopology &topology, size_t cpusPerServer) {
+    std::map<int, std::vector<int>> nodeCpus;
+    for (size_t i = 0; i < topology.cpus.size(); i++) {
+        nodeCpus[topology.cpuNodes[i]].emplace_back(topology.cpus[i]);
+    }
+    bindMemory = nodeCpus.size() > 1;
+
+    // Slots of every node, which are then interleaved so that consecutive servers land on different nodes
+    std::vector<std::vector<ServerPlacement>> nodeSlots;
+    for (auto &[node, cpus] : nodeCpus) {
+        std::sort(cpus.begin(), cpus.end());
+        std::vector<ServerPlacement> &ownSlots = nodeSlots.emplace_back();
+        if (policy == PlacementPolicy::NODE || cpus.size() <= cpusPerServer) {
+            ownSlots.push_back(ServerPlacement{cpus, node});
+            continue;
+        }
+        // CPUs left over after the last full slot stay unused rather than make a smaller server
+        for (size_t first = 0; first + cpusPerServer <= cpus.size(); first += cpusPerServer) {
+            ownSlots.push_back(ServerPlacement{{cpus.begin() + first, cpus.begin() + first + cpusPerServer}, node});
+        }
+    }
+
+    for (size_t round = 0, added = 1; added > 0; round++) {
+        added = 0;
+        for (const std::vector<ServerPlacement> &ownSlots : nodeSlots) {
+            if (round < ownSlots.size()) {
+                slots.emplace_back(ownSlots[round]);
+                added++;
+            }
+        }
+    }
+}
+
+size_t CpuPlacement::pickSlot(const std::vector<int> &slotUses) const {
+    std::vector<size_t> uses(slots.size(), 0);
+    for (int slot : slotUses) {
+        if (slot >= 0 && static_cast<size_t>(slot) < uses.size()) {
+            uses[slot]++;
+        }
+    }
+    return std::min_element(uses.begin(), uses.end()) - uses.begin();
+}
+
+int CpuPlacement::findSlot(int cpu) const {
+    for (size_t slot = 0; slot < slots.size(); slot++) {
+        const std::vector<int> &cpus = slots[slot].cpus;
+        if (std::binary_search(cpus.begin(), cpus.end(), cpu)) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+void CpuPlacement::bindCallingThread(size_t slot) const {
+    const ServerPlacement &placement = slots[slot];
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : placement.cpus) {
+        CPU_SET(cpu, &cpus);
+    }
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Failed to pin the server to its CPUs");
+    }
+
+    if (!bindMemory) {
+        return;
+    }
+    // Preferred rather than bound, so that a full node spills over to the others instead of failing allocations. The
+    // kernel takes one bit more than the highest node it should look at
+    std::vector<unsigned long> nodeMask(placement.node / (8 * sizeof(unsigned long)) + 1, 0);
+    nodeMask[placement.node / (8 * sizeof(unsigned long))] |= 1UL << (placement.node % (8 * sizeof(unsigned long)));
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodeMask.data(), placement.node + 2) == -1) {
+        // Still a pinned server, whose memory mostly ends up local anyway since the kernel allocates on the node of the
+        // CPU the allocating thread runs on
+        std::cerr << "Server " << getpid() << ": failed to prefer the memory of node " << placement.node << ". "
+                  << errno << std::endl;
+    }
+}
+
+PlacementPolicy CpuPlacement::getPlacementPolicy(const std::string &choice) {
+    static const std::unordered_map<std::string, PlacementPolicy> choiceToType = {
+        {"OFF", PlacementPolicy::NONE}, {"CORE", PlacementPolicy::CORE}, {"NODE", PlacementPolicy::NODE}};
+
+    auto it = choiceToType.find(choice);
+    if (it != choiceToType.end()) {
+        return it->second;
+    } else {
+        return PlacementPolicy::UNKNOWN;
+    }
+}
+
+std::vector<int> parseCpuList(std::string_view list) {
+    std::vector<int> cpus;
+    const char *position = list.data();
+    const char *end = list.data() + list.size();
+    while (position < end) {
+        int first;
+        auto [next, error] = std::from_chars(position, end, first);
+        if (error != std::errc()) {
+            return {};
+        }
+
+        int last = first;
+        if (next != end && *next == '-') {
+            auto [rangeEnd, rangeError] = std::from_chars(next + 1, end, last);
+            if (rangeError != std::errc() || last < first) {
+                return {};
+            }
+            next = rangeEnd;
+        }
+        if (next != end && *next != ',') {
+            return {};
+        }
+
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.emplace_back(cpu);
+        }
+        position = next + 1;
+    }
+    return cpus;
+}
+
+std::string formatCpuList(const std::vector<int> &cpus) {
+    std::string list;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t last = i;
+        while (last + 1 < cpus.size() && cpus[last + 1] == cpus[last] + 1) {
+            last++;
+        }
+
+        if (!list.empty()) {
+            list += ',';
+        }
+        list += std::to_string(cpus[i]);
+        if (last > i) {
+            list += '-' + std::to_string(cpus[last]);
+        }
+        i = last + 1;
+    }
+    return list;
+}
+} // namespace echo
\ No newline at end of file
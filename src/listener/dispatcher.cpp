@@ -1,13 +1,18 @@
-#include <array>
+#include <algorithm>
 #include <condition_variable>
 #include <csignal>
-#include <cstring>
 #include <fcntl.h>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <sstream>
+#include <sys/eventfd.h>
 #include <sys/prctl.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
 #include <system_error>
 #include <thread>
 #include <unistd.h>
@@ -20,24 +25,50 @@ namespace {
 volatile std::sig_atomic_t shutdownRequested = false;
 } // namespace
 
-Dispatcher::Dispatcher(int initServerCount) {
+Dispatcher::Dispatcher(int initServerCount, EventLoopType eventLoopType)
+    : Listener(eventLoopType), initServerCount(initServerCount) {
+    serverConfig.eventLoopType = eventLoopType;
     servers.reserve(initServerCount);
 
     this->addListenerSocket(std::make_unique<InetSocket>(startPort));
     this->addListenerSocket(std::make_unique<UnixSocket>(startUnixPath));
 
-    while (--initServerCount >= 0) {
-        startServer();
-    }
-
     inputToCommand["--set-response-schema"] = std::make_unique<ResponseSchemaCliCommand>(*this);
+    inputToCommand["--event-loop"] = std::make_unique<EventLoopCliCommand>(*this);
+    inputToCommand["--server-threads"] = std::make_unique<ServerThreadsCliCommand>(*this);
+    inputToCommand["--max-clients"] = std::make_unique<MaxClientsCliCommand>(*this);
+    inputToCommand["--listen-backlog"] = std::make_unique<ListenBacklogCliCommand>(*this);
+    inputToCommand["--huge-pages"] = std::make_unique<HugePagesCliCommand>(*this);
+    inputToCommand["--handoff"] = std::make_unique<HandoffCliCommand>(*this);
+    inputToCommand["--reuseport"] = std::make_unique<ReusePortCliCommand>(*this);
+    inputToCommand["--redirect"] = std::make_unique<RedirectCliCommand>(*this);
+    inputToCommand["--workers"] = std::make_unique<WorkersCliCommand>(*this);
+    inputToCommand["--placement"] = std::make_unique<PlacementCliCommand>(*this);
+    inputToCommand["--balancing"] = std::make_unique<BalancingCliCommand>(*this);
+    inputToCommand["--add-servers"] = std::make_unique<AddServersCliCommand>(*this);
+    inputToCommand["--remove-server"] = std::make_unique<RemoveServerCliCommand>(*this);
+    inputToCommand["--autoscale"] = std::make_unique<AutoscaleCliCommand>(*this);
+    inputToCommand["--list-servers"] = std::make_unique<ListServersCliCommand>(*this);
+    inputToCommand["--framing"] = std::make_unique<FramingCliCommand>(*this);
     inputToCommand["--help"] = std::make_unique<DispatcherHelpCliCommand>(*this);
 }
 
 Dispatcher::~Dispatcher() {
+    if (workerMode == WorkerMode::THREAD) {
+        for (auto &[exitFd, worker] : workerThreads) {
+            worker.server->stop();
+        }
+        // Joins every thread before destroying its server
+        workerThreads.clear();
+        return;
+    }
+
     for (int i = 0; i < servers.size(); i++) {
         kill(getServerPidAtIdx(i), SIGTERM);
     }
+    for (const RemovedServer &server : retiringServers) {
+        kill(server.process.pid, SIGTERM);
+    }
 }
 
 void Dispatcher::signalHandler(int signum) {
@@ -50,14 +81,50 @@ void Dispatcher::start() {
     std::signal(SIGINT, Dispatcher::signalHandler);
     std::signal(SIGTERM, Dispatcher::signalHandler);
 
+    // Until a client socket has been handed over to a server, the dispatcher holds it open as well
+    raiseOpenFileLimit(RLIM_INFINITY);
+
+    if (reusePortSteering != ReusePortSteering::NONE) {
+        // The servers bind the Internet port themselves, which the dispatcher has to release first
+        std::erase_if(listenerPool, [this](const AbstractSocket &listener) {
+            bool isInet = dynamic_cast<InetSocket *>(listener.get()) != nullptr;
+            if (isInet) {
+                inetFraming = listener->getFraming();
+            }
+            return isInet;
+        });
+    }
+
+    if (placementPolicy != PlacementPolicy::NONE) {
+        // Every reactor of a server gets a CPU of its own
+        size_t cpusPerServer = serverConfig.reactorCount;
+        cpuPlacement = std::make_unique<CpuPlacement>(placementPolicy, CpuTopology::detect(), cpusPerServer);
+    }
+
+    // Servers are started here rather than in the constructor so that startup options can configure them first
+    {
+        std::lock_guard<std::mutex> lock(poolChangesMutex);
+        started = true;
+    }
+    for (int i = 0; i < initServerCount; i++) {
+        startServer();
+    }
+
     prepareListenerSockets();
+    for (const ServerHandle &server : servers) {
+        listenerEventLoop->add(server.pidFd, POLLIN);
+    }
 
     std::jthread userInput([this](std::stop_token st) { this->cliInputHandler(st); });
 
     while (!shutdownRequested) {
-        if (pollListenerSockets() != -1) {
+        if (pollListenerSockets(supervisionIntervalMs) > 0) {
+            // Crashed servers leave the pool before any client is handed to them
+            handleExitedServers();
             forwardIncomingConnections();
+            flushServerChannels();
         }
+        superviseServers();
     }
 
     userInput.request_stop();
@@ -65,66 +132,642 @@ void Dispatcher::start() {
 }
 
 void Dispatcher::startServer() {
-    latestServerId++;
+    if (spawnServer(latestServerId + 1, 0)) {
+        latestServerId++;
+    }
+}
 
-    std::string pipeName = serverIdToPipePath(latestServerId);
-    mkfifo(pipeName.c_str(), O_RDWR);
-    chmod(pipeName.c_str(), S_IRUSR | S_IWUSR);
+bool Dispatcher::spawnServer(int serverId, int restarts) {
+    // Mapped before the server starts, so that it publishes its load into memory the dispatcher sees
+    ServerLoadMonitor loadMonitor(serverId);
+    int placementSlot = pickPlacementSlot();
+    if (workerMode == WorkerMode::THREAD) {
+        return spawnServerThread(serverId, restarts, std::move(loadMonitor), placementSlot);
+    }
+
+    std::string pipeName;
+    int channelFds[2] = {-1, -1};
+    if (handoffTransport == HandoffTransport::SOCKETPAIR) {
+        // SOCK_SEQPACKET keeps the messages of a packet together with the client sockets attached to them
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, channelFds) == -1) {
+            std::cerr << "Failed to create the channel of the new server process. " << errno << std::endl;
+            return false;
+        }
+    } else {
+        pipeName = serverIdToPipePath(serverId);
+        mkfifo(pipeName.c_str(), O_RDWR);
+        chmod(pipeName.c_str(), S_IRUSR | S_IWUSR);
+    }
 
     int pid = fork();
 
     if (pid == -1) {
-        latestServerId--;
         std::cerr << "Failed to start the new server process. " << errno << std::endl;
+        if (channelFds[0] != -1) {
+            close(channelFds[0]);
+            close(channelFds[1]);
+        }
+        return false;
     } else if (pid == 0) {
         // Child process
-        // After the server is finished running, clean it up and exit out of the child process
-        {
-            Server server(pipeName);
-            server.addListenerSocket(std::make_unique<UnixSocket>(serverIdToUnixPath(latestServerId)));
-            server.addListenerSocket(std::make_unique<InetSocket>(serverIdToPort(latestServerId)));
-            server.start();
+        // The channels of the other servers belong to the dispatcher, the server would only keep them from closing
+        for (const ServerHandle &server : servers) {
+            close(server.pidFd);
+        }
+        for (const RemovedServer &server : retiringServers) {
+            close(server.process.pidFd);
+        }
+        serverChannels.clear();
+        retiringServers.clear();
+
+        // After the server is finished running, clean it up and exit out of the child process. A server failing to
+        // start must not return into the dispatcher's loop either
+        try {
+            // Placed before the server allocates anything, so that its memory comes from its own node
+            if (placementSlot != -1) {
+                cpuPlacement->bindCallingThread(placementSlot);
+            }
+
+            std::unique_ptr<Server> server;
+            if (channelFds[0] != -1) {
+                close(channelFds[0]);
+                server = std::make_unique<Server>(channelFds[1], serverConfig);
+            } else {
+                server = std::make_unique<Server>(pipeName, serverConfig);
+            }
+            server->shareControlBlock(loadMonitor.getControlBlock());
+            prepareServer(*server, serverId, placementSlot);
+            server->start();
+        } catch (const std::runtime_error &e) {
+            std::cerr << "Server " << getpid() << " failed: " << e.what() << std::endl;
+            std::exit(1);
         }
         std::exit(0);
     } else {
         // Parent process
+        int pidFd = syscall(SYS_pidfd_open, pid, 0);
+        if (pidFd == -1) {
+            // A server the dispatcher can't watch would go unnoticed if it crashed
+            std::cerr << "Failed to open a pidfd for server process " << pid << ". " << errno << std::endl;
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            if (channelFds[0] != -1) {
+                close(channelFds[0]);
+                close(channelFds[1]);
+            }
+            return false;
+        }
 
-        // Disable Yama security module for the parent process
-        // https://manpages.ubuntu.com/manpages/focal/en/man2/prctl.2.html
-        // https://stackoverflow.com/questions/75045206/eperm-on-pidfd-getfd-with-socket/76114536#76114536
-        prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY);
+        ControlRing &commandRing = loadMonitor.getControlBlock().commands;
+        std::unique_ptr<ServerChannel> channel;
+        if (channelFds[0] != -1) {
+            close(channelFds[1]);
+            channel = std::make_unique<ServerChannel>(channelFds[0], commandRing);
+        } else {
+            // Disable Yama security module for the parent process
+            // https://manpages.ubuntu.com/manpages/focal/en/man2/prctl.2.html
+            // https://stackoverflow.com/questions/75045206/eperm-on-pidfd-getfd-with-socket/76114536#76114536
+            prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY);
+            channel = std::make_unique<ServerChannel>(pipeName, commandRing);
+        }
 
-        servers.push_back(std::make_pair(pid, latestServerId));
+        addToPool(ServerHandle{pid, serverId, pidFd, restarts, std::chrono::steady_clock::now(), placementSlot},
+                  std::move(channel), std::move(loadMonitor));
     }
+    return true;
 }
 
-void Dispatcher::forwardIncomingConnections() {
-    for (size_t i = 0, end = listenerFds.size(); i < end; i++) {
-        if (!(listenerFds[i].revents & POLLIN)) {
+bool Dispatcher::spawnServerThread(int serverId, int restarts, ServerLoadMonitor loadMonitor, int placementSlot) {
+    // Becomes readable once the thread is done, standing in for the pidfd of a server process
+    int exitFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (exitFd == -1) {
+        std::cerr << "Failed to create the exit eventfd of the new server thread. " << errno << std::endl;
+        return false;
+    }
+
+    std::shared_ptr<InProcessPipe> pipe;
+    std::unique_ptr<Server> server;
+    try {
+        pipe = std::make_shared<InProcessPipe>();
+        server = std::make_unique<Server>(pipe, serverConfig);
+        server->shareControlBlock(loadMonitor.getControlBlock());
+        prepareServer(*server, serverId, placementSlot);
+    } catch (const std::runtime_error &e) {
+        std::cerr << "Failed to start the new server thread: " << e.what() << std::endl;
+        close(exitFd);
+        return false;
+    }
+
+    // Termination signals are left to the dispatcher's thread, which stops the servers itself
+    sigset_t terminationSignals;
+    sigset_t previousMask;
+    sigemptyset(&terminationSignals);
+    sigaddset(&terminationSignals, SIGINT);
+    sigaddset(&terminationSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &terminationSignals, &previousMask);
+    std::jthread thread([this, running = server.get(), placementSlot, exitFd]() {
+        try {
+            if (placementSlot != -1) {
+                cpuPlacement->bindCallingThread(placementSlot);
+            }
+            running->start();
+        } catch (const std::runtime_error &e) {
+            std::cerr << "Server thread failed: " << e.what() << std::endl;
+        }
+        uint64_t one = 1;
+        write(exitFd, &one, sizeof(one));
+    });
+    pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+
+    auto channel = std::make_unique<ServerChannel>(std::move(pipe), loadMonitor.getControlBlock().commands);
+    workerThreads.emplace(exitFd, WorkerThread{std::move(server), std::move(thread)});
+    addToPool(ServerHandle{getpid(), serverId, exitFd, restarts, std::chrono::steady_clock::now(), placementSlot},
+              std::move(channel), std::move(loadMonitor));
+    return true;
+}
+
+int Dispatcher::pickPlacementSlot() {
+    if (cpuPlacement == nullptr) {
+        return -1;
+    }
+
+    // Retiring servers still run on their CPUs, so they count as well. A respawn usually gets the slot of the server it
+    // replaces, which is the one freed
+    std::vector<int> slotUses;
+    for (const ServerHandle &server : servers) {
+        slotUses.emplace_back(server.placementSlot);
+    }
+    for (const RemovedServer &server : retiringServers) {
+        slotUses.emplace_back(server.process.placementSlot);
+    }
+    return cpuPlacement->pickSlot(slotUses);
+}
+
+void Dispatcher::prepareServer(Server &server, int serverId, int placementSlot) {
+    server.setListenBacklog(listenBacklog);
+    if (reusePortSteering != ReusePortSteering::NONE) {
+        auto listener = std::make_unique<InetSocket>(startPort, true);
+        InetSocket &sharedListener = *listener;
+        listener->setFraming(inetFraming);
+        server.acceptClientsFrom(std::move(listener));
+        const std::vector<int> *placedCpus =
+            placementSlot != -1 ? &cpuPlacement->getPlacement(placementSlot).cpus : nullptr;
+        if (steerToIncomingCpu && placedCpus != nullptr && placedCpus->size() == 1) {
+            // The kernel prefers the socket whose incoming CPU received the connection, unless the group has a
+            // steering program
+            sharedListener.setIncomingCpu(placedCpus->front());
+        } else {
+            // Replaces the program of the group, so connections are steered over the grown pool
+            sharedListener.steerReusePortGroup(reusePortSteering, servers.size() + 1);
+        }
+    }
+    if (redirectClients) {
+        // Redirected clients reconnect to listeners of the server speaking the framing of the dispatcher's
+        for (const AbstractSocket &listener : listenerPool) {
+            AbstractSocket ownListener;
+            if (dynamic_cast<UnixSocket *>(listener.get()) != nullptr) {
+                ownListener = std::make_unique<UnixSocket>(serverIdToUnixPath(serverId));
+            } else {
+                ownListener = std::make_unique<InetSocket>(serverIdToPort(serverId));
+            }
+            ownListener->setFraming(listener->getFraming());
+            server.acceptClientsFrom(std::move(ownListener));
+        }
+    }
+}
+
+void Dispatcher::addToPool(const ServerHandle &process, std::unique_ptr<ServerChannel> channel,
+                           ServerLoadMonitor loadMonitor) {
+    if (listenerEventLoop != nullptr) {
+        listenerEventLoop->add(process.pidFd, POLLIN);
+    }
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (responseSchema.version != 0) {
+        sendControlMessage(*channel, process, ControlMessageType::SET_RESPONSE_SCHEMA, encodedResponseSchema);
+    }
+    servers.push_back(process);
+    serverChannels.emplace_back(std::move(channel));
+    channelOutputWatched.emplace_back(false);
+    serverLoads.emplace_back(std::move(loadMonitor));
+    if (workerMode == WorkerMode::THREAD) {
+        std::cout << "Started server " << process.id << " (thread)" << std::endl;
+    } else {
+        std::cout << "Started server " << process.id << " (pid " << process.pid << ")" << std::endl;
+    }
+}
+
+void Dispatcher::superviseServers() {
+    auto now = std::chrono::steady_clock::now();
+    if (now < nextSupervision || shutdownRequested) {
+        // Servers exiting along with the dispatcher (e.g on a signal sent to the whole process group) aren't respawned
+        return;
+    }
+    nextSupervision = now + std::chrono::milliseconds(supervisionIntervalMs);
+
+    // Only this thread changes the pool, so it reads the pool without locking it
+    int serversToStart;
+    std::vector<int> idsToRetire;
+    {
+        std::lock_guard<std::mutex> lock(poolChangesMutex);
+        serversToStart = std::exchange(requestedServers, 0);
+        idsToRetire.swap(serverIdsToRetire);
+
+        // Crashed servers are replaced by their respawns, so the pool is only scaled once they are back
+        if (autoscaler != nullptr && crashedServers.empty()) {
+            int change = autoscaler->getPoolChange(serverLoads, now);
+            if (change > 0) {
+                serversToStart++;
+            } else if (change < 0 && !serverLoads.empty()) {
+                idsToRetire.emplace_back(getServerIdAtIdx(Autoscaler::pickServerToRetire(serverLoads)));
+            }
+        }
+    }
+
+    for (; serversToStart > 0; serversToStart--) {
+        startServer();
+    }
+    for (int serverId : idsToRetire) {
+        retireServer(serverId);
+    }
+
+    std::erase_if(crashedServers, [this, now](const CrashedServer &crashed) {
+        // A failed respawn is retried on the next supervision
+        return crashed.respawnAt <= now && spawnServer(crashed.id, crashed.restarts);
+    });
+}
+
+void Dispatcher::retireServer(int serverId) {
+    auto found = std::find_if(servers.begin(), servers.end(),
+                              [serverId](const ServerHandle &server) { return server.id == serverId; });
+    if (found == servers.end()) {
+        std::cout << "No running server with ID " << serverId << std::endl;
+        return;
+    } else if (servers.size() == 1) {
+        std::cout << "The last running server can't be removed" << std::endl;
+        return;
+    }
+
+    size_t idx = found - servers.begin();
+    std::lock_guard<std::mutex> lock(poolMutex);
+    RemovedServer retiring = removeFromPool(idx);
+
+    // Clients still queued to the server reach it before the command
+    sendControlMessage(*retiring.channel, retiring.process, ControlMessageType::RETIRE);
+    retiringServers.emplace_back(std::move(retiring));
+    std::cout << "Retiring server " << serverId << std::endl;
+}
+
+void Dispatcher::sendControlMessage(ServerChannel &channel, const ServerHandle &server, ControlMessageType type,
+                                    std::string_view payload) {
+    if (!channel.queueControlMessage(type, payload)) {
+        // Only a server that stopped taking its commands fills up its ring
+        std::cerr << "Command ring of server " << server.id << " is full, dropped a command" << std::endl;
+        return;
+    }
+    channel.flushBlocking(server.pidFd);
+}
+
+Dispatcher::RemovedServer Dispatcher::removeFromPool(size_t idx) {
+    if (channelOutputWatched[idx]) {
+        listenerEventLoop->remove(serverChannels[idx]->getSpaceFd());
+    }
+
+    RemovedServer removed{servers[idx], std::move(serverLoads[idx]), std::move(serverChannels[idx])};
+    servers.erase(servers.begin() + idx);
+    serverChannels.erase(serverChannels.begin() + idx);
+    channelOutputWatched.erase(channelOutputWatched.begin() + idx);
+    serverLoads.erase(serverLoads.begin() + idx);
+    return removed;
+}
+
+void Dispatcher::handleExitedServers() {
+    auto now = std::chrono::steady_clock::now();
+    for (const ReadyEvent &event : readyListeners) {
+        if (findListener(event.fd) != nullptr) {
             continue;
         }
 
-        // TODO: check if the process is still running?
-        int nextIdx = (lastReceivingServerIdx++) % servers.size();
-        int serverPid = getServerPidAtIdx(nextIdx);
-        int pipeFd = open(serverIdToPipePath(getServerIdAtIdx(nextIdx)).c_str(), O_WRONLY);
-        if (pipeFd == -1) {
-            throw std::system_error(errno, std::generic_category(), "Failed to open the dispatcher->server pipe");
+        auto crashed = std::find_if(servers.begin(), servers.end(),
+                                    [&event](const ServerHandle &server) { return server.pidFd == event.fd; });
+        if (crashed != servers.end()) {
+            ServerHandle server = *crashed;
+            {
+                // Clients still queued to the server are closed along with its channel
+                std::lock_guard<std::mutex> lock(poolMutex);
+                removeFromPool(crashed - servers.begin());
+            }
+
+            bool crashLooping = now - server.startedAt < minServerUptime;
+            crashedServers.push_back(
+                CrashedServer{server.id, server.restarts + 1, crashLooping ? now + crashRespawnDelay : now});
+            std::cout << "Server " << server.id << " " << reapServer(server) << ", respawning it (restart "
+                      << server.restarts + 1 << ")" << std::endl;
+            continue;
         }
 
-        int clientFd = listenerPool[i]->setupNewConnection();
+        std::lock_guard<std::mutex> lock(poolMutex);
+        auto retired =
+            std::find_if(retiringServers.begin(), retiringServers.end(),
+                         [&event](const RemovedServer &server) { return server.process.pidFd == event.fd; });
+        if (retired != retiringServers.end()) {
+            std::cout << "Server " << retired->process.id << " retired" << std::endl;
+            reapServer(retired->process);
+            retiringServers.erase(retired);
+        }
+    }
+}
 
-        std::array<std::byte, sizeof(std::byte) + sizeof(int)> clientFdBuf;
-        clientFdBuf[0] = newClientFdPipeFlag;
-        std::memcpy(&clientFdBuf[sizeof(std::byte)], &clientFd, sizeof(int));
+std::string Dispatcher::reapServer(const ServerHandle &server) {
+    listenerEventLoop->remove(server.pidFd);
 
-        ssize_t bytesWritten = write(pipeFd, &clientFdBuf, sizeof(clientFdBuf));
-        if (bytesWritten == -1) {
-            close(pipeFd);
-            throw std::system_error(errno, std::generic_category(), "Failed to write to the dispatcher->server pipe");
+    // The pidfd (or exit eventfd) being readable means the server is done, so this never blocks
+    int status = 0;
+    if (workerMode == WorkerMode::THREAD) {
+        workerThreads.erase(server.pidFd);
+    } else {
+        waitpid(server.pid, &status, WNOHANG);
+    }
+    close(server.pidFd);
+
+    // The server removes them itself, unless it didn't get to. Its respawn binds the same paths
+    unlink(serverIdToPipePath(server.id).c_str());
+    unlink(serverIdToUnixPath(server.id).c_str());
+
+    if (workerMode == WorkerMode::THREAD) {
+        return "stopped";
+    } else if (WIFSIGNALED(status)) {
+        return "was killed by signal " + std::to_string(WTERMSIG(status));
+    }
+    return "exited with status " + std::to_string(WEXITSTATUS(status));
+}
+
+void Dispatcher::addServers(int count) {
+    std::lock_guard<std::mutex> lock(poolChangesMutex);
+    if (started) {
+        requestedServers += count;
+    } else {
+        initServerCount += count;
+    }
+}
+
+void Dispatcher::removeServer(int serverId) {
+    std::lock_guard<std::mutex> lock(poolChangesMutex);
+    serverIdsToRetire.emplace_back(serverId);
+}
+
+void Dispatcher::setAutoscaler(std::unique_ptr<Autoscaler> newAutoscaler) {
+    std::lock_guard<std::mutex> lock(poolChangesMutex);
+    autoscaler = std::move(newAutoscaler);
+}
+
+bool Dispatcher::setEventLoopType(EventLoopType type) {
+    if (started) {
+        return false;
+    }
+    eventLoopType = type;
+    serverConfig.eventLoopType = type;
+    return true;
+}
+
+bool Dispatcher::setServerThreadCount(int threadCount) {
+    if (started) {
+        return false;
+    }
+    serverConfig.reactorCount = threadCount;
+    return true;
+}
+
+bool Dispatcher::setMaxClients(int maxClients) {
+    if (started) {
+        return false;
+    }
+    serverConfig.maxClients = maxClients;
+    return true;
+}
+
+bool Dispatcher::setHugePages(bool enabled) {
+    if (started) {
+        return false;
+    }
+    serverConfig.hugePages = enabled;
+    return true;
+}
+
+bool Dispatcher::setHandoffTransport(HandoffTransport transport) {
+    if (started) {
+        return false;
+    }
+    handoffTransport = transport;
+    return true;
+}
+
+bool Dispatcher::setReusePortSteering(ReusePortSteering steering) {
+    if (started) {
+        return false;
+    }
+    reusePortSteering = steering;
+    return true;
+}
+
+bool Dispatcher::setRedirect(bool enabled) {
+    if (started) {
+        return false;
+    }
+    redirectClients = enabled;
+    return true;
+}
+
+bool Dispatcher::setFraming(bool unixListeners, FramingType framing) {
+    if (started) {
+        return false;
+    }
+    for (const AbstractSocket &listener : getListenerPool()) {
+        bool isUnix = dynamic_cast<UnixSocket *>(listener.get()) != nullptr;
+        if (isUnix == unixListeners) {
+            listener->setFraming(framing);
         }
+    }
+    return true;
+}
+
+bool Dispatcher::setWorkerMode(WorkerMode mode) {
+    if (started) {
+        return false;
+    }
+    workerMode = mode;
+    return true;
+}
+
+WorkerMode Dispatcher::getWorkerMode(const std::string &choice) {
+    static const std::unordered_map<std::string, WorkerMode> choiceToType = {{"PROCESS", WorkerMode::PROCESS},
+                                                                             {"THREAD", WorkerMode::THREAD}};
 
-        close(pipeFd);
+    auto it = choiceToType.find(choice);
+    if (it != choiceToType.end()) {
+        return it->second;
+    } else {
+        return WorkerMode::UNKNOWN;
+    }
+}
+
+bool Dispatcher::setPlacement(PlacementPolicy policy, bool incomingCpu) {
+    if (started) {
+        return false;
+    }
+    placementPolicy = policy;
+    steerToIncomingCpu = incomingCpu;
+    return true;
+}
+
+void Dispatcher::setBalancingStrategy(AbstractBalancingStrategy strategy) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    balancingStrategy = std::move(strategy);
+}
+
+void Dispatcher::listServers() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    // Built apart from std::cout, so that the number formatting doesn't stick to it
+    std::ostringstream table;
+    table << "Latest response schema version: " << responseSchema.version << '\n';
+    table << std::setw(4) << "ID" << std::setw(9) << "PID" << std::setw(10) << "STATE" << std::setw(11) << "CPUS"
+          << std::setw(5) << "NODE" << std::setw(9) << "RESTARTS" << std::setw(7) << "SCHEMA" << std::setw(9)
+          << "CLIENTS" << std::setw(13) << "MESSAGES" << std::setw(15) << "BYTES IN" << std::setw(15) << "BYTES OUT"
+          << std::setw(10) << "LOAD" << std::setw(11) << "P50 US" << std::setw(11) << "P99 US" << '\n';
+    table << std::fixed;
+
+    // Latencies are those of the reactors' batches of work, as the upper bounds of their histogram buckets. SCHEMA is
+    // the version of the response schema the server switched to, so a rollout is done once it matches everywhere
+    auto print = [this, &table](const ServerHandle &server, const ServerLoadMonitor &monitor, const char *state) {
+        std::string cpus = "-";
+        std::string node = "-";
+        if (server.placementSlot != -1) {
+            const ServerPlacement &placement = cpuPlacement->getPlacement(server.placementSlot);
+            cpus = formatCpuList(placement.cpus);
+            node = std::to_string(placement.node);
+        }
+
+        ServerStats stats = monitor.getStats();
+        uint64_t schemaVersion = monitor.getControlBlock().schemaVersion.load(std::memory_order_acquire);
+        table << std::setw(4) << server.id << std::setw(9) << server.pid << std::setw(10) << state << std::setw(11)
+              << cpus << std::setw(5) << node << std::setw(9) << server.restarts << std::setw(7) << schemaVersion
+              << std::setw(9) << monitor.getClientCount() << std::setw(13) << stats.messages << std::setw(15)
+              << stats.bytesReceived << std::setw(15) << stats.bytesSent << std::setw(10) << std::setprecision(2)
+              << monitor.getLoadScore() << std::setprecision(0) << std::setw(11) << stats.getLatencyPercentileMicros(50)
+              << std::setw(11) << stats.getLatencyPercentileMicros(99) << '\n';
+    };
+    for (size_t i = 0; i < servers.size(); i++) {
+        print(servers[i], serverLoads[i], "running");
+    }
+    for (const RemovedServer &server : retiringServers) {
+        print(server.process, server.monitor, "retiring");
+    }
+    std::cout << table.str() << std::flush;
+}
+
+uint64_t Dispatcher::setResponseSchema(SchemaDescriptor descriptor) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    descriptor.version = responseSchema.version + 1;
+    responseSchema = std::move(descriptor);
+
+    // Encoded once for all servers, which build the schema from it without parsing anything
+    encodedResponseSchema = responseSchema.encode();
+
+    // Commands are rare, so the CLI thread simply waits until every server has room for the command, or is gone
+    for (size_t i = 0; i < serverChannels.size(); i++) {
+        sendControlMessage(*serverChannels[i], servers[i], ControlMessageType::SET_RESPONSE_SCHEMA,
+                           encodedResponseSchema);
+    }
+    for (const RemovedServer &server : retiringServers) {
+        sendControlMessage(*server.channel, server.process, ControlMessageType::SET_RESPONSE_SCHEMA,
+                           encodedResponseSchema);
+    }
+    return responseSchema.version;
+}
+
+void Dispatcher::forwardIncomingConnections() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    for (const ReadyEvent &event : readyListeners) {
+        ISocket *listener = findListener(event.fd);
+        if (listener == nullptr || !(event.events & POLLIN)) {
+            continue;
+        }
+
+        // The queue is drained in bounded batches, a listener with more pending is reported ready again right away
+        for (size_t accepted = 0; accepted < maxAcceptBatch; accepted++) {
+            int clientFd = listener->setupNewConnection();
+            if (clientFd == INVALID_SOCKET_FD) {
+                break;
+            }
+
+            if (serverLoads.empty()) {
+                close(clientFd);
+                continue;
+            }
+
+            size_t serverIdx = pickServer(clientFd);
+            if (redirectClients) {
+                // Not recorded as dispatched, the server only sees the client once it reconnected, if it ever does
+                redirectClient(clientFd, *listener, serverIdx);
+                continue;
+            }
+            serverLoads[serverIdx].recordDispatchedClient();
+            serverChannels[serverIdx]->queueClient(clientFd, listener->getFraming());
+        }
+    }
+}
+
+size_t Dispatcher::pickServer(int clientFd) {
+    if (steerToIncomingCpu && cpuPlacement != nullptr) {
+        // Unix domain clients have no incoming CPU (-1)
+        int cpu = -1;
+        socklen_t cpuLen = sizeof(cpu);
+        getsockopt(clientFd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &cpuLen);
+        int slot = cpu >= 0 ? cpuPlacement->findSlot(cpu) : -1;
+
+        std::optional<size_t> picked;
+        for (size_t i = 0; i < servers.size() && slot != -1; i++) {
+            if (servers[i].placementSlot == slot &&
+                (!picked.has_value() || serverLoads[i].getClientCount() < serverLoads[*picked].getClientCount())) {
+                picked = i;
+            }
+        }
+        if (picked.has_value()) {
+            return *picked;
+        }
+    }
+    return balancingStrategy->pickServer(serverLoads);
+}
+
+void Dispatcher::redirectClient(int clientFd, const ISocket &listener, size_t serverIdx) {
+    int serverId = getServerIdAtIdx(serverIdx);
+    std::string redirect = redirectPrefix;
+    if (dynamic_cast<const UnixSocket *>(&listener) != nullptr) {
+        redirect += serverIdToUnixPath(serverId);
+    } else {
+        redirect += std::to_string(serverIdToPort(serverId));
+    }
+    redirect += '\n';
+
+    // The line fits the send buffer of a new connection, and the client sends nothing before reading it, so closing
+    // right away still delivers it
+    send(clientFd, redirect.data(), redirect.size(), MSG_NOSIGNAL);
+    close(clientFd);
+}
+
+void Dispatcher::flushServerChannels() {
+    for (size_t i = 0; i < serverChannels.size(); i++) {
+        // A full pipe is retried once the server has read from it, by watching the channel for room until then
+        bool flushed = serverChannels[i]->flush();
+        if (flushed == channelOutputWatched[i]) {
+            if (flushed) {
+                listenerEventLoop->remove(serverChannels[i]->getSpaceFd());
+            } else {
+                listenerEventLoop->add(serverChannels[i]->getSpaceFd(), serverChannels[i]->getSpaceEvents());
+            }
+            channelOutputWatched[i] = !flushed;
+        }
     }
 }
 
@@ -6,9 +6,7 @@ int main(int argc, char *argv[]) {
         auto dispatcher = echo::Dispatcher(3);
 
         std::vector<std::string> allArgs(argv, argv + argc);
-        auto tokens = std::make_unique<echo::StartupTokens>(allArgs);
-        auto optionTok = tokens->getOption();
-        if (!optionTok.empty()) {
+        for (auto &tokens : echo::StartupTokens::splitByOption(allArgs)) {
             if (dispatcher.executeCommand(std::move(tokens)) == false) {
                 dispatcher.executeCommand(std::make_unique<echo::StartupTokens>("./dispatcher --help"));
             }
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <system_error>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "listener/event_loop.hpp"
+
+namespace echo {
+
+namespace {
+const int maxEpollEvents = 1024;
+} // namespace
+
+void PollEventLoop::add(int fd, uint32_t events) {
+    if (static_cast<size_t>(fd) >= fdToIdx.size()) {
+        fdToIdx.resize(std::max<size_t>(fd + 1, 2 * fdToIdx.size()), -1);
+    }
+    fdToIdx[fd] = fdsToPoll.size();
+    fdsToPoll.emplace_back(pollfd{fd, static_cast<short>(events), 0});
+}
+
+void PollEventLoop::modify(int fd, uint32_t events) {
+    if (static_cast<size_t>(fd) < fdToIdx.size() && fdToIdx[fd] != -1) {
+        fdsToPoll[fdToIdx[fd]].events = static_cast<short>(events);
+    }
+}
+
+void PollEventLoop::remove(int fd) {
+    if (static_cast<size_t>(fd) >= fdToIdx.size() || fdToIdx[fd] == -1) {
+        return;
+    }
+
+    // Swap with the last element so the removal doesn't shift the rest of the poll set
+    size_t idx = fdToIdx[fd];
+    fdToIdx[fd] = -1;
+    if (idx != fdsToPoll.size() - 1) {
+        fdsToPoll[idx] = fdsToPoll.back();
+        fdToIdx[fdsToPoll[idx].fd] = idx;
+    }
+    fdsToPoll.pop_back();
+}
+
+int PollEventLoop::wait(std::vector<ReadyEvent> &ready, int timeoutMs) {
+    ready.clear();
+
+    int numReady = poll(fdsToPoll.data(), fdsToPoll.size(), timeoutMs);
+    if (numReady == -1) {
+        if (errno != EINTR) {
+            throw std::system_error(errno, std::generic_category(), "Poll event loop wait error");
+        }
+        return -1;
+    }
+
+    for (size_t i = 0, end = fdsToPoll.size(); i < end && ready.size() < static_cast<size_t>(numReady); i++) {
+        if (fdsToPoll[i].revents != 0) {
+            ready.emplace_back(ReadyEvent{fdsToPoll[i].fd, static_cast<uint32_t>(fdsToPoll[i].revents)});
+        }
+    }
+
+    return numReady;
+}
+
+EpollEventLoop::EpollEventLoop(bool edgeTriggered) : edgeTriggered(edgeTriggered) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1) {
+        throw std::system_error(errno, std::generic_category(), "Epoll instance creation error");
+    }
+    epollEvents.resize(maxEpollEvents);
+}
+
+EpollEventLoop::~EpollEventLoop() { close(epollFd); }
+
+void EpollEventLoop::control(int operation, int fd, uint32_t events) {
+    // poll(2) and epoll(7) share the values of the IN/OUT/HUP/ERR flags, so they can be passed through unchanged
+    struct epoll_event event {};
+    event.events = events | (edgeTriggered ? static_cast<uint32_t>(EPOLLET) : 0u);
+    event.data.fd = fd;
+
+    if (epoll_ctl(epollFd, operation, fd, &event) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Epoll control error");
+    }
+}
+
+void EpollEventLoop::add(int fd, uint32_t events) { control(EPOLL_CTL_ADD, fd, events); }
+
+void EpollEventLoop::modify(int fd, uint32_t events) { control(EPOLL_CTL_MOD, fd, events); }
+
+void EpollEventLoop::remove(int fd) {
+    if (epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr) == -1 && errno != EBADF && errno != ENOENT) {
+        throw std::system_error(errno, std::generic_category(), "Epoll removal error");
+    }
+}
+
+int EpollEventLoop::wait(std::vector<ReadyEvent> &ready, int timeoutMs) {
+    ready.clear();
+
+    int numReady = epoll_wait(epollFd, epollEvents.data(), epollEvents.size(), timeoutMs);
+    if (numReady == -1) {
+        if (errno != EINTR) {
+            throw std::system_error(errno, std::generic_category(), "Epoll event loop wait error");
+        }
+        return -1;
+    }
+
+    for (int i = 0; i < numReady; i++) {
+        ready.emplace_back(ReadyEvent{epollEvents[i].data.fd, epollEvents[i].events & ~EPOLLET});
+    }
+
+    return numReady;
+}
+
+AbstractEventLoop EventLoopFactory::createEventLoop(EventLoopType type, bool edgeTriggered) {
+    switch (type) {
+    case EventLoopType::POLL:
+        return std::make_unique<PollEventLoop>();
+    case EventLoopType::EPOLL:
+    case EventLoopType::IO_URING:
+        return std::make_unique<EpollEventLoop>(edgeTriggered);
+    default:
+        return nullptr;
+    }
+}
+
+EventLoopType EventLoopFactory::getEventLoopType(const std::string &choice) {
+    static const std::unordered_map<std::string, EventLoopType> choiceToType = {{"POLL", EventLoopType::POLL},
+                                                                                {"EPOLL", EventLoopType::EPOLL},
+                                                                                {"IO_URING", EventLoopType::IO_URING}};
+
+    auto it = choiceToType.find(choice);
+    if (it != choiceToType.end()) {
+        return it->second;
+    } else {
+        return EventLoopType::UNKNOWN;
+    }
+}
+} // namespace echo
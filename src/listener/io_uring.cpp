@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <system_error>
+#include <unistd.h>
+
+#include "listener/io_uring.hpp"
+
+namespace echo {
+
+namespace {
+int ioUringSetup(unsigned entries, struct io_uring_params *params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int ioUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+int ioUringRegister(int ringFd, unsigned opcode, void *arg, unsigned nrArgs) {
+    return syscall(__NR_io_uring_register, ringFd, opcode, arg, nrArgs);
+}
+} // namespace
+
+IoUring::IoUring(unsigned entries) {
+    struct io_uring_params params {};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    params.cq_entries = entries * 4; // multishot receives can post many completions per submission
+
+    ringFd = ioUringSetup(entries, &params);
+    if (ringFd == -1 && errno == EINVAL) {
+        // Kernels older than 6.1 don't know about deferred task running
+        params = {};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+        ringFd = ioUringSetup(entries, &params);
+    }
+    if (ringFd == -1) {
+        throw std::system_error(errno, std::generic_category(), "io_uring setup error");
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+
+    sqRingPtr = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRingPtr == MAP_FAILED) {
+        close(ringFd);
+        throw std::system_error(errno, std::generic_category(), "io_uring submission ring mapping error");
+    }
+
+    cqRingPtr = sqRingPtr;
+    if (!singleMmap) {
+        cqRingPtr =
+            mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRingPtr == MAP_FAILED) {
+            munmap(sqRingPtr, sqRingSize);
+            close(ringFd);
+            throw std::system_error(errno, std::generic_category(), "io_uring completion ring mapping error");
+        }
+    }
+
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqesPtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqesPtr == MAP_FAILED) {
+        if (!singleMmap) {
+            munmap(cqRingPtr, cqRingSize);
+        }
+        munmap(sqRingPtr, sqRingSize);
+        close(ringFd);
+        throw std::system_error(errno, std::generic_category(), "io_uring submission entries mapping error");
+    }
+    sqes = static_cast<struct io_uring_sqe *>(sqesPtr);
+
+    char *sq = static_cast<char *>(sqRingPtr);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqEntries = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_entries);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sqeTail = *sqTail;
+
+    char *cq = static_cast<char *>(cqRingPtr);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+IoUring::~IoUring() {
+    if (bufferRing != nullptr) {
+        struct io_uring_buf_reg reg {};
+        reg.bgid = bufferGroupId;
+        ioUringRegister(ringFd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        munmap(bufferRing, bufferRingSize);
+    }
+
+    munmap(sqes, sqesSize);
+    if (cqRingPtr != sqRingPtr) {
+        munmap(cqRingPtr, cqRingSize);
+    }
+    munmap(sqRingPtr, sqRingSize);
+    close(ringFd);
+}
+
+struct io_uring_sqe *IoUring::getSqe() {
+    if (sqeTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+        submitAndWait(0);
+    }
+
+    unsigned idx = sqeTail & sqMask;
+    struct io_uring_sqe *sqe = &sqes[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqArray[idx] = idx;
+    sqeTail++;
+    return sqe;
+}
+
+int IoUring::submitAndWait(unsigned waitNr) {
+    unsigned toSubmit = sqeTail - *sqTail;
+    __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+
+    int submitted = ioUringEnter(ringFd, toSubmit, waitNr, waitNr > 0 ? IORING_ENTER_GETEVENTS : 0);
+    if (submitted == -1) {
+        if (errno == EINTR) {
+            return -1;
+        }
+        throw std::system_error(errno, std::generic_category(), "io_uring submission error");
+    }
+    return submitted;
+}
+
+void IoUring::registerBufferRing(uint16_t groupId, unsigned count, unsigned size) {
+    // The kernel requires a power of two number of entries in the ring
+    unsigned entries = 1;
+    while (entries < count) {
+        entries <<= 1;
+    }
+
+    bufferRingSize = entries * sizeof(struct io_uring_buf);
+    void *ringPtr = mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (ringPtr == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "Provided buffer ring allocation error");
+    }
+
+    struct io_uring_buf_reg reg {};
+    reg.ring_addr = reinterpret_cast<uint64_t>(ringPtr);
+    reg.ring_entries = entries;
+    reg.bgid = groupId;
+    if (ioUringRegister(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) == -1) {
+        int registerErrno = errno;
+        munmap(ringPtr, bufferRingSize);
+        throw std::system_error(registerErrno, std::generic_category(), "Provided buffer ring registration error");
+    }
+
+    bufferRing = static_cast<struct io_uring_buf *>(ringPtr);
+    bufferRingMask = entries - 1;
+    bufferGroupId = groupId;
+    bufferSize = size;
+    bufferMemory.resize(static_cast<size_t>(entries) * size);
+
+    for (unsigned i = 0; i < entries; i++) {
+        recycleBuffer(i);
+    }
+    commitBuffers();
+}
+
+void IoUring::recycleBuffer(uint16_t bufferId) {
+    struct io_uring_buf *buf = &bufferRing[bufferRingTail & bufferRingMask];
+    buf->addr = reinterpret_cast<uint64_t>(getBuffer(bufferId));
+    buf->len = bufferSize;
+    buf->bid = bufferId;
+    bufferRingTail++;
+}
+
+void IoUring::commitBuffers() {
+    // The ring tail overlays the reserved field of the first buffer entry
+    auto *ring = reinterpret_cast<struct io_uring_buf_ring *>(bufferRing);
+    __atomic_store_n(&ring->tail, bufferRingTail, __ATOMIC_RELEASE);
+}
+
+void IoUring::preparePollMultishot(int fd, uint32_t events, uint64_t userData) {
+    struct io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = userData;
+}
+
+void IoUring::prepareRecvMultishot(int fd, uint64_t userData) {
+    struct io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = bufferGroupId;
+    sqe->user_data = userData;
+}
+
+void IoUring::prepareSend(int fd, const void *data, size_t len, uint64_t userData) {
+    struct io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = len;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = userData;
+}
+
+void IoUring::prepareCancel(uint64_t targetUserData, uint64_t userData) {
+    struct io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = targetUserData;
+    sqe->user_data = userData;
+}
+} // namespace echo
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <fcntl.h>
 #include <iostream>
 #include <sys/poll.h>
 #include <sys/socket.h>
@@ -6,26 +8,24 @@
 
 namespace echo {
 
-namespace {
-const int listenerQueueSize = 50;
-}
+Listener::~Listener() { closeListenerSockets(); }
 
-Listener::~Listener() {
+void Listener::closeListenerSockets() {
     for (auto &listener : getListenerPool()) {
-        close(listener->getsocketFd());
-
         auto uds = dynamic_cast<UnixSocket *>(listener.get());
         if (uds) {
             unlink(uds->getSocketPath().c_str());
         }
     }
+
+    // The sockets close themselves
+    listenerPool.clear();
 }
 
 void Listener::addListenerSocket(AbstractSocket listener) {
     try {
         listener->bind();
         listener->initOptions(listener->getsocketFd());
-        listenerFds.emplace_back(pollfd{listener->getsocketFd(), POLLIN, 0});
         listenerPool.emplace_back(std::move(listener));
     } catch (const std::runtime_error &e) {
         std::cerr << e.what() << std::endl;
@@ -33,19 +33,47 @@ void Listener::addListenerSocket(AbstractSocket listener) {
 }
 
 void Listener::prepareListenerSockets() {
+    listenerEventLoop = EventLoopFactory::createEventLoop(eventLoopType);
+
     for (AbstractSocket &listener : listenerPool) {
-        if (listen(listener->getsocketFd(), listenerQueueSize) == -1) {
-            throw std::system_error(errno, std::generic_category(),
-                                    "Failed to prepare for conection acceptance the listener socket");
-        }
+        startListening(*listener);
+        listenerEventLoop->add(listener->getsocketFd(), POLLIN);
     }
 }
 
-int Listener::pollListenerSockets() {
-    int numReady = poll(listenerFds.data(), listenerFds.size(), -1);
-    if (numReady == -1 && errno != EINTR) {
-        throw std::system_error(errno, std::generic_category(), "Listener socket poll error");
+void Listener::startListening(ISocket &listener) {
+    if (listen(listener.getsocketFd(), listenBacklog) == -1) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to prepare for conection acceptance the listener socket");
+    }
+
+    // Accept queues are drained until empty, which needs accept to fail rather than block at the end
+    int flags = fcntl(listener.getsocketFd(), F_GETFL);
+    if (flags == -1 || fcntl(listener.getsocketFd(), F_SETFL, flags | O_NONBLOCK) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Failed to set the listener to non-blocking mode");
+    }
+}
+
+void Listener::raiseOpenFileLimit(rlim_t wanted) {
+    struct rlimit limit {};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == -1 || limit.rlim_cur >= wanted) {
+        return;
+    }
+
+    limit.rlim_cur = std::min(wanted, limit.rlim_max);
+    if (setrlimit(RLIMIT_NOFILE, &limit) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Raising the open file limit error");
+    }
+}
+
+int Listener::pollListenerSockets(int timeoutMs) { return listenerEventLoop->wait(readyListeners, timeoutMs); }
+
+ISocket *Listener::findListener(int fd) const {
+    for (const AbstractSocket &listener : listenerPool) {
+        if (listener->getsocketFd() == fd) {
+            return listener.get();
+        }
     }
-    return numReady;
+    return nullptr;
 }
 } // namespace echo
\ No newline at end of file
@@ -0,0 +1,616 @@
+#include <chrono>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+
+#include "listener/reactor.hpp"
+#include "listener/server.hpp"
+
+namespace echo {
+
+namespace {
+/* Submission queue depth and number of provided receive buffers of the IO_URING data path of every reactor */
+const unsigned uringQueueDepth = 4096;
+const unsigned uringBufferCount = 4096;
+const uint16_t uringBufferGroupId = 0;
+
+/* Maximum number of output blocks gathered into a single sendmsg */
+const size_t maxSendSegments = 64;
+
+/* Time a client whose output was discarded has to acknowledge the zero-copy sends still in flight, after which TCP
+ * aborts the connection and the kernel releases their pages */
+const unsigned abandonedSendTimeoutMs = 10000;
+
+/* Weight of the previous batches in the published latency average, every batch moving it 1/latencySmoothing */
+const int64_t latencySmoothing = 8;
+
+/* Operation tags stored in the top byte of the io_uring user data. Below it come the generation of the connection and
+ * the file descriptor in the lower half, so completions of a closed connection never reach one reusing its fd */
+enum class UringOp : uint32_t { PIPE_POLL = 1, WAKE_POLL, LISTENER_POLL, RECV, SEND, CANCEL };
+
+const int uringOpShift = 32 + connectionGenerationBits;
+
+uint64_t encodeUserData(UringOp op, ConnectionHandle handle) {
+    return (static_cast<uint64_t>(op) << uringOpShift) | (static_cast<uint64_t>(handle.generation) << 32) |
+           static_cast<uint32_t>(handle.fd);
+}
+
+uint64_t encodeUserData(UringOp op, int fd) { return encodeUserData(op, ConnectionHandle{fd, 0}); }
+
+UringOp decodeOp(uint64_t userData) { return static_cast<UringOp>(userData >> uringOpShift); }
+
+ConnectionHandle decodeHandle(uint64_t userData) {
+    return {static_cast<int>(userData & 0xffffffff),
+            static_cast<uint32_t>(userData >> 32) & ((1u << connectionGenerationBits) - 1)};
+}
+} // namespace
+
+Reactor::Reactor(Server &server, const ServerConfig &config, size_t idx)
+    : server(server), eventLoopType(config.eventLoopType), idx(idx), watchPipe(idx == 0),
+      bufferPool(config.hugePages) {
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd == -1) {
+        throw std::system_error(errno, std::generic_category(), "Reactor wake eventfd creation error");
+    }
+
+    if (eventLoopType != EventLoopType::IO_URING) {
+        eventLoop = EventLoopFactory::createEventLoop(eventLoopType, true);
+        eventLoop->add(wakeFd, POLLIN);
+        if (watchPipe) {
+            eventLoop->add(server.getPipeFd(), POLLIN);
+        }
+    }
+}
+
+Reactor::~Reactor() {
+    connections.forEach([](Connection &connection) { close(connection.getFd()); });
+
+    for (const auto &[clientFd, framing] : handoffQueue) {
+        close(clientFd);
+    }
+
+    close(wakeFd);
+}
+
+void Reactor::run() {
+    if (eventLoopType == EventLoopType::IO_URING) {
+        runCompletionLoop();
+    } else {
+        runEventLoop();
+    }
+}
+
+void Reactor::stop() {
+    stopRequested = true;
+
+    uint64_t one = 1;
+    write(wakeFd, &one, sizeof(one));
+}
+
+void Reactor::stopWatching(int fd) {
+    if (ring != nullptr) {
+        // The poll completes with -ECANCELED, and isn't re-armed since the listener is gone by then
+        ring->prepareCancel(encodeUserData(UringOp::LISTENER_POLL, fd), encodeUserData(UringOp::CANCEL, fd));
+    } else if (eventLoop != nullptr) {
+        eventLoop->remove(fd);
+    }
+}
+
+void Reactor::enqueueClient(int clientFd, FramingType framing) {
+    // Counted right away, so that client limits also cover the clients still waiting in the queue
+    clientCount.fetch_add(1, std::memory_order_relaxed);
+    server.getLoad().activeClients.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(handoffMutex);
+        handoffQueue.emplace_back(clientFd, framing);
+    }
+
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+        throw std::system_error(errno, std::generic_category(), "Reactor wake error");
+    }
+}
+
+bool Reactor::isStopRequested() const { return stopRequested || Server::isShutdownRequested(); }
+
+void Reactor::drainHandoffQueue() {
+    uint64_t wakeCount;
+    read(wakeFd, &wakeCount, sizeof(wakeCount));
+
+    std::vector<std::pair<int, FramingType>> handedOff;
+    {
+        std::lock_guard<std::mutex> lock(handoffMutex);
+        handedOff.swap(handoffQueue);
+    }
+
+    for (const auto &[clientFd, framing] : handedOff) {
+        addClient(clientFd, framing);
+    }
+}
+
+void Reactor::addClient(int clientFd, FramingType framing) {
+    Connection &connection = connections.insert(clientFd, framing, &bufferPool);
+
+    if (ring != nullptr) {
+        connection.setReceiving(true);
+        ring->prepareRecvMultishot(clientFd, encodeUserData(UringOp::RECV, connections.getHandle(clientFd)));
+    } else {
+        // Only the dispatcher hands sockets over non-blocking, while an edge-triggered loop reads until EAGAIN
+        if (fcntl(clientFd, F_SETFL, fcntl(clientFd, F_GETFL) | O_NONBLOCK) == -1) {
+            throw std::system_error(errno, std::generic_category(), "Setting client socket to non-blocking error");
+        }
+
+        // Only supported by TCP sockets, others keep sending the usual way
+        int enable = 1;
+        connection.setZeroCopyEnabled(setsockopt(clientFd, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) == 0);
+
+        connection.setWatchedEvents(POLLIN);
+        eventLoop->add(clientFd, POLLIN);
+    }
+}
+
+void Reactor::publishLoad(std::chrono::steady_clock::time_point batchStart) {
+    ServerLoad &load = server.getLoad();
+
+    // Every reactor adds how much its own usage changed, so the server's total needs no summing up
+    int64_t bufferedBytes = bufferPool.getStats().usedBytes;
+    if (bufferedBytes != publishedBufferedBytes) {
+        load.bufferedBytes.fetch_add(bufferedBytes - publishedBufferedBytes, std::memory_order_relaxed);
+        publishedBufferedBytes = bufferedBytes;
+    }
+
+    // Reactors update the average concurrently, each moving it 1/8 of the way towards its latest batch
+    int64_t latency =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - batchStart).count();
+    int64_t average = load.latencyNanos.load(std::memory_order_relaxed);
+    load.latencyNanos.fetch_add((latency - average) / latencySmoothing, std::memory_order_relaxed);
+
+    ReactorStats &stats = server.getReactorStats(idx);
+    stats.latencyBuckets[toLatencyBucket(latency)].fetch_add(1, std::memory_order_relaxed);
+    if (unpublishedMessages > 0) {
+        stats.messages.fetch_add(std::exchange(unpublishedMessages, 0), std::memory_order_relaxed);
+        stats.bytesReceived.fetch_add(std::exchange(unpublishedBytesReceived, 0), std::memory_order_relaxed);
+        stats.bytesSent.fetch_add(std::exchange(unpublishedBytesSent, 0), std::memory_order_relaxed);
+    }
+}
+
+void Reactor::refreshResponseSchema() {
+    uint64_t latestVersion = server.getResponseSchemaVersion();
+    if (responseSchema == nullptr || latestVersion != responseSchemaVersion) {
+        responseSchemaVersion = latestVersion;
+        responseSchema = server.getResponseSchema();
+    }
+}
+
+void Reactor::runEventLoop() {
+    // The server's own listeners are only set up after the reactors were created
+    if (watchPipe) {
+        for (const AbstractSocket &listener : server.getListenerPool()) {
+            eventLoop->add(listener->getsocketFd(), POLLIN);
+        }
+    }
+
+    while (!isStopRequested()) {
+        if (eventLoop->wait(readyFds) > 0) {
+            auto batchStart = std::chrono::steady_clock::now();
+            handleIncomingData();
+            publishLoad(batchStart);
+        }
+    }
+}
+
+void Reactor::handleIncomingData() {
+    for (const ReadyEvent &event : readyFds) {
+        if (event.fd == wakeFd) {
+            drainHandoffQueue();
+            continue;
+        } else if (watchPipe && event.fd == server.getPipeFd()) {
+            server.acceptPipeData();
+            continue;
+        } else if (watchPipe && server.acceptListenerClients(event.fd)) {
+            continue;
+        }
+
+        Connection *found = connections.find(event.fd);
+        if (found == nullptr) {
+            continue;
+        }
+        Connection &connection = *found;
+
+        // Zero-copy completions are queued on the socket error queue, which is reported as POLLERR until drained
+        if (event.events & POLLERR) {
+            drainZeroCopyCompletions(connection);
+        }
+
+        // A client done sending is not read from anymore, only flushed until it has all of its responses
+        if (connection.isClosing()) {
+            flushOutput(connection);
+            continue;
+        }
+
+        if (event.events & POLLOUT) {
+            if (!flushOutput(connection)) {
+                continue;
+            }
+
+            if (connection.isReadPaused() && connection.isBelowLowWaterMark()) {
+                connection.setReadPaused(false);
+                updateWatchedEvents(connection);
+                // Data that arrived while paused produced no new edge, so it has to be read right away
+                handleClientData(connection);
+                continue;
+            }
+        }
+
+        if (event.events & (POLLIN | POLLHUP | POLLERR) && !connection.isReadPaused()) {
+            handleClientData(connection);
+        }
+    }
+}
+
+void Reactor::handleClientData(Connection &connection) {
+    int clientFd = connection.getFd();
+    FrameDecoder &decoder = connection.getDecoder();
+
+    while (true) {
+        // Received straight into the reassembly buffer, where the responses are generated in place as well
+        char *buffer = decoder.getFeedBuffer(bufferSize);
+        int bytesRead = receiveFromClient(clientFd, buffer, decoder.getFeedCapacity());
+
+        if (bytesRead == -1) {
+            // Nothing left to read, so a buffer holding no partial frame can go back to the pool until the next read
+            decoder.releaseIdleBuffer();
+            break;
+        } else if (bytesRead == 0) {
+            // The client may only have shut down its sending side (e.g after a large request), so the responses still
+            // queued are sent before the connection is closed
+            decoder.releaseIdleBuffer();
+            connection.setClosing(true);
+            std::cout << "Connection closed by a client " << std::endl;
+            flushOutput(connection);
+            break;
+        }
+
+        decoder.commitFeed(bytesRead);
+        if (!processFrames(connection)) {
+            std::cout << "Connection closed after a framing violation " << std::endl;
+            abandonClient(connection);
+            break;
+        }
+
+        if (!flushOutput(connection)) {
+            break;
+        }
+
+        // A client that doesn't read its responses is not read from until it catches up
+        if (connection.isAboveHighWaterMark()) {
+            connection.setReadPaused(true);
+            updateWatchedEvents(connection);
+            break;
+        }
+
+        // Level-triggered loops report the fd again if there is more to read, so a single read is enough
+        if (!eventLoop->isEdgeTriggered()) {
+            decoder.releaseIdleBuffer();
+            break;
+        }
+    }
+}
+
+bool Reactor::processFrames(Connection &connection) {
+    refreshResponseSchema();
+
+    FrameDecoder &decoder = connection.getDecoder();
+    FrameView frame;
+    while (decoder.nextFrame(frame)) {
+        unpublishedMessages++;
+        unpublishedBytesReceived += frame.payloadSize;
+
+        std::span<char> message(frame.payload, frame.payloadSize);
+        size_t maxResponseSize = responseSchema->getMaxResponseSize(message.size());
+        if (maxResponseSize > message.size()) {
+            // Written straight into the pooled output of the connection, which the response won't fit in place of
+            size_t responseSize = responseSchema->writeResponse(message, connection.reserveFrame(maxResponseSize));
+            connection.commitFrame(responseSize);
+            unpublishedBytesSent += responseSize;
+            continue;
+        }
+        size_t responseSize = responseSchema->writeResponse(message, message);
+        unpublishedBytesSent += responseSize;
+
+        connection.queueView(Framing::sealFrameInPlace(decoder.getType(), frame.payload, responseSize));
+
+        // Instead of being copied by the kernel, large responses are sent from the reassembly buffer itself, which
+        // the connection keeps until the kernel is done with it
+        if (connection.isZeroCopyEnabled() && responseSize >= zeroCopyThreshold) {
+            connection.pinViews(decoder.detachBuffer());
+        }
+    }
+    return !decoder.isOversized();
+}
+
+bool Reactor::flushOutput(Connection &connection) {
+    struct iovec iov[maxSendSegments];
+
+    while (connection.hasPendingOutput()) {
+        bool zeroCopy;
+        struct msghdr message {};
+        message.msg_iov = iov;
+        message.msg_iovlen = connection.gatherOutput(iov, maxSendSegments, zeroCopy);
+
+        ssize_t bytesSent =
+            sendmsg(connection.getFd(), &message, MSG_NOSIGNAL | MSG_DONTWAIT | (zeroCopy ? MSG_ZEROCOPY : 0));
+
+        if (bytesSent == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else if (errno == ENOBUFS && zeroCopy) {
+                // Out of optmem for pinning pages, the remaining output is sent the usual way
+                connection.setZeroCopyEnabled(false);
+                continue;
+            }
+            std::cout << "Connection closed by a client " << std::endl;
+            abandonClient(connection);
+            return false;
+        }
+
+        if (zeroCopy) {
+            connection.recordZeroCopySend();
+        }
+        connection.consumeOutput(bytesSent);
+    }
+
+    // The reassembly buffer is about to receive new data, so whatever still points into it has to be copied
+    connection.materializeViews();
+    if (connection.isClosing()) {
+        return !closeClientIfDone(connection);
+    }
+    updateWatchedEvents(connection);
+    return true;
+}
+
+void Reactor::abandonClient(Connection &connection) {
+    connection.setClosing(true);
+    connection.discardOutput();
+    if (connection.hasZeroCopyInFlight()) {
+        int clientFd = connection.getFd();
+        setsockopt(clientFd, IPPROTO_TCP, TCP_USER_TIMEOUT, &abandonedSendTimeoutMs, sizeof(abandonedSendTimeoutMs));
+    }
+    closeClientIfDone(connection);
+}
+
+bool Reactor::closeClientIfDone(Connection &connection) {
+    // The pages of zero-copy sends are only handed back to the pool once the kernel reports it no longer transmits
+    // them, which needs the socket and its error queue, as the pool would otherwise reuse them for other clients
+    if (connection.hasPendingOutput() || connection.hasZeroCopyInFlight()) {
+        updateWatchedEvents(connection);
+        return false;
+    }
+    closeClientConnection(connection.getFd());
+    return true;
+}
+
+void Reactor::updateWatchedEvents(Connection &connection) {
+    bool reading = !connection.isReadPaused() && !connection.isClosing();
+    uint32_t events = (reading ? POLLIN : 0) | (connection.hasPendingOutput() ? POLLOUT : 0);
+    if (events != connection.getWatchedEvents()) {
+        eventLoop->modify(connection.getFd(), events);
+        connection.setWatchedEvents(events);
+    }
+}
+
+int Reactor::receiveFromClient(int clientFd, char *buffer, size_t size) {
+    int bytesRead = recv(clientFd, buffer, size, 0);
+    if (bytesRead == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return -1;
+        } else if (errno == ECONNRESET) {
+            return 0;
+        }
+        throw std::system_error(errno, std::generic_category(), "Error reading from client");
+    }
+    return bytesRead;
+}
+
+void Reactor::drainZeroCopyCompletions(Connection &connection) {
+    char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+
+    while (true) {
+        struct msghdr message {};
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        if (recvmsg(connection.getFd(), &message, MSG_ERRQUEUE) == -1) {
+            break;
+        }
+
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+            bool isRecvError = (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                               (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+            auto *error = reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(cmsg));
+            if (!isRecvError || error->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+
+            connection.completeZeroCopySends(error->ee_data);
+            // The kernel had to copy anyway (e.g loopback), so pinning the pages only adds overhead
+            if (error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                connection.setZeroCopyEnabled(false);
+            }
+        }
+    }
+}
+
+void Reactor::closeClientConnection(int clientFd) {
+    eventLoop->remove(clientFd);
+
+    if (close(clientFd) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Error closing client connection");
+    }
+
+    connections.erase(clientFd);
+    clientCount.fetch_sub(1, std::memory_order_relaxed);
+    server.getLoad().activeClients.fetch_sub(1, std::memory_order_relaxed);
+    server.stopIfDrained();
+}
+
+void Reactor::runCompletionLoop() {
+    ring = std::make_unique<IoUring>(uringQueueDepth);
+    ring->registerBufferRing(uringBufferGroupId, uringBufferCount, bufferSize);
+
+    ring->preparePollMultishot(wakeFd, POLLIN, encodeUserData(UringOp::WAKE_POLL, wakeFd));
+    if (watchPipe) {
+        ring->preparePollMultishot(server.getPipeFd(), POLLIN, encodeUserData(UringOp::PIPE_POLL, server.getPipeFd()));
+        for (const AbstractSocket &listener : server.getListenerPool()) {
+            ring->preparePollMultishot(listener->getsocketFd(), POLLIN,
+                                       encodeUserData(UringOp::LISTENER_POLL, listener->getsocketFd()));
+        }
+    }
+    // Clients handed over before the ring existed only left a wake count behind
+    drainHandoffQueue();
+
+    while (!isStopRequested()) {
+        if (ring->submitAndWait(1) == -1) {
+            continue;
+        }
+
+        auto batchStart = std::chrono::steady_clock::now();
+        ring->forEachCompletion([this](const struct io_uring_cqe &cqe) { handleCompletion(cqe); });
+        ring->commitBuffers();
+        publishLoad(batchStart);
+    }
+}
+
+void Reactor::handleCompletion(const struct io_uring_cqe &cqe) {
+    ConnectionHandle handle = decodeHandle(cqe.user_data);
+    int fd = handle.fd;
+    UringOp op = decodeOp(cqe.user_data);
+    bool rearm = !(cqe.flags & IORING_CQE_F_MORE);
+
+    if (op == UringOp::PIPE_POLL || op == UringOp::WAKE_POLL || op == UringOp::LISTENER_POLL) {
+        if (op == UringOp::PIPE_POLL) {
+            server.acceptPipeData();
+        } else if (op == UringOp::LISTENER_POLL) {
+            // A listener closed by a retiring server is not watched anymore
+            rearm = server.acceptListenerClients(fd) && rearm;
+        } else {
+            drainHandoffQueue();
+        }
+        if (rearm) {
+            ring->preparePollMultishot(fd, POLLIN, cqe.user_data);
+        }
+        return;
+    }
+
+    Connection *found = connections.find(handle);
+    if (found == nullptr) {
+        return;
+    }
+    Connection &connection = *found;
+
+    switch (op) {
+    case UringOp::RECV:
+        if (cqe.res > 0) {
+            uint16_t bufferId = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+            connection.getDecoder().feed(ring->getBuffer(bufferId), cqe.res);
+            ring->recycleBuffer(bufferId);
+
+            if (processFrames(connection)) {
+                // Sends complete asynchronously, so they can't point into the reassembly buffer
+                connection.materializeViews();
+                connection.getDecoder().releaseIdleBuffer();
+                submitUringQueuedOutput(connection);
+            } else {
+                connection.setClosing(true);
+                connection.discardOutput();
+                shutdown(fd, SHUT_RDWR);
+            }
+        } else if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+            // End of stream or receive error, the multishot receive is terminated
+            connection.setClosing(true);
+        }
+
+        if (rearm) {
+            if (connection.isClosing() || connection.isReadPaused()) {
+                connection.setReceiving(false);
+                closeUringClientIfDone(connection);
+            } else {
+                ring->prepareRecvMultishot(fd, cqe.user_data);
+            }
+        }
+        break;
+    case UringOp::SEND:
+        if (connection.finishFrontSend()) {
+            // The output was discarded while this send was in flight, the connection only waited for it to complete
+            closeUringClientIfDone(connection);
+            break;
+        }
+
+        if (cqe.res < 0) {
+            // Peer is gone, shutting the socket down terminates the pending receive as well
+            connection.setClosing(true);
+            connection.discardOutput();
+            shutdown(fd, SHUT_RDWR);
+            closeUringClientIfDone(connection);
+            break;
+        }
+
+        // A partial send leaves the rest of the block at the front, so it is simply resubmitted
+        connection.consumeOutput(cqe.res);
+        submitUringSend(connection);
+
+        if (connection.isReadPaused() && connection.isBelowLowWaterMark()) {
+            connection.setReadPaused(false);
+            if (!connection.isReceiving()) {
+                connection.setReceiving(true);
+                ring->prepareRecvMultishot(fd, encodeUserData(UringOp::RECV, handle));
+            }
+        }
+        closeUringClientIfDone(connection);
+        break;
+    default:
+        break;
+    }
+}
+
+void Reactor::submitUringQueuedOutput(Connection &connection) {
+    submitUringSend(connection);
+
+    if (connection.isAboveHighWaterMark() && !connection.isReadPaused()) {
+        connection.setReadPaused(true);
+        ConnectionHandle handle = connections.getHandle(connection.getFd());
+        ring->prepareCancel(encodeUserData(UringOp::RECV, handle), encodeUserData(UringOp::CANCEL, handle));
+    }
+}
+
+void Reactor::submitUringSend(Connection &connection) {
+    if (connection.isFrontInFlight() || !connection.hasPendingOutput()) {
+        return;
+    }
+
+    std::string_view output = connection.getFrontOutput();
+    connection.setFrontInFlight(true);
+    ring->prepareSend(connection.getFd(), output.data(), output.size(),
+                      encodeUserData(UringOp::SEND, connections.getHandle(connection.getFd())));
+}
+
+void Reactor::closeUringClientIfDone(Connection &connection) {
+    if (!connection.isClosing() || connection.isReceiving() || connection.isFrontInFlight() ||
+        connection.hasPendingOutput()) {
+        return;
+    }
+
+    int clientFd = connection.getFd();
+    connections.erase(clientFd);
+    close(clientFd);
+    clientCount.fetch_sub(1, std::memory_order_relaxed);
+    server.getLoad().activeClients.fetch_sub(1, std::memory_order_relaxed);
+    std::cout << "Connection closed by a client " << std::endl;
+    server.stopIfDrained();
+}
+} // namespace echo
\ No newline at end of file
@@ -1,39 +1,154 @@
-#include "algorithm"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 
 #include "listener/response_schema.hpp"
 
 namespace echo {
 
-void EquivalentResponseSchema::generateResponse([[maybe_unused]] std::string &message) { return; }
+namespace {
+const std::string_view palindromeResponse = "This message is a palindrome :)";
+const std::string_view notPalindromeResponse = "This message is not a palindrome :(";
 
-void ReverseResponseSchema::generateResponse(std::string &message) { std::reverse(message.begin(), message.end()); }
+/* Returns "response" holding "message", for schemas that work on the message in place. Nothing is copied when
+ * responding in place */
+char *copyToResponse(std::span<const char> message, std::span<char> response) {
+    if (response.data() != message.data()) {
+        std::memcpy(response.data(), message.data(), message.size());
+    }
+    return response.data();
+}
+} // namespace
+
+void IResponseSchema::generateResponse(std::string &message) const {
+    size_t maxResponseSize = getMaxResponseSize(message.size());
+    if (maxResponseSize <= message.size()) {
+        message.resize(writeResponse(message, message));
+        return;
+    }
+
+    std::string response(maxResponseSize, '\0');
+    response.resize(writeResponse(message, response));
+    message = std::move(response);
+}
+
+size_t EquivalentResponseSchema::writeResponse(std::span<const char> message, std::span<char> response) const {
+    copyToResponse(message, response);
+    return message.size();
+}
 
-void CensoredResponseSchema::generateResponse(std::string &message) {
-    message.erase(std::remove(message.begin(), message.end(), censoredChar), message.end());
+size_t ReverseResponseSchema::writeResponse(std::span<const char> message, std::span<char> response) const {
+    reverse(copyToResponse(message, response), message.size());
+    return message.size();
 }
 
-void PalindromeResponseSchema::generateResponse(std::string &message) {
-    int left_ptr = 0;
-    int right_ptr = message.size() - 1;
+size_t CensoredResponseSchema::writeResponse(std::span<const char> message, std::span<char> response) const {
+    char *data = copyToResponse(message, response);
+    if (mask.has_value()) {
+        maskCensored(table, *mask, data, message.size());
+        return message.size();
+    }
+    return censor(table, data, message.size());
+}
 
-    while (left_ptr <= right_ptr) {
-        if (!isalnum(message[left_ptr])) {
-            left_ptr++;
-            continue;
+size_t PalindromeResponseSchema::writeResponse(std::span<const char> message, std::span<char> response) const {
+    auto isCounted = [](char c) { return std::isalnum(static_cast<unsigned char>(c)); };
+    auto lower = [](char c) { return std::tolower(static_cast<unsigned char>(c)); };
+
+    // The message is read to the end before anything is written, so the response may overwrite it
+    bool palindrome = true;
+    size_t left = 0;
+    size_t right = message.size();
+    while (palindrome && left < right) {
+        if (!isCounted(message[left])) {
+            left++;
+        } else if (!isCounted(message[right - 1])) {
+            right--;
+        } else {
+            palindrome = lower(message[left++]) == lower(message[--right]);
         }
-        if (!isalnum(message[right_ptr])) {
-            right_ptr--;
-            continue;
+    }
+
+    std::string_view verdict = palindrome ? palindromeResponse : notPalindromeResponse;
+    std::memcpy(response.data(), verdict.data(), verdict.size());
+    return verdict.size();
+}
+
+size_t PalindromeResponseSchema::getMaxResponseSize(size_t messageSize) const {
+    return std::max({messageSize, palindromeResponse.size(), notPalindromeResponse.size()});
+}
+
+size_t BlocklistResponseSchema::writeResponse(std::span<const char> message, std::span<char> response) const {
+    return automaton.filter(copyToResponse(message, response), message.size(), mask);
+}
+
+ByteStages::ByteStages() {
+    for (size_t byte = 0; byte < outcomes.size(); byte++) {
+        outcomes[byte] = static_cast<int16_t>(byte);
+    }
+}
+
+void ByteStages::appendCensor(std::string_view censoredChars, std::optional<char> mask) {
+    const CensorTable censored(censoredChars);
+    for (int16_t &outcome : outcomes) {
+        if (outcome != removedByte && censored.contains(static_cast<char>(outcome))) {
+            outcome = mask.has_value() ? static_cast<uint8_t>(*mask) : removedByte;
         }
-        if (tolower(message[left_ptr]) != tolower(message[right_ptr])) {
-            message = "This message is not a palindrome :(";
-            return;
-        } else {
-            left_ptr++;
-            right_ptr--;
+    }
+}
+
+FusedResponseSchema::FusedResponseSchema(const ByteStages &stages) : stages(stages), reverse(getReverseKernel()) {
+    std::string removedChars;
+    std::string maskedChars;
+    std::optional<int16_t> mask;
+    for (size_t byte = 0; byte < stages.outcomes.size(); byte++) {
+        int16_t outcome = stages.outcomes[byte];
+        if (outcome == ByteStages::removedByte) {
+            removedChars.push_back(static_cast<char>(byte));
+        } else if (outcome != static_cast<int16_t>(byte)) {
+            if (mask.has_value() && *mask != outcome) {
+                return;
+            }
+            mask = outcome;
+            maskedChars.push_back(static_cast<char>(byte));
         }
     }
+    tables = {CensorTable(removedChars), CensorTable(maskedChars), static_cast<char>(mask.value_or(0))};
+    kernel = getFusedKernel(!removedChars.empty(), !maskedChars.empty(), stages.reverses);
+}
 
-    message = "This message is a palindrome :)";
+size_t FusedResponseSchema::writeResponse(std::span<const char> message, std::span<char> response) const {
+    if (kernel != nullptr) {
+        return kernel(tables, message.data(), message.size(), response.data());
+    }
+
+    // Writing every byte and only counting the kept ones, as the censor kernels do, leaves the lookup branchless
+    size_t kept = 0;
+    for (char c : message) {
+        int16_t outcome = stages.outcomes[static_cast<uint8_t>(c)];
+        response[kept] = static_cast<char>(outcome);
+        kept += outcome != ByteStages::removedByte;
+    }
+    if (stages.reverses) {
+        reverse(response.data(), kept);
+    }
+    return kept;
+}
+
+size_t PipelineResponseSchema::writeResponse(std::span<const char> message, std::span<char> response) const {
+    // The longest response of every stage is at least as long as its message and grows with it, so "response", long
+    // enough for the last stage, is long enough for every stage before it
+    size_t size = stages.front()->writeResponse(message, response);
+    for (size_t stage = 1; stage < stages.size(); stage++) {
+        size = stages[stage]->writeResponse(response.first(size), response);
+    }
+    return size;
+}
+
+size_t PipelineResponseSchema::getMaxResponseSize(size_t messageSize) const {
+    for (const std::unique_ptr<IResponseSchema> &stage : stages) {
+        messageSize = stage->getMaxResponseSize(messageSize);
+    }
+    return messageSize;
 }
 } // namespace echo
\ No newline at end of file
@@ -1,27 +1,337 @@
+#include <bitset>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
 #include "listener/response_schema_factory.hpp"
 
 namespace echo {
 
+namespace {
+/* Separates the mask from the rest of the argument of a censored or blocklist schema's descriptor. Never censored,
+ * since the CLI can't pass it */
+const char maskSeparator = '\0';
+
+/* Expands a character set given as characters and ranges (e.g "a-z0-9_") into its distinct characters. A '-' first or
+ * last is taken literally. Returns std::nullopt if the set is empty or a range runs backwards */
+std::optional<std::string> expandCharacterSet(std::string_view set) {
+    std::bitset<256> members;
+    for (size_t i = 0; i < set.size(); i++) {
+        auto first = static_cast<uint8_t>(set[i]);
+        auto last = first;
+        if (i + 2 < set.size() && set[i + 1] == '-') {
+            last = static_cast<uint8_t>(set[i + 2]);
+            i += 2;
+        }
+        if (last < first) {
+            return std::nullopt;
+        }
+        for (unsigned c = first; c <= last; c++) {
+            members.set(c);
+        }
+    }
+
+    std::string chars;
+    for (unsigned c = 1; c < members.size(); c++) {
+        if (members.test(c)) {
+            chars.push_back(static_cast<char>(c));
+        }
+    }
+    return chars.empty() ? std::nullopt : std::optional<std::string>(chars);
+}
+
+/* Returns the value of an "argument" of the form "keyword" followed by the value, or std::nullopt if it has another
+ * form or no value */
+std::optional<std::string_view> getKeywordValue(std::string_view argument, std::string_view keyword) {
+    if (!argument.starts_with(keyword) || argument.size() == keyword.size()) {
+        return std::nullopt;
+    }
+    return argument.substr(keyword.size());
+}
+
+/* Appends the mask of a "MASK=c" argument to a descriptor "argument", nothing if "maskArgument" is empty. Returns false
+ * if it is malformed */
+bool appendMask(std::string &argument, const std::string &maskArgument) {
+    if (maskArgument.empty()) {
+        return true;
+    }
+    std::optional<std::string_view> mask = getKeywordValue(maskArgument, "MASK=");
+    if (!mask.has_value() || mask->size() != 1) {
+        return false;
+    }
+    argument.push_back(maskSeparator);
+    argument.push_back(mask->front());
+    return true;
+}
+
+/* Takes the mask appended by "appendMask" off a descriptor "argument" into "mask". Returns false if it is malformed */
+bool splitMask(std::string_view &argument, std::optional<char> &mask) {
+    size_t separator = argument.find(maskSeparator);
+    if (separator == std::string_view::npos) {
+        return true;
+    }
+    if (separator + 2 != argument.size()) {
+        return false;
+    }
+    mask = argument.back();
+    argument = argument.substr(0, separator);
+    return true;
+}
+
+/* Stages of a pipeline beyond which it is rejected, its descriptor being sent to every server */
+const size_t maxPipelineStages = 16;
+
+/* Separate the stages of a pipeline, and the type of a stage from its arguments and its arguments from each other */
+const char stageSeparator = ',';
+const char stageArgumentSeparator = ':';
+
+/* Splits "list" at every "separator", keeping empty items */
+std::vector<std::string_view> splitList(std::string_view list, char separator) {
+    std::vector<std::string_view> items;
+    for (size_t start = 0;;) {
+        size_t end = list.find(separator, start);
+        items.push_back(list.substr(start, end - start));
+        if (end == std::string_view::npos) {
+            return items;
+        }
+        start = end + 1;
+    }
+}
+
+/* Appends the descriptor of a pipeline stage to a pipeline descriptor "argument", prefixed with its size */
+void appendStage(std::string &argument, const SchemaDescriptor &stage) {
+    std::string bytes = stage.encode();
+    auto size = static_cast<uint32_t>(bytes.size());
+    argument.append(reinterpret_cast<const char *>(&size), sizeof(size));
+    argument += bytes;
+}
+
+/* Takes the first stage appended by "appendStage" off a pipeline descriptor "argument". Returns std::nullopt if it is
+ * malformed */
+std::optional<SchemaDescriptor> takeStage(std::string_view &argument) {
+    uint32_t size;
+    if (argument.size() < sizeof(size)) {
+        return std::nullopt;
+    }
+    std::memcpy(&size, argument.data(), sizeof(size));
+    argument.remove_prefix(sizeof(size));
+    if (argument.size() < size) {
+        return std::nullopt;
+    }
+    std::optional<SchemaDescriptor> stage = SchemaDescriptor::decode(argument.substr(0, size));
+    argument.remove_prefix(size);
+    return stage;
+}
+
+/* Appends a stage of "type" to composed byte-wise stages. Returns false if the stage isn't byte-wise or its descriptor
+ * "argument" is malformed */
+bool appendByteStage(ByteStages &stages, SchemaType type, std::string_view argument) {
+    std::optional<char> mask;
+    switch (type) {
+    case SchemaType::EQUIVALENT:
+        return true;
+    case SchemaType::REVERSE:
+        stages.appendReverse();
+        return true;
+    case SchemaType::CENSORED:
+        if (!splitMask(argument, mask) || argument.empty()) {
+            return false;
+        }
+        stages.appendCensor(argument, mask);
+        return true;
+    default:
+        return false;
+    }
+}
+} // namespace
+
 AbstractResponseSchema ResponseSchemaFactory::createSchema(const AbstractTokens &tokens) {
-    switch (getSchemaType(tokens->getChoice())) {
+    std::optional<SchemaDescriptor> descriptor = compileDescriptor(tokens);
+    return descriptor.has_value() ? createSchema(*descriptor) : nullptr;
+}
+
+AbstractResponseSchema ResponseSchemaFactory::createSchema(const SchemaDescriptor &descriptor) {
+    switch (descriptor.type) {
     case SchemaType::EQUIVALENT:
         return std::make_unique<EquivalentResponseSchema>();
     case SchemaType::REVERSE:
         return std::make_unique<ReverseResponseSchema>();
     case SchemaType::CENSORED:
-        return newCensoredSchema(tokens);
+        return createCensoredSchema(descriptor.argument);
     case SchemaType::PALINDROME:
         return std::make_unique<PalindromeResponseSchema>();
+    case SchemaType::BLOCKLIST:
+        return createBlocklistSchema(descriptor.argument);
+    case SchemaType::PIPELINE:
+        return createPipelineSchema(descriptor.argument);
     default:
         return nullptr;
     }
 }
 
+std::optional<SchemaDescriptor> ResponseSchemaFactory::compileDescriptor(const AbstractTokens &tokens) {
+    SchemaDescriptor descriptor;
+    descriptor.type = getSchemaType(tokens->getChoice());
+
+    if (descriptor.type == SchemaType::UNKNOWN) {
+        return std::nullopt;
+    } else if (descriptor.type == SchemaType::CENSORED) {
+        std::optional<std::string> argument =
+            compileCensoredArgument(tokens->getChoiceArgument(), tokens->getNextChoiceArgument());
+        if (!argument.has_value()) {
+            return std::nullopt;
+        }
+        descriptor.argument = std::move(*argument);
+    } else if (descriptor.type == SchemaType::BLOCKLIST) {
+        std::optional<std::string> argument =
+            compileBlocklistArgument(tokens->getChoiceArgument(), tokens->getNextChoiceArgument());
+        if (!argument.has_value()) {
+            return std::nullopt;
+        }
+        descriptor.argument = std::move(*argument);
+    } else if (descriptor.type == SchemaType::PIPELINE) {
+        std::optional<std::string> argument = compilePipelineArgument(tokens->getChoiceArgument());
+        if (!argument.has_value()) {
+            return std::nullopt;
+        }
+        descriptor.argument = std::move(*argument);
+    }
+    return descriptor;
+}
+
+AbstractResponseSchema ResponseSchemaFactory::createCensoredSchema(const std::string &argument) {
+    std::string_view chars = argument;
+    std::optional<char> mask;
+    if (!splitMask(chars, mask) || chars.empty()) {
+        return nullptr;
+    }
+    return std::make_unique<CensoredResponseSchema>(chars, mask);
+}
+
+AbstractResponseSchema ResponseSchemaFactory::createBlocklistSchema(const std::string &argument) {
+    std::string_view path = argument;
+    std::optional<char> mask;
+    if (!splitMask(path, mask)) {
+        return nullptr;
+    }
+    // Read again by every server, so a file changed since the dispatcher checked it takes effect as it is now
+    std::optional<std::vector<std::string>> words = readBlocklist(std::string(path));
+    if (!words.has_value()) {
+        return nullptr;
+    }
+    try {
+        return std::make_unique<BlocklistResponseSchema>(BlocklistAutomaton(*words), mask);
+    } catch (const std::length_error &) {
+        return nullptr;
+    }
+}
+
+std::optional<std::string> ResponseSchemaFactory::compileCensoredArgument(const std::string &charsArgument,
+                                                                          const std::string &maskArgument) {
+    std::optional<std::string> chars;
+    if (std::optional<std::string_view> set = getKeywordValue(charsArgument, "CHARS=")) {
+        chars = expandCharacterSet(*set);
+    } else if (std::optional<std::string_view> single = getKeywordValue(charsArgument, "CHAR=")) {
+        chars = std::string(single->substr(0, 1));
+    }
+    if (!chars.has_value()) {
+        return std::nullopt;
+    }
+
+    if (!appendMask(*chars, maskArgument)) {
+        return std::nullopt;
+    }
+    return chars;
+}
+
+std::optional<std::string> ResponseSchemaFactory::compileBlocklistArgument(const std::string &fileArgument,
+                                                                           const std::string &maskArgument) {
+    std::optional<std::string_view> file = getKeywordValue(fileArgument, "FILE=");
+    if (!file.has_value() || file->find(maskSeparator) != std::string_view::npos) {
+        return std::nullopt;
+    }
+    // Checked here so that a missing or malformed file is reported right away rather than by every server. The path is
+    // made absolute for servers that don't share the dispatcher's working directory
+    std::string path = std::filesystem::absolute(*file).string();
+    if (!readBlocklist(path).has_value() || !appendMask(path, maskArgument)) {
+        return std::nullopt;
+    }
+    return path;
+}
+
+AbstractResponseSchema ResponseSchemaFactory::createPipelineSchema(const std::string &argument) {
+    std::vector<AbstractResponseSchema> stages;
+    // Byte-wise stages since the last stage that isn't, to be run as one
+    std::optional<ByteStages> byteStages;
+    std::string_view rest = argument;
+    while (!rest.empty()) {
+        std::optional<SchemaDescriptor> stage = takeStage(rest);
+        if (!stage.has_value() || stage->type == SchemaType::PIPELINE) {
+            return nullptr;
+        }
+        if (stage->type == SchemaType::EQUIVALENT || stage->type == SchemaType::REVERSE ||
+            stage->type == SchemaType::CENSORED) {
+            if (!byteStages.has_value()) {
+                byteStages.emplace();
+            }
+            if (!appendByteStage(*byteStages, stage->type, stage->argument)) {
+                return nullptr;
+            }
+            continue;
+        }
+
+        if (byteStages.has_value()) {
+            stages.push_back(std::make_unique<FusedResponseSchema>(*byteStages));
+            byteStages.reset();
+        }
+        AbstractResponseSchema schema = createSchema(*stage);
+        if (schema == nullptr) {
+            return nullptr;
+        }
+        stages.push_back(std::move(schema));
+    }
+    if (byteStages.has_value()) {
+        stages.push_back(std::make_unique<FusedResponseSchema>(*byteStages));
+    }
+
+    if (stages.empty()) {
+        return nullptr;
+    } else if (stages.size() == 1) {
+        return std::move(stages.front());
+    }
+    return std::make_unique<PipelineResponseSchema>(std::move(stages));
+}
+
+std::optional<std::string> ResponseSchemaFactory::compilePipelineArgument(const std::string &stagesArgument) {
+    std::vector<std::string_view> stages = splitList(stagesArgument, stageSeparator);
+    if (stagesArgument.empty() || stages.size() > maxPipelineStages) {
+        return std::nullopt;
+    }
+
+    std::string argument;
+    for (std::string_view stage : stages) {
+        // Tokens of a command setting the stage as the schema, without the option, which compileDescriptor ignores
+        std::vector<std::string> stageTokens = {""};
+        for (std::string_view token : splitList(stage, stageArgumentSeparator)) {
+            stageTokens.emplace_back(token);
+        }
+        AbstractTokens tokens = std::make_unique<RuntimeTokens>(stageTokens);
+        std::optional<SchemaDescriptor> descriptor = compileDescriptor(tokens);
+        if (stageTokens.size() > 4 || !descriptor.has_value() || descriptor->type == SchemaType::PIPELINE) {
+            return std::nullopt;
+        }
+        appendStage(argument, *descriptor);
+    }
+    return argument;
+}
+
 SchemaType ResponseSchemaFactory::getSchemaType(const std::string &schemaType) {
     static const std::unordered_map<std::string, SchemaType> choiceToType = {{"EQUIVALENT", SchemaType::EQUIVALENT},
                                                                              {"REVERSE", SchemaType::REVERSE},
                                                                              {"CENSORED", SchemaType::CENSORED},
-                                                                             {"PALINDROME", SchemaType::PALINDROME}};
+                                                                             {"PALINDROME", SchemaType::PALINDROME},
+                                                                             {"BLOCKLIST", SchemaType::BLOCKLIST},
+                                                                             {"PIPELINE", SchemaType::PIPELINE}};
 
     auto it = choiceToType.find(schemaType);
     if (it != choiceToType.end()) {
@@ -30,19 +340,4 @@ SchemaType ResponseSchemaFactory::getSchemaType(const std::string &schemaType) {
         return SchemaType::UNKNOWN;
     }
 }
-
-std::unique_ptr<CensoredResponseSchema> ResponseSchemaFactory::newCensoredSchema(const AbstractTokens &tokens) {
-    std::string arg = tokens->getChoiceArgument();
-    std::string keyword = "CHAR=";
-    size_t keywordPosition = arg.find(keyword);
-    char censoredChar;
-
-    if (keywordPosition != std::string::npos) {
-        censoredChar = arg[keywordPosition + keyword.length()];
-    } else {
-        return nullptr;
-    }
-
-    return std::make_unique<CensoredResponseSchema>(censoredChar);
-}
 } // namespace echo
\ No newline at end of file
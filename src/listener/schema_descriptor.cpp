@@ -0,0 +1,34 @@
+#include <cstring>
+
+#include "listener/schema_descriptor.hpp"
+
+namespace echo {
+
+namespace {
+const size_t headerSize = sizeof(uint64_t) + sizeof(uint8_t);
+} // namespace
+
+std::string SchemaDescriptor::encode() const {
+    std::string bytes(headerSize, '\0');
+    std::memcpy(bytes.data(), &version, sizeof(version));
+    bytes[sizeof(version)] = static_cast<char>(type);
+    bytes += argument;
+    return bytes;
+}
+
+std::optional<SchemaDescriptor> SchemaDescriptor::decode(std::string_view bytes) {
+    if (bytes.size() < headerSize) {
+        return std::nullopt;
+    }
+
+    SchemaDescriptor descriptor;
+    std::memcpy(&descriptor.version, bytes.data(), sizeof(descriptor.version));
+    auto type = static_cast<uint8_t>(bytes[sizeof(descriptor.version)]);
+    if (type >= static_cast<uint8_t>(SchemaType::UNKNOWN)) {
+        return std::nullopt;
+    }
+    descriptor.type = static_cast<SchemaType>(type);
+    descriptor.argument = bytes.substr(headerSize);
+    return descriptor;
+}
+} // namespace echo
\ No newline at end of file
@@ -0,0 +1,597 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ECHO_X86_KERNELS
+#endif
+
+#include "listener/schema_kernels.hpp"
+
+namespace echo {
+
+namespace {
+/* Every kernel swaps a word (or vector) from both ends at a time, reversing the bytes of each on the way. A middle of
+ * one to two words is reversed by swapping its first and last word, which overlap but get the same bytes written to
+ * the overlap, so only a middle shorter than a word is left to a narrower kernel */
+void reverseScalar(char *data, size_t size) {
+    char *low = data;
+    char *high = data + size;
+    while (high - low >= 8) {
+        // Both words are loaded before either is stored, as they may overlap
+        uint64_t front, back;
+        std::memcpy(&front, low, 8);
+        std::memcpy(&back, high - 8, 8);
+        front = __builtin_bswap64(front);
+        back = __builtin_bswap64(back);
+        std::memcpy(low, &back, 8);
+        std::memcpy(high - 8, &front, 8);
+        if (high - low <= 16) {
+            return;
+        }
+        low += 8;
+        high -= 8;
+    }
+    std::reverse(low, high);
+}
+
+/* Copies the bytes of "in" that "table" doesn't contain to "out", which may be "in" or before it. Every byte is written
+ * and only counted if kept, so there is no branch to mispredict. Returns the number of bytes kept */
+size_t censorBytes(const CensorTable &table, const char *in, size_t size, char *out) {
+    // A local copy, as the bytes written could alias the table and make it reloaded for every byte
+    const CensorTable local = table;
+    size_t kept = 0;
+    for (size_t i = 0; i < size; i++) {
+        char c = in[i];
+        out[kept] = c;
+        kept += !local.contains(c);
+    }
+    return kept;
+}
+
+size_t censorScalar(const CensorTable &table, char *data, size_t size) { return censorBytes(table, data, size, data); }
+
+void maskScalar(const CensorTable &table, char mask, char *data, size_t size) {
+    const CensorTable local = table;
+    for (size_t i = 0; i < size; i++) {
+        data[i] = local.contains(data[i]) ? mask : data[i];
+    }
+}
+
+/* The fused kernels are specialized for every combination of removing, masking and reversing, so a pipeline pays for
+ * nothing it doesn't do. Reversing commutes with the byte-wise stages, so a kernel reverses while it removes and masks:
+ * it swaps from both ends if it doesn't remove, or otherwise reads backwards and writes forwards. The latter would
+ * overwrite bytes not read yet when writing in place, which rather removes going forwards and reverses what is left */
+template <bool Removes, bool Masks, bool Reverses>
+size_t fusedScalar(const FusedCensorTables &tables, const char *in, size_t size, char *out) {
+    const CensorTable removed = tables.removed;
+    const CensorTable masked = tables.masked;
+    const char mask = tables.mask;
+    auto maskByte = [&](char c) { return Masks && masked.contains(c) ? mask : c; };
+
+    if constexpr (Reverses && !Removes) {
+        size_t low = 0;
+        size_t high = size;
+        for (; high - low >= 2; low++, high--) {
+            char front = in[low];
+            char back = in[high - 1];
+            out[low] = maskByte(back);
+            out[high - 1] = maskByte(front);
+        }
+        if (high > low) {
+            out[low] = maskByte(in[low]);
+        }
+        return size;
+    } else if constexpr (Reverses) {
+        if (out == in) {
+            size_t kept = fusedScalar<true, Masks, false>(tables, in, size, out);
+            reverseScalar(out, kept);
+            return kept;
+        }
+        size_t kept = 0;
+        for (size_t i = size; i-- > 0;) {
+            char c = in[i];
+            out[kept] = maskByte(c);
+            kept += !removed.contains(c);
+        }
+        return kept;
+    } else {
+        size_t kept = 0;
+        for (size_t i = 0; i < size; i++) {
+            char c = in[i];
+            out[kept] = maskByte(c);
+            kept += !Removes || !removed.contains(c);
+        }
+        return kept;
+    }
+}
+
+#ifdef ECHO_X86_KERNELS
+/* The vector kernels are built for their own instruction set through the target attribute, so the rest of the server
+ * keeps running on any x86 CPU */
+__attribute__((target("ssse3"))) inline __m128i reverse128(__m128i bytes) {
+    return _mm_shuffle_epi8(bytes, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+__attribute__((target("ssse3"))) void reverseSsse3(char *data, size_t size) {
+    char *low = data;
+    char *high = data + size;
+    while (high - low >= 16) {
+        __m128i front = _mm_loadu_si128(reinterpret_cast<const __m128i *>(low));
+        __m128i back = _mm_loadu_si128(reinterpret_cast<const __m128i *>(high - 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(low), reverse128(back));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(high - 16), reverse128(front));
+        if (high - low <= 32) {
+            return;
+        }
+        low += 16;
+        high -= 16;
+    }
+    reverseScalar(low, high - low);
+}
+
+__attribute__((target("avx2"))) inline __m256i reverse256(__m256i bytes) {
+    // Byte shuffles only move bytes within a 128 bit lane, so the lanes are swapped afterwards
+    const __m256i reversed = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12,
+                                              11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(bytes, reversed), 0x4E);
+}
+
+__attribute__((target("avx2"))) void reverseAvx2(char *data, size_t size) {
+    char *low = data;
+    char *high = data + size;
+    while (high - low >= 32) {
+        __m256i front = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(low));
+        __m256i back = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(high - 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(low), reverse256(back));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(high - 32), reverse256(front));
+        if (high - low <= 64) {
+            return;
+        }
+        low += 32;
+        high -= 32;
+    }
+    // The SSSE3 kernels finishing the AVX2 ones are encoded without VEX, which is slow while the upper halves of the
+    // vector registers are dirty, and the compiler doesn't clear them before calls
+    _mm256_zeroupper();
+    reverseSsse3(low, high - low);
+}
+
+/* Byte shuffle of every 8 bit keep mask, packing the kept bytes of 8 to the front (the bytes after them are left over
+ * and get overwritten by the next ones kept), along with the number of bytes kept. The count is looked up since CPUs
+ * with SSSE3 may lack POPCNT */
+struct CompactionShuffle {
+    uint64_t shuffle;
+    uint64_t kept;
+};
+
+constexpr std::array<CompactionShuffle, 256> makeCompactionShuffles() {
+    std::array<CompactionShuffle, 256> shuffles{};
+    for (unsigned keep = 0; keep < 256; keep++) {
+        for (int byte = 0; byte < 8; byte++) {
+            if (keep & (1u << byte)) {
+                shuffles[keep].shuffle |= static_cast<uint64_t>(byte) << (8 * shuffles[keep].kept++);
+            }
+        }
+    }
+    return shuffles;
+}
+
+constexpr std::array<CompactionShuffle, 256> compactionShuffles = makeCompactionShuffles();
+
+/* Packs the bytes of the 8 at "in" whose bit is set in "keep" to "out", which is "in" or before it. Writes 8 bytes
+ * either way, so the ones after the kept bytes must not be live. Returns the position after the kept bytes */
+__attribute__((target("ssse3"))) inline char *compactGroup(const char *in, unsigned keep, char *out) {
+    __m128i group = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in));
+    __m128i shuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(&compactionShuffles[keep].shuffle));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(group, shuffle));
+    return out + compactionShuffles[keep].kept;
+}
+
+/* Nibble tables of a CensorTable loaded into vectors, along with the constants of the lookup */
+struct CensorVectors128 {
+    __m128i lowBits[2];
+    __m128i highBit; // bit "high nibble % 8" of every high nibble
+};
+
+__attribute__((target("ssse3"))) CensorVectors128 loadCensorVectors128(const CensorTable &table) {
+    return {{_mm_load_si128(reinterpret_cast<const __m128i *>(table.lowNibbleBits[0])),
+             _mm_load_si128(reinterpret_cast<const __m128i *>(table.lowNibbleBits[1]))},
+            _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128)};
+}
+
+/* Returns 0xff for every byte of "bytes" to keep and 0 for every censored one. Indices with the top bit set make a
+ * byte shuffle return 0, so keeping the top bit of the byte (or of the byte flipped) in the index picks the table */
+__attribute__((target("ssse3"))) inline __m128i findKept128(const CensorVectors128 &vectors, __m128i bytes) {
+    __m128i index = _mm_and_si128(bytes, _mm_set1_epi8(static_cast<char>(0x8f)));
+    __m128i lowBits = _mm_or_si128(_mm_shuffle_epi8(vectors.lowBits[0], index),
+                                   _mm_shuffle_epi8(vectors.lowBits[1], _mm_xor_si128(index, _mm_set1_epi8(-128))));
+    __m128i highBit = _mm_shuffle_epi8(vectors.highBit, _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0f)));
+    return _mm_cmpeq_epi8(_mm_and_si128(lowBits, highBit), _mm_setzero_si128());
+}
+
+__attribute__((target("ssse3"))) size_t censorSsse3(const CensorTable &table, char *data, size_t size) {
+    const CensorVectors128 vectors = loadCensorVectors128(table);
+    const char *in = data;
+    const char *end = data + size;
+    char *out = data;
+    for (; end - in >= 16; in += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+        unsigned keep = _mm_movemask_epi8(findKept128(vectors, bytes));
+        if (keep == 0xffff) {
+            // Most messages censor little, so whole vectors are only moved and not even that before the first removal
+            if (out != in) {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), bytes);
+            }
+            out += 16;
+        } else if (keep != 0) {
+            out = compactGroup(in, keep & 0xff, out);
+            out = compactGroup(in + 8, keep >> 8, out);
+        }
+    }
+    return (out - data) + censorBytes(table, in, end - in, out);
+}
+
+__attribute__((target("ssse3"))) void maskSsse3(const CensorTable &table, char mask, char *data, size_t size) {
+    const CensorVectors128 vectors = loadCensorVectors128(table);
+    const __m128i masks = _mm_set1_epi8(mask);
+    char *position = data;
+    char *end = data + size;
+    for (; end - position >= 16; position += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+        __m128i kept = findKept128(vectors, bytes);
+        bytes = _mm_or_si128(_mm_and_si128(kept, bytes), _mm_andnot_si128(kept, masks));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(position), bytes);
+    }
+    maskScalar(table, mask, position, end - position);
+}
+
+/* Replaces the bytes of "masked" among "bytes" with "masks", if the kernel masks */
+template <bool Masks>
+__attribute__((target("ssse3"))) inline __m128i maskVector128(const CensorVectors128 &masked, __m128i masks,
+                                                               __m128i bytes) {
+    if constexpr (Masks) {
+        __m128i kept = findKept128(masked, bytes);
+        return _mm_or_si128(_mm_and_si128(kept, bytes), _mm_andnot_si128(kept, masks));
+    }
+    return bytes;
+}
+
+/* Packs the bytes of "bytes" whose bit is set in "keep" to "out". Writes 16 bytes either way. Unlike compactGroup the
+ * bytes are taken from a register, as the fused kernels change them before */
+__attribute__((target("ssse3"))) inline char *compactVector128(__m128i bytes, unsigned keep, char *out) {
+    if (keep == 0xffff) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), bytes);
+        return out + 16;
+    }
+    alignas(16) char staged[16];
+    _mm_store_si128(reinterpret_cast<__m128i *>(staged), bytes);
+    out = compactGroup(staged, keep & 0xff, out);
+    return compactGroup(staged + 8, keep >> 8, out);
+}
+
+template <bool Removes, bool Masks, bool Reverses>
+__attribute__((target("ssse3"))) size_t fusedSsse3(const FusedCensorTables &tables, const char *in, size_t size,
+                                                   char *out) {
+    if constexpr (Reverses && Removes) {
+        if (out == in) {
+            size_t kept = fusedSsse3<true, Masks, false>(tables, in, size, out);
+            reverseSsse3(out, kept);
+            return kept;
+        }
+    }
+    [[maybe_unused]] const CensorVectors128 removed = loadCensorVectors128(tables.removed);
+    [[maybe_unused]] const CensorVectors128 masked = loadCensorVectors128(tables.masked);
+    [[maybe_unused]] const __m128i masks = _mm_set1_epi8(tables.mask);
+
+    if constexpr (Reverses && !Removes) {
+        size_t low = 0;
+        size_t high = size;
+        while (high - low >= 16) {
+            __m128i front = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + low));
+            __m128i back = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + high - 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + low),
+                             maskVector128<Masks>(masked, masks, reverse128(back)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + high - 16),
+                             maskVector128<Masks>(masked, masks, reverse128(front)));
+            if (high - low <= 32) {
+                return size;
+            }
+            low += 16;
+            high -= 16;
+        }
+        fusedScalar<false, Masks, true>(tables, in + low, high - low, out + low);
+        return size;
+    } else if constexpr (!Removes) {
+        size_t i = 0;
+        for (; size - i >= 16; i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), maskVector128<Masks>(masked, masks, bytes));
+        }
+        fusedScalar<false, Masks, false>(tables, in + i, size - i, out + i);
+        return size;
+    } else {
+        char *written = out;
+        size_t read = 0;
+        for (; size - read >= 16; read += 16) {
+            const char *position = Reverses ? in + size - read - 16 : in + read;
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+            if constexpr (Reverses) {
+                bytes = reverse128(bytes);
+            }
+            unsigned keep = _mm_movemask_epi8(findKept128(removed, bytes));
+            written = compactVector128(maskVector128<Masks>(masked, masks, bytes), keep, written);
+        }
+        // Reading backwards leaves the bytes at the front of the message
+        const char *rest = Reverses ? in : in + read;
+        return (written - out) + fusedScalar<true, Masks, Reverses>(tables, rest, size - read, written);
+    }
+}
+
+/* The 256 bit versions of the vectors and the lookup, shuffling both 128 bit lanes alike */
+struct CensorVectors256 {
+    __m256i lowBits[2];
+    __m256i highBit;
+};
+
+__attribute__((target("avx2"))) CensorVectors256 loadCensorVectors256(const CensorTable &table) {
+    CensorVectors128 vectors = loadCensorVectors128(table);
+    return {{_mm256_broadcastsi128_si256(vectors.lowBits[0]), _mm256_broadcastsi128_si256(vectors.lowBits[1])},
+            _mm256_broadcastsi128_si256(vectors.highBit)};
+}
+
+__attribute__((target("avx2"))) inline __m256i findKept256(const CensorVectors256 &vectors, __m256i bytes) {
+    __m256i index = _mm256_and_si256(bytes, _mm256_set1_epi8(static_cast<char>(0x8f)));
+    __m256i lowBits =
+        _mm256_or_si256(_mm256_shuffle_epi8(vectors.lowBits[0], index),
+                        _mm256_shuffle_epi8(vectors.lowBits[1], _mm256_xor_si256(index, _mm256_set1_epi8(-128))));
+    __m256i highBit =
+        _mm256_shuffle_epi8(vectors.highBit, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0f)));
+    return _mm256_cmpeq_epi8(_mm256_and_si256(lowBits, highBit), _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2"))) size_t censorAvx2(const CensorTable &table, char *data, size_t size) {
+    const CensorVectors256 vectors = loadCensorVectors256(table);
+    const char *in = data;
+    const char *end = data + size;
+    char *out = data;
+    for (; end - in >= 32; in += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in));
+        auto keep = static_cast<uint32_t>(_mm256_movemask_epi8(findKept256(vectors, bytes)));
+        if (keep == 0xffffffff) {
+            if (out != in) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), bytes);
+            }
+            out += 32;
+        } else if (keep != 0) {
+            for (int group = 0; group < 4; group++) {
+                out = compactGroup(in + 8 * group, (keep >> (8 * group)) & 0xff, out);
+            }
+        }
+    }
+    return (out - data) + censorBytes(table, in, end - in, out);
+}
+
+__attribute__((target("avx2"))) void maskAvx2(const CensorTable &table, char mask, char *data, size_t size) {
+    const CensorVectors256 vectors = loadCensorVectors256(table);
+    const __m256i masks = _mm256_set1_epi8(mask);
+    char *position = data;
+    char *end = data + size;
+    for (; end - position >= 32; position += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(position));
+        bytes = _mm256_blendv_epi8(masks, bytes, findKept256(vectors, bytes));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(position), bytes);
+    }
+    _mm256_zeroupper();
+    maskSsse3(table, mask, position, end - position);
+}
+
+template <bool Masks>
+__attribute__((target("avx2"))) inline __m256i maskVector256(const CensorVectors256 &masked, __m256i masks,
+                                                              __m256i bytes) {
+    if constexpr (Masks) {
+        return _mm256_blendv_epi8(masks, bytes, findKept256(masked, bytes));
+    }
+    return bytes;
+}
+
+__attribute__((target("avx2"))) inline char *compactVector256(__m256i bytes, uint32_t keep, char *out) {
+    if (keep == 0xffffffff) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), bytes);
+        return out + 32;
+    }
+    alignas(32) char staged[32];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(staged), bytes);
+    for (int group = 0; group < 4; group++) {
+        out = compactGroup(staged + 8 * group, (keep >> (8 * group)) & 0xff, out);
+    }
+    return out;
+}
+
+template <bool Removes, bool Masks, bool Reverses>
+__attribute__((target("avx2"))) size_t fusedAvx2(const FusedCensorTables &tables, const char *in, size_t size,
+                                                 char *out) {
+    if constexpr (Reverses && Removes) {
+        if (out == in) {
+            size_t kept = fusedAvx2<true, Masks, false>(tables, in, size, out);
+            reverseAvx2(out, kept);
+            return kept;
+        }
+    }
+    [[maybe_unused]] const CensorVectors256 removed = loadCensorVectors256(tables.removed);
+    [[maybe_unused]] const CensorVectors256 masked = loadCensorVectors256(tables.masked);
+    [[maybe_unused]] const __m256i masks = _mm256_set1_epi8(tables.mask);
+
+    if constexpr (Reverses && !Removes) {
+        size_t low = 0;
+        size_t high = size;
+        while (high - low >= 32) {
+            __m256i front = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + low));
+            __m256i back = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + high - 32));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + low),
+                                maskVector256<Masks>(masked, masks, reverse256(back)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + high - 32),
+                                maskVector256<Masks>(masked, masks, reverse256(front)));
+            if (high - low <= 64) {
+                return size;
+            }
+            low += 32;
+            high -= 32;
+        }
+        _mm256_zeroupper();
+        fusedSsse3<false, Masks, true>(tables, in + low, high - low, out + low);
+        return size;
+    } else if constexpr (!Removes) {
+        size_t i = 0;
+        for (; size - i >= 32; i += 32) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), maskVector256<Masks>(masked, masks, bytes));
+        }
+        _mm256_zeroupper();
+        fusedSsse3<false, Masks, false>(tables, in + i, size - i, out + i);
+        return size;
+    } else {
+        char *written = out;
+        size_t read = 0;
+        for (; size - read >= 32; read += 32) {
+            const char *position = Reverses ? in + size - read - 32 : in + read;
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(position));
+            if constexpr (Reverses) {
+                bytes = reverse256(bytes);
+            }
+            auto keep = static_cast<uint32_t>(_mm256_movemask_epi8(findKept256(removed, bytes)));
+            written = compactVector256(maskVector256<Masks>(masked, masks, bytes), keep, written);
+        }
+        const char *rest = Reverses ? in : in + read;
+        _mm256_zeroupper();
+        return (written - out) + fusedSsse3<true, Masks, Reverses>(tables, rest, size - read, written);
+    }
+}
+#endif
+} // namespace
+
+SimdLevel detectSimdLevel() {
+    static const SimdLevel level = []() {
+#ifdef ECHO_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::AVX2;
+        }
+        if (__builtin_cpu_supports("ssse3")) {
+            return SimdLevel::SSSE3;
+        }
+#endif
+        return SimdLevel::SCALAR;
+    }();
+    return level;
+}
+
+const char *getSimdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSSE3:
+        return "SSSE3";
+    case SimdLevel::AVX2:
+        return "AVX2";
+    default:
+        return "SCALAR";
+    }
+}
+
+ReverseKernel getReverseKernel([[maybe_unused]] SimdLevel level) {
+#ifdef ECHO_X86_KERNELS
+    switch (level) {
+    case SimdLevel::SSSE3:
+        return reverseSsse3;
+    case SimdLevel::AVX2:
+        return reverseAvx2;
+    default:
+        break;
+    }
+#endif
+    return reverseScalar;
+}
+
+ReverseKernel getReverseKernel() {
+    static const ReverseKernel kernel = getReverseKernel(detectSimdLevel());
+    return kernel;
+}
+
+CensorTable::CensorTable(std::string_view chars) {
+    for (char c : chars) {
+        auto byte = static_cast<uint8_t>(c);
+        bitmap[byte / 64] |= uint64_t{1} << (byte % 64);
+        lowNibbleBits[byte >> 7][byte & 0x0f] |= 1 << ((byte >> 4) & 7);
+    }
+}
+
+CensorKernel getCensorKernel([[maybe_unused]] SimdLevel level) {
+#ifdef ECHO_X86_KERNELS
+    switch (level) {
+    case SimdLevel::SSSE3:
+        return censorSsse3;
+    case SimdLevel::AVX2:
+        return censorAvx2;
+    default:
+        break;
+    }
+#endif
+    return censorScalar;
+}
+
+CensorKernel getCensorKernel() {
+    static const CensorKernel kernel = getCensorKernel(detectSimdLevel());
+    return kernel;
+}
+
+MaskKernel getMaskKernel([[maybe_unused]] SimdLevel level) {
+#ifdef ECHO_X86_KERNELS
+    switch (level) {
+    case SimdLevel::SSSE3:
+        return maskSsse3;
+    case SimdLevel::AVX2:
+        return maskAvx2;
+    default:
+        break;
+    }
+#endif
+    return maskScalar;
+}
+
+MaskKernel getMaskKernel() {
+    static const MaskKernel kernel = getMaskKernel(detectSimdLevel());
+    return kernel;
+}
+FusedKernel getFusedKernel([[maybe_unused]] SimdLevel level, bool removes, bool masks, bool reverses) {
+    // Specializations of every level, indexed by removes * 4 + masks * 2 + reverses
+    static const FusedKernel scalarKernels[8] = {
+        fusedScalar<false, false, false>, fusedScalar<false, false, true>, fusedScalar<false, true, false>,
+        fusedScalar<false, true, true>,   fusedScalar<true, false, false>, fusedScalar<true, false, true>,
+        fusedScalar<true, true, false>,   fusedScalar<true, true, true>};
+    size_t index = removes * 4 + masks * 2 + reverses;
+#ifdef ECHO_X86_KERNELS
+    static const FusedKernel ssse3Kernels[8] = {
+        fusedSsse3<false, false, false>, fusedSsse3<false, false, true>, fusedSsse3<false, true, false>,
+        fusedSsse3<false, true, true>,   fusedSsse3<true, false, false>, fusedSsse3<true, false, true>,
+        fusedSsse3<true, true, false>,   fusedSsse3<true, true, true>};
+    static const FusedKernel avx2Kernels[8] = {
+        fusedAvx2<false, false, false>, fusedAvx2<false, false, true>, fusedAvx2<false, true, false>,
+        fusedAvx2<false, true, true>,   fusedAvx2<true, false, false>, fusedAvx2<true, false, true>,
+        fusedAvx2<true, true, false>,   fusedAvx2<true, true, true>};
+    switch (level) {
+    case SimdLevel::SSSE3:
+        return ssse3Kernels[index];
+    case SimdLevel::AVX2:
+        return avx2Kernels[index];
+    default:
+        break;
+    }
+#endif
+    return scalarKernels[index];
+}
+
+FusedKernel getFusedKernel(bool removes, bool masks, bool reverses) {
+    return getFusedKernel(detectSimdLevel(), removes, masks, reverses);
+}
+} // namespace echo
\ No newline at end of file
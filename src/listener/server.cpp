@@ -1,9 +1,13 @@
+#include <algorithm>
 #include <csignal>
+#include <cstring>
+#include <exception>
 #include <fcntl.h>
 #include <iostream>
 #include <memory>
 #include <sys/socket.h>
 #include <system_error>
+#include <thread>
 #include <unistd.h>
 
 #include "listener/response_schema.hpp"
@@ -14,7 +18,10 @@ namespace echo {
 
 namespace {
 volatile std::sig_atomic_t serverShutdownRequested = false;
-const int maxClients = 50;
+
+/* Size of the buffer the pipe is read into, large enough for whole socketpair packets. Commands themselves go through
+ * the command ring, so the pipe only carries client hand-offs and the byte announcing each command */
+const size_t pipeBufferCapacity = maxChannelPacketSize;
 } // namespace
 
 void Server::signalHandler(int signum) {
@@ -23,166 +30,380 @@ void Server::signalHandler(int signum) {
     }
 }
 
-Server::Server(std::string pipeName)
-    : responseSchema(std::make_unique<EquivalentResponseSchema>()), pipeName(pipeName) {
-    int pipeFd = open(pipeName.c_str(), O_RDWR);
+bool Server::isShutdownRequested() { return serverShutdownRequested; }
+
+Server::Server(std::string pipeName, const ServerConfig &config)
+    : Listener(config.eventLoopType), responseSchema(std::make_shared<EquivalentResponseSchema>()),
+      pipeName(pipeName), pipeBuffer(pipeBufferCapacity), maxClients(config.maxClients) {
+    // Every client holds a socket, on top of the few descriptors of the pipe, listeners and reactors
+    raiseOpenFileLimit(static_cast<rlim_t>(maxClients) + 64);
+
+    pipeFd = open(pipeName.c_str(), O_RDWR);
 
     if (pipeFd == -1) {
         throw std::system_error(errno, std::generic_category(), "Server pipe opening error");
     }
 
-    fdsToPoll.emplace_back(pollfd{pipeFd, POLLIN, 0});
-
     int fcntlRes = fcntl(pipeFd, F_SETFL, fcntl(pipeFd, F_GETFL) | O_NONBLOCK);
     if (fcntlRes == -1) {
         throw std::system_error(errno, std::generic_category(), "Setting pipe mode to non-blocking error");
     }
+
+    createReactors(config);
 }
 
-Server::~Server() {
-    for (int i = getClientFdStartIdx(); i < fdsToPoll.size(); i++) {
-        close(fdsToPoll[i].fd);
+Server::Server(int channelFd, const ServerConfig &config)
+    : Listener(config.eventLoopType), responseSchema(std::make_shared<EquivalentResponseSchema>()), pipeFd(channelFd),
+      receivesFds(true), pipeBuffer(pipeBufferCapacity), maxClients(config.maxClients) {
+    raiseOpenFileLimit(static_cast<rlim_t>(maxClients) + 64);
+
+    int fcntlRes = fcntl(pipeFd, F_SETFL, fcntl(pipeFd, F_GETFL) | O_NONBLOCK);
+    if (fcntlRes == -1) {
+        throw std::system_error(errno, std::generic_category(), "Setting socketpair mode to non-blocking error");
+    }
+
+    createReactors(config);
+}
+
+Server::Server(std::shared_ptr<InProcessPipe> pipe, const ServerConfig &config)
+    : Listener(config.eventLoopType), responseSchema(std::make_shared<EquivalentResponseSchema>()),
+      pipeFd(pipe->getDoorbellFd()), inProcessPipe(std::move(pipe)), maxClients(config.maxClients) {
+    raiseOpenFileLimit(static_cast<rlim_t>(maxClients) + 64);
+    createReactors(config);
+}
+
+void Server::createReactors(const ServerConfig &config) {
+    int reactorCount = std::max(config.reactorCount, 1);
+    reactors.reserve(reactorCount);
+    for (int i = 0; i < reactorCount; i++) {
+        reactors.emplace_back(std::make_unique<Reactor>(*this, config, i));
     }
+}
 
-    close(getPipePollFd().fd);
-    unlink(pipeName.c_str());
+Server::~Server() {
+    // Reactors close the sockets of their clients
+    reactors.clear();
+
+    // The doorbell of a server thread belongs to its pipe
+    if (inProcessPipe == nullptr) {
+        close(getPipeFd());
+    }
+    if (parentPidFd != -1) {
+        close(parentPidFd);
+    }
+    if (!pipeName.empty()) {
+        unlink(pipeName.c_str());
+    }
 }
 
 void Server::start() {
-    std::signal(SIGINT, Server::signalHandler);
-    std::signal(SIGTERM, Server::signalHandler);
+    if (inProcessPipe == nullptr) {
+        std::signal(SIGINT, Server::signalHandler);
+        std::signal(SIGTERM, Server::signalHandler);
+    }
 
-    try {
-        while (!serverShutdownRequested) {
-            if (pollFileDescriptors() > 0) {
-                handleIncomingData();
-            }
+    // Termination signals are left to the thread running the first reactor, which then stops the others
+    sigset_t terminationSignals;
+    sigset_t previousMask;
+    sigemptyset(&terminationSignals);
+    sigaddset(&terminationSignals, SIGINT);
+    sigaddset(&terminationSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &terminationSignals, &previousMask);
+
+    // A reactor failing stops all the others, so that its error reaches the caller rather than leaving the server half
+    // running
+    std::vector<std::exception_ptr> errors(reactors.size());
+    auto runReactor = [this, &errors](size_t idx) {
+        try {
+            reactors[idx]->run();
+        } catch (...) {
+            errors[idx] = std::current_exception();
         }
-    } catch (const std::runtime_error &e) {
-        std::cerr << e.what() << std::endl;
+        stop();
+    };
+
+    std::vector<std::jthread> reactorThreads;
+    for (size_t i = 1; i < reactors.size(); i++) {
+        reactorThreads.emplace_back(runReactor, i);
+    }
+    pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+
+    runReactor(0);
+    reactorThreads.clear();
+
+    for (const std::exception_ptr &error : errors) {
+        if (error != nullptr) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    BufferPoolStats stats = getBufferPoolStats();
+    std::cout << "Server " << getpid() << ": buffer pools reserved " << stats.reservedBytes / 1024 << " KiB in "
+              << stats.slabCount << " slabs, peak use " << stats.usedHighWaterMark / 1024 << " KiB" << std::endl;
+}
+
+void Server::stop() {
+    for (const auto &reactor : reactors) {
+        reactor->stop();
     }
 }
 
-template <typename T> ssize_t Server::readPipe(T *dest, std::string errorMsg, ssize_t size) {
-    ssize_t bytesRead = read(getPipePollFd().fd, dest, size);
-    bool errorOccurred = bytesRead == -1 && errno != EAGAIN;
-    bool hasDataAvailable = bytesRead != 0 && !(bytesRead == -1 && errno == EAGAIN);
+void Server::setResponseSchema(AbstractResponseSchema schema) {
+    std::lock_guard<std::mutex> lock(responseSchemaMutex);
+    responseSchema = std::move(schema);
+    responseSchemaVersion.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<IResponseSchema> Server::getResponseSchema() const {
+    std::lock_guard<std::mutex> lock(responseSchemaMutex);
+    return responseSchema;
+}
 
-    if (errorOccurred) {
-        throw std::system_error(errno, std::generic_category(), errorMsg);
-    } else if (!hasDataAvailable) {
-        return 0;
+size_t Server::getClientCount() const {
+    size_t clientCount = 0;
+    for (const auto &reactor : reactors) {
+        clientCount += reactor->getClientCount();
     }
+    return clientCount;
+}
 
-    return bytesRead;
+BufferPoolStats Server::getBufferPoolStats() const {
+    BufferPoolStats total{};
+    for (const auto &reactor : reactors) {
+        BufferPoolStats stats = reactor->getBufferPoolStats();
+        total.reservedBytes += stats.reservedBytes;
+        total.usedBytes += stats.usedBytes;
+        // Reactors peak at different times, so the sum is an upper bound of the process' peak
+        total.usedHighWaterMark += stats.usedHighWaterMark;
+        total.slabCount += stats.slabCount;
+    }
+    return total;
 }
 
 void Server::acceptPipeData() {
-    std::byte pipeFlag;
+    if (receivesFds) {
+        receiveChannelPackets();
+        return;
+    } else if (inProcessPipe != nullptr) {
+        receiveRingChunks();
+        return;
+    }
 
     while (true) {
-        if (readPipe(&pipeFlag, "Reading pipe flag from the pipe error") == 0) {
+        ssize_t bytesRead = read(getPipeFd(), pipeBuffer.data() + pipeBufferSize, pipeBuffer.size() - pipeBufferSize);
+        if (bytesRead == -1) {
+            if (errno == EAGAIN) {
+                break;
+            } else if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Reading from the pipe error");
+        } else if (bytesRead == 0) {
             break;
         }
 
-        if (pipeFlag == newClientFdPipeFlag) {
-            int decodedClientFd;
-            readPipe(&decodedClientFd, "Reading client fd from the pipe error");
-
-            int newClientFd = duplicateClientFd(decodedClientFd);
-            clientPool.emplace_back(newClientFd);
-            fdsToPoll.emplace_back(pollfd{newClientFd, POLLIN, 0});
-        } else if (pipeFlag == commandPipeFlag) {
-            uint16_t commandLen;
-            readPipe(&commandLen, "Reading command length from the pipe error");
-
-            char commandBuf[commandLen];
-            readPipe(commandBuf, "Reading command from the pipe error", commandLen);
-            setResponseSchemaFromCommand(std::string(commandBuf, commandLen));
-        }
+        // A batch of messages from the dispatcher may end in the middle of a message, which is kept for the next read
+        pipeBufferSize += bytesRead;
+        size_t handled = handlePipeMessages(pipeBuffer.data(), pipeBufferSize);
+        std::memmove(pipeBuffer.data(), pipeBuffer.data() + handled, pipeBufferSize - handled);
+        pipeBufferSize -= handled;
     }
 }
 
-void Server::setResponseSchemaFromCommand(std::string command) {
-    ResponseSchemaFactory schemaFactory;
-    AbstractResponseSchema schema;
+void Server::acceptClientsFrom(AbstractSocket listener) {
+    listener->bind();
+    listener->initOptions(listener->getsocketFd());
+    startListening(*listener);
+    listenerPool.emplace_back(std::move(listener));
+}
 
-    schema = schemaFactory.createSchema(std::make_unique<RuntimeTokens>(command));
-    if (schema == nullptr) {
-        schema = schemaFactory.createSchema(std::make_unique<StartupTokens>(command));
+bool Server::acceptListenerClients(int fd) {
+    ISocket *listener = findListener(fd);
+    if (listener == nullptr) {
+        return false;
     }
 
-    if (schema != nullptr) {
-        setResponseSchema(std::move(schema));
-    } else {
-        std::cout << "Server " << getpid() << ": Unknown response schema or its configuration" << std::endl;
+    // Clients accepted here never went through the dispatcher, so they only count towards the active clients
+    try {
+        for (int clientFd = listener->setupNewConnection(); clientFd != INVALID_SOCKET_FD;
+             clientFd = listener->setupNewConnection()) {
+            addClient(clientFd, listener->getFraming());
+        }
+    } catch (const std::system_error &e) {
+        // e.g out of file descriptors, the connections left pending are retried on the next readiness
+        std::cerr << "Server " << getpid() << ": " << e.what() << std::endl;
     }
+    return true;
 }
 
-int Server::duplicateClientFd(int fd) {
-    int ppidFd = syscall(SYS_pidfd_open, getppid(), 0);
-    if (ppidFd == -1) {
-        throw std::system_error(errno, std::generic_category(), "Getting parent pidfd error");
-    }
+void Server::retire() {
+    retiring = true;
 
-    int clientFd = syscall(SYS_pidfd_getfd, ppidFd, fd, 0);
-    if (clientFd == -1) {
-        throw std::system_error(errno, std::generic_category(), "Duplicating client fd error");
+    // Connections to the server's own listeners go to the other servers from now on (e.g the rest of a SO_REUSEPORT
+    // group), or are refused
+    for (const AbstractSocket &listener : listenerPool) {
+        reactors[0]->stopWatching(listener->getsocketFd());
     }
+    closeListenerSockets();
 
-    return clientFd;
+    std::cout << "Server " << getpid() << ": Retiring with " << getClientCount() << " clients left" << std::endl;
+    stopIfDrained();
 }
 
-int Server::pollFileDescriptors() {
-    int numReady = poll(fdsToPoll.data(), fdsToPoll.size(), -1);
-    if (numReady == -1 && errno != EINTR) {
-        throw std::system_error(errno, std::generic_category(), "Server poll fds error");
+void Server::stopIfDrained() {
+    if (isRetiring() && getClientCount() == 0) {
+        stop();
     }
-    return numReady;
 }
 
-void Server::handleIncomingData() {
-    if (getPipePollFd().revents & POLLIN) {
-        acceptPipeData();
-    }
+void Server::receiveChannelPackets() {
+    alignas(struct cmsghdr) char control[CMSG_SPACE(maxFdsPerPacket * sizeof(int))];
+
+    while (true) {
+        struct iovec iov {pipeBuffer.data(), pipeBuffer.size()};
+        struct msghdr message {};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        ssize_t bytesRead = recvmsg(getPipeFd(), &message, MSG_CMSG_CLOEXEC);
+        if (bytesRead == -1) {
+            if (errno == EAGAIN) {
+                break;
+            } else if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Receiving from the socketpair error");
+        } else if (bytesRead == 0) {
+            // The dispatcher is gone, so no more clients or commands can ever arrive
+            serverShutdownRequested = true;
+            break;
+        }
 
-    for (size_t i = getClientFdStartIdx(), end = fdsToPoll.size(); i < end; i++) {
-        if (!(fdsToPoll[i].revents & (POLLIN | POLLHUP))) {
-            continue;
+        std::span<const int> fds;
+        struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+        if (header != nullptr && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            fds = std::span<const int>(reinterpret_cast<const int *>(CMSG_DATA(header)),
+                                       (header->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        }
+        if (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) {
+            std::cout << "Server " << getpid() << ": Dropped part of a truncated dispatcher packet" << std::endl;
         }
 
-        int clientSocket = fdsToPoll[i].fd;
-        char buffer[bufferSize];
-        int bytesRead = receiveFromClient(i, buffer);
+        // Packets hold whole messages, so nothing carries over to the next one
+        handlePipeMessages(pipeBuffer.data(), bytesRead, fds);
+    }
+}
+
+void Server::receiveRingChunks() {
+    inProcessPipe->resetDoorbell();
+
+    std::string chunk;
+    while (inProcessPipe->getChunks().pop(chunk)) {
+        // Chunks hold whole messages, so nothing carries over to the next one
+        handlePipeMessages(reinterpret_cast<const std::byte *>(chunk.data()), chunk.size());
+    }
+    inProcessPipe->signalSpace();
+}
+
+size_t Server::handlePipeMessages(const std::byte *data, size_t size, std::span<const int> fds) {
+    const size_t clientMessageSize = sizeof(std::byte) + sizeof(int) + sizeof(FramingType);
+    size_t offset = 0;
+    size_t fdIdx = 0;
+
+    while (offset < size) {
+        const std::byte *message = data + offset;
+        size_t available = size - offset;
 
-        if (bytesRead == 0) {
-            closeClientConnection(i);
-            std::cout << "Connection closed by a client " << std::endl;
+        if (message[0] == newClientFdPipeFlag) {
+            if (available < clientMessageSize) {
+                break;
+            }
+            int decodedClientFd;
+            std::memcpy(&decodedClientFd, message + sizeof(std::byte), sizeof(int));
+            auto framing = static_cast<FramingType>(message[sizeof(std::byte) + sizeof(int)]);
+            offset += clientMessageSize;
+            if (inProcessPipe != nullptr) {
+                addClient(decodedClientFd, framing);
+            } else if (!receivesFds) {
+                addClient(duplicateClientFd(decodedClientFd), framing);
+            } else if (fdIdx < fds.size()) {
+                addClient(fds[fdIdx++], framing);
+            }
+            // Published after the client became active (or was refused), so the dispatcher never misses it in between
+            getLoad().receivedClients.fetch_add(1, std::memory_order_release);
+        } else if (message[0] == commandPipeFlag) {
+            offset += sizeof(commandPipeFlag);
+            std::string command;
+            if (controlBlock->commands.pop(command)) {
+                handleControlMessage(command);
+            }
         } else {
-            std::string data(buffer, bytesRead);
-            responseSchema->generateResponse(data);
-            std::string response = data + "\n";
-            send(clientSocket, response.c_str(), response.length(), 0);
+            // Not a message start, skipped byte by byte like unknown flags always were
+            offset++;
         }
     }
+
+    for (; fdIdx < fds.size(); fdIdx++) {
+        close(fds[fdIdx]);
+    }
+    return offset;
 }
 
-int Server::receiveFromClient(int pollFdIdx, char *buffer) {
-    int bytesRead = recv(fdsToPoll[pollFdIdx].fd, buffer, bufferSize, 0);
-    if (bytesRead == -1) {
-        throw std::system_error(errno, std::generic_category(), "Error reading from client");
+void Server::handleControlMessage(std::string_view message) {
+    if (message.empty()) {
+        return;
+    }
+
+    auto type = static_cast<ControlMessageType>(message[0]);
+    if (type == ControlMessageType::RETIRE) {
+        retire();
+    } else if (type == ControlMessageType::SET_RESPONSE_SCHEMA) {
+        // The dispatcher validated the schema when compiling it, so this only fails on a corrupted message or a
+        // blocklist file broken since. The server then keeps its schema, which --list-servers shows
+        std::optional<SchemaDescriptor> descriptor = SchemaDescriptor::decode(message.substr(1));
+        AbstractResponseSchema schema;
+        if (descriptor.has_value()) {
+            schema = ResponseSchemaFactory().createSchema(*descriptor);
+        }
+        if (schema == nullptr) {
+            std::cerr << "Server " << getpid() << ": Invalid response schema descriptor" << std::endl;
+            return;
+        }
+
+        setResponseSchema(std::move(schema));
+        controlBlock->schemaVersion.store(descriptor->version, std::memory_order_release);
     }
-    return bytesRead;
 }
 
-void Server::closeClientConnection(int pollFdIdx) {
-    int clientSocket = fdsToPoll[pollFdIdx].fd;
+int Server::duplicateClientFd(int fd) {
+    if (parentPidFd == -1) {
+        parentPidFd = syscall(SYS_pidfd_open, getppid(), 0);
+        if (parentPidFd == -1) {
+            throw std::system_error(errno, std::generic_category(), "Getting parent pidfd error");
+        }
+    }
+
+    int clientFd = syscall(SYS_pidfd_getfd, parentPidFd, fd, 0);
+    if (clientFd == -1) {
+        throw std::system_error(errno, std::generic_category(), "Duplicating client fd error");
+    }
+
+    return clientFd;
+}
 
-    if (close(clientSocket) == -1) {
-        throw std::system_error(errno, std::generic_category(), "Error closing client connection");
+void Server::addClient(int clientFd, FramingType framing) {
+    if (getClientCount() >= static_cast<size_t>(maxClients)) {
+        // Shut down rather than only closed, since the dispatcher may still hold the socket open
+        shutdown(clientFd, SHUT_RDWR);
+        close(clientFd);
+        std::cout << "Server " << getpid() << ": Refused a client over the limit of " << maxClients << " clients"
+                  << std::endl;
+        return;
     }
 
-    fdsToPoll.erase(fdsToPoll.begin() + pollFdIdx);
-    clientPool.erase(clientPool.begin() + (pollFdIdx - getClientFdStartIdx()));
+    reactors[nextReactorIdx]->enqueueClient(clientFd, framing);
+    nextReactorIdx = (nextReactorIdx + 1) % reactors.size();
 }
 } // namespace echo
\ No newline at end of file
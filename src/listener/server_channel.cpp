@@ -0,0 +1,283 @@
+#include <cstring>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+
+#include "listener/server_channel.hpp"
+
+namespace echo {
+
+InProcessPipe::InProcessPipe() {
+    doorbellFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (doorbellFd == -1) {
+        throw std::system_error(errno, std::generic_category(), "Failed to create the doorbell of a server thread");
+    }
+    spaceFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (spaceFd == -1) {
+        int error = errno;
+        close(doorbellFd);
+        throw std::system_error(error, std::generic_category(), "Failed to create the space eventfd of a server thread");
+    }
+}
+
+InProcessPipe::~InProcessPipe() {
+    close(doorbellFd);
+    close(spaceFd);
+}
+
+void InProcessPipe::ring() {
+    // The counter only overflows after billions of rings the server didn't reset, so a failure is never fatal
+    uint64_t one = 1;
+    write(doorbellFd, &one, sizeof(one));
+}
+
+void InProcessPipe::resetDoorbell() {
+    uint64_t count;
+    read(doorbellFd, &count, sizeof(count));
+}
+
+void InProcessPipe::wantSpace() {
+    uint64_t count;
+    read(spaceFd, &count, sizeof(count));
+
+    // Pairs with the fence of "signalSpace": either the server sees the flag, or the push that follows sees the room
+    // the server made
+    spaceWanted.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void InProcessPipe::signalSpace() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (spaceWanted.load(std::memory_order_relaxed) && spaceWanted.exchange(false, std::memory_order_relaxed)) {
+        uint64_t one = 1;
+        write(spaceFd, &one, sizeof(one));
+    }
+}
+
+ServerChannel::ServerChannel(const std::string &pipePath, ControlRing &commandRing) : commandRing(commandRing) {
+    // Opened for reading as well, so that opening never blocks and writes never fail while the server is starting
+    fd = open(pipePath.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "Failed to open the dispatcher->server pipe");
+    }
+}
+
+ServerChannel::ServerChannel(int socketFd, ControlRing &commandRing)
+    : fd(socketFd), commandRing(commandRing), passesFds(true) {}
+
+ServerChannel::ServerChannel(std::shared_ptr<InProcessPipe> pipe, ControlRing &commandRing)
+    : fd(pipe->getDoorbellFd()), commandRing(commandRing), inProcessPipe(std::move(pipe)) {}
+
+ServerChannel::~ServerChannel() {
+    // Client sockets that never made it to the server are dropped
+    dropQueued();
+    if (inProcessPipe == nullptr) {
+        close(fd);
+    }
+}
+
+void ServerChannel::queueClient(int clientFd, FramingType framing) {
+    std::byte message[sizeof(std::byte) + sizeof(int) + sizeof(FramingType)];
+    message[0] = newClientFdPipeFlag;
+    std::memcpy(&message[sizeof(std::byte)], &clientFd, sizeof(int));
+    message[sizeof(std::byte) + sizeof(int)] = static_cast<std::byte>(framing);
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queued.insert(queued.end(), message, message + sizeof(message));
+    if (passesFds || inProcessPipe != nullptr) {
+        queuedMessages.emplace_back(queued.size(), clientFd);
+    }
+}
+
+bool ServerChannel::queueControlMessage(ControlMessageType type, std::string_view payload) {
+    std::string message(1, static_cast<char>(type));
+    message += payload;
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (!commandRing.push(message)) {
+        return false;
+    }
+
+    queued.emplace_back(commandPipeFlag);
+    if (passesFds || inProcessPipe != nullptr) {
+        queuedMessages.emplace_back(queued.size(), -1);
+    }
+    return true;
+}
+
+bool ServerChannel::flush() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return flushQueued();
+}
+
+void ServerChannel::flushBlocking(int serverPidFd) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (!flushQueued()) {
+        // A FIFO is held open for reading by the dispatcher too, so a server that died never makes room in it
+        lock.unlock();
+        struct pollfd watched[2] = {{getSpaceFd(), getSpaceEvents(), 0}, {serverPidFd, POLLIN, 0}};
+        poll(watched, 2, -1);
+        lock.lock();
+        if (watched[1].revents & POLLIN) {
+            dropQueued();
+            return;
+        }
+    }
+}
+
+bool ServerChannel::hasQueuedData() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return queuedOffset < queued.size();
+}
+
+HandoffTransport ServerChannel::getHandoffTransport(const std::string &choice) {
+    if (choice == "PIDFD") {
+        return HandoffTransport::PIDFD;
+    } else if (choice == "SCM_RIGHTS") {
+        return HandoffTransport::SOCKETPAIR;
+    }
+    return HandoffTransport::UNKNOWN;
+}
+
+void ServerChannel::dropQueued() {
+    for (size_t i = queuedMessageIdx; i < queuedMessages.size(); i++) {
+        if (queuedMessages[i].second != -1) {
+            close(queuedMessages[i].second);
+        }
+    }
+
+    queued.clear();
+    queuedOffset = 0;
+    queuedMessages.clear();
+    queuedMessageIdx = 0;
+}
+
+bool ServerChannel::flushQueued() {
+    if (passesFds) {
+        return sendQueuedPackets();
+    } else if (inProcessPipe != nullptr) {
+        return pushQueuedChunks();
+    }
+
+    while (queuedOffset < queued.size()) {
+        // Messages may be split across writes, since the server reassembles them from the byte stream
+        ssize_t bytesWritten = write(fd, queued.data() + queuedOffset, queued.size() - queuedOffset);
+        if (bytesWritten == -1) {
+            if (errno == EAGAIN) {
+                return false;
+            } else if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Failed to write to the dispatcher->server pipe");
+        }
+        queuedOffset += bytesWritten;
+    }
+
+    queued.clear();
+    queuedOffset = 0;
+    return true;
+}
+
+bool ServerChannel::sendQueuedPackets() {
+    int fds[maxFdsPerPacket];
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+
+    while (queuedMessageIdx < queuedMessages.size()) {
+        // Packets end on a message boundary, since the server handles every packet on its own
+        size_t fdCount = 0;
+        size_t lastMessageIdx = queuedMessageIdx;
+        for (; lastMessageIdx < queuedMessages.size(); lastMessageIdx++) {
+            auto [end, clientFd] = queuedMessages[lastMessageIdx];
+            bool fits = end - queuedOffset <= maxChannelPacketSize && (clientFd == -1 || fdCount < maxFdsPerPacket);
+            if (!fits && lastMessageIdx > queuedMessageIdx) {
+                break;
+            }
+            if (clientFd != -1) {
+                fds[fdCount++] = clientFd;
+            }
+        }
+        size_t packetEnd = queuedMessages[lastMessageIdx - 1].first;
+
+        struct iovec iov {queued.data() + queuedOffset, packetEnd - queuedOffset};
+        struct msghdr message {};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        if (fdCount > 0) {
+            message.msg_control = control;
+            message.msg_controllen = CMSG_SPACE(fdCount * sizeof(int));
+            struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+            header->cmsg_level = SOL_SOCKET;
+            header->cmsg_type = SCM_RIGHTS;
+            header->cmsg_len = CMSG_LEN(fdCount * sizeof(int));
+            std::memcpy(CMSG_DATA(header), fds, fdCount * sizeof(int));
+        }
+
+        if (sendmsg(fd, &message, MSG_DONTWAIT | MSG_NOSIGNAL) == -1) {
+            if (errno == EAGAIN) {
+                return false;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno == EPIPE || errno == ECONNRESET) {
+                // The server died, its clients are closed rather than left waiting for it
+                dropQueued();
+                return true;
+            }
+            throw std::system_error(errno, std::generic_category(), "Failed to send to the dispatcher->server socket");
+        }
+
+        // The server holds its own reference to the sockets now
+        for (size_t i = 0; i < fdCount; i++) {
+            close(fds[i]);
+        }
+        queuedOffset = packetEnd;
+        queuedMessageIdx = lastMessageIdx;
+    }
+
+    queued.clear();
+    queuedOffset = 0;
+    queuedMessages.clear();
+    queuedMessageIdx = 0;
+    return true;
+}
+
+bool ServerChannel::pushQueuedChunks() {
+    bool pushed = false;
+    while (queuedMessageIdx < queuedMessages.size()) {
+        // Chunks end on a message boundary, since the server handles every chunk on its own
+        size_t lastMessageIdx = queuedMessageIdx + 1;
+        while (lastMessageIdx < queuedMessages.size() &&
+               queuedMessages[lastMessageIdx].first - queuedOffset <= maxRingChunkSize) {
+            lastMessageIdx++;
+        }
+        size_t chunkEnd = queuedMessages[lastMessageIdx - 1].first;
+
+        std::string_view chunk(reinterpret_cast<const char *>(queued.data() + queuedOffset), chunkEnd - queuedOffset);
+        if (!inProcessPipe->getChunks().push(chunk)) {
+            // The server is behind, the rest is pushed once it signals that it took chunks out of its ring
+            inProcessPipe->wantSpace();
+            if (!inProcessPipe->getChunks().push(chunk)) {
+                break;
+            }
+        }
+        pushed = true;
+        queuedOffset = chunkEnd;
+        queuedMessageIdx = lastMessageIdx;
+    }
+
+    // A single ring for the whole batch, the server taking out every chunk pushed before it reset the doorbell
+    if (pushed) {
+        inProcessPipe->ring();
+    }
+    if (queuedMessageIdx < queuedMessages.size()) {
+        return false;
+    }
+
+    queued.clear();
+    queuedOffset = 0;
+    queuedMessages.clear();
+    queuedMessageIdx = 0;
+    return true;
+}
+} // namespace echo
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <new>
+#include <sys/mman.h>
+#include <system_error>
+#include <utility>
+
+#include "listener/server_load.hpp"
+
+namespace echo {
+
+size_t toLatencyBucket(int64_t latencyNanos) {
+    uint64_t micros = latencyNanos > 0 ? latencyNanos / 1000 : 0;
+    return std::min<size_t>(std::bit_width(micros), latencyBucketCount - 1);
+}
+
+double ServerStats::getLatencyPercentileMicros(double percentile) const {
+    uint64_t total = 0;
+    for (uint64_t count : latencyBuckets) {
+        total += count;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t wanted = std::max<uint64_t>(1, total * percentile / 100);
+    uint64_t seen = 0;
+    for (size_t i = 0; i + 1 < latencyBucketCount; i++) {
+        seen += latencyBuckets[i];
+        if (seen >= wanted) {
+            return static_cast<double>(uint64_t{1} << i);
+        }
+    }
+    return std::numeric_limits<double>::infinity();
+}
+
+ServerLoadMonitor::ServerLoadMonitor(int serverId) : serverId(serverId) {
+    void *memory =
+        mmap(nullptr, sizeof(ServerControlBlock), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "Server control block memory mapping error");
+    }
+    controlBlock = new (memory) ServerControlBlock();
+}
+
+ServerLoadMonitor::~ServerLoadMonitor() {
+    if (controlBlock != nullptr) {
+        munmap(controlBlock, sizeof(ServerControlBlock));
+    }
+}
+
+ServerLoadMonitor::ServerLoadMonitor(ServerLoadMonitor &&other) noexcept
+    : controlBlock(std::exchange(other.controlBlock, nullptr)), serverId(other.serverId),
+      dispatchedClients(other.dispatchedClients) {}
+
+ServerLoadMonitor &ServerLoadMonitor::operator=(ServerLoadMonitor &&other) noexcept {
+    if (this != &other) {
+        if (controlBlock != nullptr) {
+            munmap(controlBlock, sizeof(ServerControlBlock));
+        }
+        controlBlock = std::exchange(other.controlBlock, nullptr);
+        serverId = other.serverId;
+        dispatchedClients = other.dispatchedClients;
+    }
+    return *this;
+}
+
+ServerStats ServerLoadMonitor::getStats() const {
+    ServerStats total;
+    for (const ReactorStats &slot : controlBlock->reactorStats) {
+        total.messages += slot.messages.load(std::memory_order_relaxed);
+        total.bytesReceived += slot.bytesReceived.load(std::memory_order_relaxed);
+        total.bytesSent += slot.bytesSent.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < latencyBucketCount; i++) {
+            total.latencyBuckets[i] += slot.latencyBuckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+uint64_t ServerLoadMonitor::getClientCount() const {
+    // Received before active, so a client moving from one to the other in between is never missed
+    uint64_t receivedClients = getLoad().receivedClients.load(std::memory_order_acquire);
+    int64_t activeClients = getLoad().activeClients.load(std::memory_order_relaxed);
+
+    uint64_t inFlight = dispatchedClients > receivedClients ? dispatchedClients - receivedClients : 0;
+    return inFlight + (activeClients > 0 ? activeClients : 0);
+}
+
+double ServerLoadMonitor::getLoadScore() const {
+    double clients = getClientCount() + static_cast<double>(getBufferedBytes()) / bufferedBytesPerClient;
+    return clients * (1 + getLatencyMicros() / 1e3);
+}
+} // namespace echo
\ No newline at end of file
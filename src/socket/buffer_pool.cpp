@@ -0,0 +1,137 @@
+#include <bit>
+#include <sys/mman.h>
+#include <system_error>
+
+#include "socket/buffer_pool.hpp"
+
+namespace echo {
+
+namespace {
+/* Index of the size class of buffers of "size" bytes (at most "maxPooledBufferSize") */
+size_t sizeClassOf(size_t size) {
+    return size <= minPooledBufferSize ? 0 : std::bit_width(size - 1) - std::bit_width(minPooledBufferSize - 1);
+}
+
+size_t sizeOfClass(size_t sizeClass) { return minPooledBufferSize << sizeClass; }
+} // namespace
+
+Buffer &Buffer::operator=(Buffer &&other) noexcept {
+    if (this != &other) {
+        reset();
+        pool = std::exchange(other.pool, nullptr);
+        data = std::exchange(other.data, nullptr);
+        capacity = std::exchange(other.capacity, 0);
+    }
+    return *this;
+}
+
+void Buffer::reset() {
+    if (data == nullptr) {
+        return;
+    }
+
+    if (pool != nullptr) {
+        pool->release(data, capacity);
+    } else {
+        delete[] data;
+    }
+    data = nullptr;
+    capacity = 0;
+}
+
+BufferPool::~BufferPool() {
+    for (const auto &[memory, size] : mappings) {
+        munmap(memory, size);
+    }
+}
+
+Buffer BufferPool::acquire(size_t size) {
+    char *data;
+    size_t capacity;
+
+    if (size > maxPooledBufferSize) {
+        capacity = size;
+        data = mapMemory(capacity);
+    } else {
+        size_t sizeClass = sizeClassOf(size);
+        capacity = sizeOfClass(sizeClass);
+
+        if (freeLists[sizeClass] != nullptr) {
+            data = reinterpret_cast<char *>(freeLists[sizeClass]);
+            freeLists[sizeClass] = freeLists[sizeClass]->next;
+        } else if (capacity >= slabSize) {
+            data = mapMemory(capacity);
+        } else {
+            // Leftovers of the previous slab are dropped, which wastes at most one buffer per slab
+            if (slabRemaining < capacity) {
+                slabCursor = mapMemory(slabSize);
+                slabRemaining = slabSize;
+                slabCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            data = slabCursor;
+            slabCursor += capacity;
+            slabRemaining -= capacity;
+        }
+    }
+
+    size_t used = usedBytes.fetch_add(capacity, std::memory_order_relaxed) + capacity;
+    if (used > usedHighWaterMark.load(std::memory_order_relaxed)) {
+        usedHighWaterMark.store(used, std::memory_order_relaxed);
+    }
+    return Buffer(this, data, capacity);
+}
+
+Buffer BufferPool::allocate(BufferPool *pool, size_t size) {
+    if (pool != nullptr) {
+        return pool->acquire(size);
+    }
+    return Buffer(nullptr, new char[size], size);
+}
+
+BufferPoolStats BufferPool::getStats() const {
+    return {reservedBytes.load(std::memory_order_relaxed), usedBytes.load(std::memory_order_relaxed),
+            usedHighWaterMark.load(std::memory_order_relaxed), slabCount.load(std::memory_order_relaxed)};
+}
+
+void BufferPool::release(char *data, size_t capacity) {
+    usedBytes.fetch_sub(capacity, std::memory_order_relaxed);
+
+    if (capacity > maxPooledBufferSize) {
+        for (auto it = mappings.begin(); it != mappings.end(); it++) {
+            if (it->first == data) {
+                munmap(data, capacity);
+                reservedBytes.fetch_sub(capacity, std::memory_order_relaxed);
+                mappings.erase(it);
+                break;
+            }
+        }
+        return;
+    }
+
+    size_t sizeClass = sizeClassOf(capacity);
+    auto *block = reinterpret_cast<FreeBlock *>(data);
+    block->next = freeLists[sizeClass];
+    freeLists[sizeClass] = block;
+}
+
+char *BufferPool::mapMemory(size_t size) {
+    void *memory = MAP_FAILED;
+    if (hugePages && size % slabSize == 0) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+
+    if (memory == MAP_FAILED) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "Buffer pool memory mapping error");
+        }
+        if (hugePages) {
+            madvise(memory, size, MADV_HUGEPAGE);
+        }
+    }
+
+    mappings.emplace_back(static_cast<char *>(memory), size);
+    reservedBytes.fetch_add(size, std::memory_order_relaxed);
+    return static_cast<char *>(memory);
+}
+} // namespace echo
\ No newline at end of file
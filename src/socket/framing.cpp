@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstring>
+#include <unordered_map>
+
+#include "socket/framing.hpp"
+
+namespace echo {
+
+void Framing::appendFrame(std::string &out, FramingType type, std::string_view payload) {
+    char header[lengthHeaderSize];
+    out.append(header, encodeHeader(type, payload.size(), header));
+    out.append(payload);
+    out.append(frameTrailer(type));
+}
+
+size_t Framing::encodeHeader(FramingType type, size_t payloadSize, char *dest) {
+    if (type != FramingType::LENGTH) {
+        return 0;
+    }
+
+    uint32_t networkLength = htonl(static_cast<uint32_t>(payloadSize));
+    std::memcpy(dest, &networkLength, lengthHeaderSize);
+    return lengthHeaderSize;
+}
+
+std::string_view Framing::sealFrameInPlace(FramingType type, char *payload, size_t payloadSize) {
+    if (type == FramingType::LENGTH) {
+        encodeHeader(type, payloadSize, payload - lengthHeaderSize);
+        return std::string_view(payload - lengthHeaderSize, lengthHeaderSize + payloadSize);
+    }
+
+    payload[payloadSize] = '\n';
+    return std::string_view(payload, payloadSize + 1);
+}
+
+std::string_view Framing::frameTrailer(FramingType type) { return type == FramingType::LINE ? "\n" : ""; }
+
+FramingType Framing::getFramingType(const std::string &choice) {
+    static const std::unordered_map<std::string, FramingType> choiceToType = {{"LINE", FramingType::LINE},
+                                                                              {"LENGTH", FramingType::LENGTH}};
+
+    auto it = choiceToType.find(choice);
+    if (it != choiceToType.end()) {
+        return it->second;
+    } else {
+        return FramingType::UNKNOWN;
+    }
+}
+
+void FrameDecoder::feed(const char *data, size_t len) {
+    std::memcpy(getFeedBuffer(len), data, len);
+    commitFeed(len);
+}
+
+char *FrameDecoder::getFeedBuffer(size_t minLen) {
+    compact();
+
+    size_t capacity = buffer.getCapacity();
+    size_t unconsumed = size - consumed;
+    if (capacity - size < minLen) {
+        if (capacity - unconsumed >= minLen) {
+            std::memmove(buffer.getData(), buffer.getData() + consumed, unconsumed);
+            scanned = scanned > consumed ? scanned - consumed : 0;
+            size = unconsumed;
+            consumed = 0;
+        } else {
+            reallocate(std::max(2 * capacity, unconsumed + minLen));
+        }
+    }
+
+    return buffer.getData() + size;
+}
+
+bool FrameDecoder::nextFrame(std::string &payload) {
+    FrameView frame;
+    if (!nextFrame(frame)) {
+        return false;
+    }
+
+    payload.assign(frame.payload, frame.payloadSize);
+    return true;
+}
+
+bool FrameDecoder::nextFrame(FrameView &frame) {
+    size_t frameEnd;
+    if (oversized || !findFrame(frame, frameEnd)) {
+        return false;
+    }
+
+    consumed = frameEnd;
+    return true;
+}
+
+bool FrameDecoder::findFrame(FrameView &frame, size_t &frameEnd) {
+    char *data = buffer.getData();
+
+    if (type == FramingType::LINE) {
+        size_t scanFrom = std::max(scanned, consumed);
+        char *delimiter =
+            scanFrom < size ? static_cast<char *>(std::memchr(data + scanFrom, '\n', size - scanFrom)) : nullptr;
+        if (delimiter == nullptr) {
+            scanned = size;
+            oversized = size - consumed > maxFrameSize;
+            return false;
+        }
+
+        frame = {data + consumed, static_cast<size_t>(delimiter - (data + consumed))};
+        frameEnd = delimiter - data + 1;
+        return true;
+    }
+
+    if (size - consumed < lengthHeaderSize) {
+        return false;
+    }
+
+    uint32_t networkLength;
+    std::memcpy(&networkLength, data + consumed, lengthHeaderSize);
+    size_t payloadSize = ntohl(networkLength);
+    if (payloadSize > maxFrameSize) {
+        oversized = true;
+        return false;
+    }
+    if (size - consumed - lengthHeaderSize < payloadSize) {
+        return false;
+    }
+
+    frame = {data + consumed + lengthHeaderSize, payloadSize};
+    frameEnd = consumed + lengthHeaderSize + payloadSize;
+    return true;
+}
+
+Buffer FrameDecoder::detachBuffer() {
+    Buffer detached = std::move(buffer);
+    size_t unconsumed = size - consumed;
+
+    // The next frames are likely as large as the ones before, so the new buffer starts out just as large
+    buffer = BufferPool::allocate(pool, detached.getCapacity());
+    if (unconsumed > 0) {
+        std::memcpy(buffer.getData(), detached.getData() + consumed, unconsumed);
+    }
+    scanned = scanned > consumed ? scanned - consumed : 0;
+    size = unconsumed;
+    consumed = 0;
+
+    return detached;
+}
+
+void FrameDecoder::releaseIdleBuffer() {
+    if (consumed == size) {
+        buffer.reset();
+        size = consumed = scanned = 0;
+    }
+}
+
+void FrameDecoder::compact() {
+    if (consumed == size) {
+        size = consumed = scanned = 0;
+    } else if (consumed > size / 2) {
+        std::memmove(buffer.getData(), buffer.getData() + consumed, size - consumed);
+        scanned = scanned > consumed ? scanned - consumed : 0;
+        size -= consumed;
+        consumed = 0;
+    }
+}
+
+void FrameDecoder::reallocate(size_t minCapacity) {
+    Buffer reallocated = BufferPool::allocate(pool, minCapacity);
+    if (size > consumed) {
+        std::memcpy(reallocated.getData(), buffer.getData() + consumed, size - consumed);
+    }
+
+    buffer = std::move(reallocated);
+    scanned = scanned > consumed ? scanned - consumed : 0;
+    size -= consumed;
+    consumed = 0;
+}
+} // namespace echo
\ No newline at end of file
@@ -1,10 +1,13 @@
+#include <algorithm>
 #include <arpa/inet.h>
 #include <cstring>
 #include <fcntl.h>
 #include <functional>
 #include <iostream>
+#include <linux/filter.h>
 #include <netinet/tcp.h>
 #include <stdexcept>
+#include <unordered_map>
 
 #include "socket/socket.hpp"
 
@@ -22,6 +25,25 @@ InetSocket::InetSocket(int port) : port(port) {
     }
 }
 
+InetSocket::InetSocket(int port, bool reusePort) : InetSocket(port) {
+    int enable = 1;
+    if (reusePort && setsockopt(socketFd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int)) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Failed to set the internet socket to reuse its port");
+    }
+}
+
+ReusePortSteering InetSocket::getReusePortSteering(const std::string &choice) {
+    static const std::unordered_map<std::string, ReusePortSteering> choiceToType = {
+        {"CPU", ReusePortSteering::CPU}, {"HASH", ReusePortSteering::HASH}};
+
+    auto it = choiceToType.find(choice);
+    if (it != choiceToType.end()) {
+        return it->second;
+    } else {
+        return ReusePortSteering::UNKNOWN;
+    }
+}
+
 void InetSocket::bind() {
     struct sockaddr_in serverAddr {};
 
@@ -34,13 +56,47 @@ void InetSocket::bind() {
     }
 }
 
+void InetSocket::steerReusePortGroup(ReusePortSteering steering, int groupSize) {
+    // The program returns the index of the socket in the group (in the order the sockets started listening). An index
+    // past the sockets listening so far falls back to the kernel's own hash, which covers a group still filling up
+    uint32_t load = steering == ReusePortSteering::CPU ? SKF_AD_CPU : SKF_AD_RXHASH;
+    struct sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF) + load},
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(std::max(groupSize, 1))},
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+    struct sock_fprog program {
+        sizeof(code) / sizeof(code[0]), code
+    };
+
+    // Every socket of the group attaches the same program, replacing the group's previous one
+    if (setsockopt(socketFd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Failed to attach the reuseport steering program");
+    }
+}
+
+void InetSocket::setIncomingCpu(int cpu) {
+    if (setsockopt(socketFd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Failed to set the incoming CPU of the socket");
+    }
+}
+
 int InetSocket::setupNewConnection() {
     struct sockaddr_in clientAddr {};
 
     socklen_t clientAddrLen = sizeof(clientAddr);
 
-    int clientSocket = accept(socketFd, reinterpret_cast<struct sockaddr *>(&clientAddr), &clientAddrLen);
+    int clientSocket;
+    do {
+        clientSocket = accept4(socketFd, reinterpret_cast<struct sockaddr *>(&clientAddr), &clientAddrLen,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+        // Connections reset while waiting in the queue are skipped
+    } while (clientSocket == INVALID_SOCKET_FD && (errno == ECONNABORTED || errno == EINTR));
+
     if (clientSocket == INVALID_SOCKET_FD) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return INVALID_SOCKET_FD;
+        }
         throw std::system_error(errno, std::generic_category(), "Failed to accept a new internet socket connection");
     }
     initOptions(clientSocket);
@@ -52,11 +108,6 @@ int InetSocket::setupNewConnection() {
 }
 
 void InetSocket::initOptions(int socket) {
-    if (fcntl(socketFd, F_SETFL, O_NONBLOCK) == -1) {
-        throw std::system_error(errno, std::generic_category(),
-                                "Failed to set the internet socket to non-blocking mode");
-    }
-
     int flag = 1;
     if (setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(int)) == -1) {
         throw std::system_error(errno, std::generic_category(), "Failed to disable the Nagle algorithm");
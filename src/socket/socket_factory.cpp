@@ -1,5 +1,7 @@
 #include <cstring>
 #include <memory>
+#include <stdexcept>
+#include <sys/socket.h>
 
 #include "socket/socket_factory.hpp"
 
@@ -7,6 +9,22 @@ namespace echo {
 
 AbstractSocket SocketFactory::createClientSocket(int argc, char *argv[]) {
     std::vector<std::string> allArgs(argv, argv + argc);
+
+    // Optional trailing arguments choose the framing, which has to match the listener's, and whether the dispatcher
+    // redirects the client to a server
+    FramingType framing = FramingType::LINE;
+    bool redirected = false;
+    while (allArgs.size() > 2) {
+        if (allArgs.back() == "REDIRECT") {
+            redirected = true;
+        } else if (Framing::getFramingType(allArgs.back()) != FramingType::UNKNOWN) {
+            framing = Framing::getFramingType(allArgs.back());
+        } else {
+            break;
+        }
+        allArgs.pop_back();
+    }
+
     auto tokens = std::make_unique<StartupTokens>(allArgs);
     const std::string option = tokens->getOption();
     const std::string choice = tokens->getChoice();
@@ -24,7 +42,43 @@ AbstractSocket SocketFactory::createClientSocket(int argc, char *argv[]) {
         socket = std::make_unique<InetSocket>(serverPort);
     }
 
+    socket->setFraming(framing);
     socket->connectToServer(option);
+    if (redirected) {
+        return followRedirect(*socket, option);
+    }
+    return socket;
+}
+
+AbstractSocket SocketFactory::followRedirect(const ISocket &dispatcherSocket, const std::string &host) {
+    // The redirect line is all the dispatcher sends before closing the connection
+    std::string line;
+    char buffer[bufferSize];
+    while (line.find('\n') == std::string::npos && line.size() < bufferSize) {
+        ssize_t bytesRead = recv(dispatcherSocket.getsocketFd(), buffer, sizeof(buffer), 0);
+        if (bytesRead == -1 && errno == EINTR) {
+            continue;
+        } else if (bytesRead <= 0) {
+            break;
+        }
+        line.append(buffer, bytesRead);
+    }
+
+    size_t lineEnd = line.find('\n');
+    if (lineEnd == std::string::npos || !line.starts_with(redirectPrefix)) {
+        throw std::runtime_error("The dispatcher didn't redirect the client to a server");
+    }
+    std::string address = line.substr(redirectPrefix.size(), lineEnd - redirectPrefix.size());
+
+    AbstractSocket socket;
+    if (dynamic_cast<const UnixSocket *>(&dispatcherSocket) != nullptr) {
+        socket = std::make_unique<UnixSocket>(address);
+        socket->connectToServer(address);
+    } else {
+        socket = std::make_unique<InetSocket>(std::atoi(address.c_str()));
+        socket->connectToServer(host);
+    }
+    socket->setFraming(dispatcherSocket.getFraming());
     return socket;
 }
 
@@ -33,20 +33,25 @@ int UnixSocket::setupNewConnection() {
 
     socklen_t clientAddrLen = sizeof(clientAddr);
 
-    int clientSocket = accept(socketFd, reinterpret_cast<struct sockaddr *>(&clientAddr), &clientAddrLen);
+    int clientSocket;
+    do {
+        clientSocket = accept4(socketFd, reinterpret_cast<struct sockaddr *>(&clientAddr), &clientAddrLen,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+    } while (clientSocket == INVALID_SOCKET_FD && (errno == ECONNABORTED || errno == EINTR));
+
     if (clientSocket == INVALID_SOCKET_FD) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return INVALID_SOCKET_FD;
+        }
         throw std::system_error(errno, std::generic_category(), "Failed to accept a new unix socket connection");
     }
-    initOptions(clientSocket);
 
     std::cout << "Accepted connection from " << socketPath << std::endl;
     return clientSocket;
 }
 
-void UnixSocket::initOptions(int socket) {
-    if (fcntl(socket, F_SETFL, O_NONBLOCK) == -1) {
-        throw std::system_error(errno, std::generic_category(), "Failed to set the unix socket to non-blocking mode");
-    }
+void UnixSocket::initOptions([[maybe_unused]] int socket) {
+    // Accepted sockets are made non-blocking by accept4 itself, which leaves nothing to set up
 }
 
 void UnixSocket::connectToServer(const std::string &serverAddress) {
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include "listener/autoscaler.hpp"
+
+using namespace echo;
+
+namespace {
+std::vector<ServerLoadMonitor> makeServers(size_t count, uint64_t activeClients) {
+    std::vector<ServerLoadMonitor> servers;
+    for (size_t i = 0; i < count; i++) {
+        servers.emplace_back();
+        servers.back().getLoad().activeClients = activeClients;
+    }
+    return servers;
+}
+} // namespace
+
+TEST(Autoscaler, KeepsPoolWithinBounds) {
+    auto now = std::chrono::steady_clock::now();
+    Autoscaler autoscaler(2, 3, 1, 10);
+    EXPECT_EQ(autoscaler.getPoolChange(makeServers(1, 5), now), 1);
+
+    Autoscaler shrinking(2, 3, 1, 10);
+    EXPECT_EQ(shrinking.getPoolChange(makeServers(4, 5), now), -1);
+}
+
+TEST(Autoscaler, FollowsAverageLoad) {
+    auto now = std::chrono::steady_clock::now();
+    Autoscaler autoscaler(1, 4, 1, 10);
+    EXPECT_EQ(autoscaler.getPoolChange(makeServers(2, 5), now), 0);
+
+    now += autoscaleCooldown;
+    EXPECT_EQ(autoscaler.getPoolChange(makeServers(2, 20), now), 1);
+
+    now += autoscaleCooldown;
+    EXPECT_EQ(autoscaler.getPoolChange(makeServers(2, 0), now), -1);
+
+    // Bounds win over the load
+    now += autoscaleCooldown;
+    EXPECT_EQ(autoscaler.getPoolChange(makeServers(4, 20), now), 0);
+    EXPECT_EQ(autoscaler.getPoolChange(makeServers(1, 0), now), 0);
+}
+
+TEST(Autoscaler, WaitsForCooldownAfterChange) {
+    auto now = std::chrono::steady_clock::now();
+    Autoscaler autoscaler(1, 4, 1, 10);
+    auto busyServers = makeServers(2, 20);
+    EXPECT_EQ(autoscaler.getPoolChange(busyServers, now), 1);
+    EXPECT_EQ(autoscaler.getPoolChange(busyServers, now + autoscaleCooldown / 2), 0);
+    EXPECT_EQ(autoscaler.getPoolChange(busyServers, now + autoscaleCooldown), 1);
+}
+
+TEST(Autoscaler, RetiresServerWithFewestClients) {
+    auto servers = makeServers(3, 4);
+    servers[1].getLoad().activeClients = 1;
+    EXPECT_EQ(Autoscaler::pickServerToRetire(servers), 1);
+
+    servers[2].recordDispatchedClient();
+    servers[2].getLoad().activeClients = 0;
+    EXPECT_EQ(Autoscaler::pickServerToRetire(servers), 1);
+
+    servers[2].getLoad().receivedClients = 1;
+    EXPECT_EQ(Autoscaler::pickServerToRetire(servers), 2);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "listener/balancing_strategy.hpp"
+
+using namespace echo;
+
+namespace {
+/* Servers with IDs 1 to "count", the way the dispatcher numbers them */
+std::vector<ServerLoadMonitor> makeServers(size_t count) {
+    std::vector<ServerLoadMonitor> servers;
+    for (size_t i = 0; i < count; i++) {
+        servers.emplace_back(i + 1);
+    }
+    return servers;
+}
+
+/* Picks a server with "strategy" and hands it a client the way the dispatcher does */
+size_t dispatch(IBalancingStrategy &strategy, std::vector<ServerLoadMonitor> &servers) {
+    size_t picked = strategy.pickServer(servers);
+    servers[picked].recordDispatchedClient();
+    return picked;
+}
+} // namespace
+
+TEST(BalancingStrategy, RoundRobinTakesServersInTurn) {
+    auto servers = makeServers(3);
+    RoundRobinStrategy strategy;
+    for (size_t i = 0; i < 7; i++) {
+        EXPECT_EQ(dispatch(strategy, servers), i % 3);
+    }
+}
+
+TEST(BalancingStrategy, ClientsInFlightCountTowardsLoad) {
+    auto servers = makeServers(1);
+    ServerLoad &load = servers[0].getLoad();
+    servers[0].recordDispatchedClient();
+    servers[0].recordDispatchedClient();
+    EXPECT_EQ(servers[0].getClientCount(), 2);
+
+    // One client picked up and active, the other refused
+    load.activeClients = 1;
+    load.receivedClients = 2;
+    EXPECT_EQ(servers[0].getClientCount(), 1);
+
+    load.activeClients = 0;
+    EXPECT_EQ(servers[0].getClientCount(), 0);
+}
+
+TEST(BalancingStrategy, LeastConnectionsPicksFewestClients) {
+    auto servers = makeServers(3);
+    servers[0].getLoad().activeClients = 5;
+    servers[1].getLoad().activeClients = 2;
+    servers[2].getLoad().activeClients = 4;
+
+    LeastConnectionsStrategy strategy;
+    EXPECT_EQ(dispatch(strategy, servers), 1);
+    EXPECT_EQ(dispatch(strategy, servers), 1);
+
+    // Once tied, the servers are taken in turn rather than always the first one
+    EXPECT_EQ(dispatch(strategy, servers), 2);
+    EXPECT_EQ(dispatch(strategy, servers), 1);
+    EXPECT_EQ(dispatch(strategy, servers), 2);
+    EXPECT_EQ(dispatch(strategy, servers), 0);
+}
+
+TEST(BalancingStrategy, WeightedRoundRobinInterleavesByWeight) {
+    auto servers = makeServers(3);
+    WeightedRoundRobinStrategy strategy({4, 2});
+
+    std::vector<size_t> picks;
+    for (size_t i = 0; i < 7; i++) {
+        picks.emplace_back(dispatch(strategy, servers));
+    }
+
+    // The third server has no weight and weighs 1
+    EXPECT_EQ(picks, (std::vector<size_t>{0, 1, 0, 2, 0, 1, 0}));
+}
+
+TEST(BalancingStrategy, WeightedRoundRobinKeepsWeightsWithServerIds) {
+    auto servers = makeServers(3);
+    WeightedRoundRobinStrategy strategy({1, 3, 2});
+    dispatch(strategy, servers);
+
+    // Server 2 leaves the pool, server 3 moving to its position keeps its own weight
+    servers.erase(servers.begin() + 1);
+    std::vector<size_t> picks;
+    for (size_t i = 0; i < 6; i++) {
+        picks.emplace_back(dispatch(strategy, servers));
+    }
+    EXPECT_EQ(std::count(picks.begin(), picks.end(), 0), 2);
+    EXPECT_EQ(std::count(picks.begin(), picks.end(), 1), 4);
+}
+
+TEST(BalancingStrategy, LoadScoreWeighsBufferedBytesAndLatency) {
+    auto servers = makeServers(1);
+    ServerLoad &load = servers[0].getLoad();
+    load.activeClients = 3;
+    EXPECT_DOUBLE_EQ(servers[0].getLoadScore(), 3);
+
+    load.bufferedBytes = 2 * bufferedBytesPerClient;
+    EXPECT_DOUBLE_EQ(servers[0].getLoadScore(), 5);
+
+    load.latencyNanos = 1000 * 1000;
+    EXPECT_DOUBLE_EQ(servers[0].getLoadScore(), 10);
+}
+
+TEST(BalancingStrategy, PowerOfTwoChoicesPicksLessLoadedServer) {
+    // With two servers both are always compared, which makes the picks deterministic
+    auto servers = makeServers(2);
+    servers[0].getLoad().bufferedBytes = 20 * bufferedBytesPerClient;
+    servers[1].getLoad().activeClients = 5;
+    servers[1].getLoad().latencyNanos = 1000 * 1000;
+
+    PowerOfTwoChoicesStrategy strategy;
+    for (size_t i = 0; i < 5; i++) {
+        EXPECT_EQ(dispatch(strategy, servers), 1);
+    }
+    EXPECT_EQ(servers[1].getClientCount(), 10);
+}
+
+TEST(BalancingStrategy, FactoryParsesChoices) {
+    BalancingStrategyFactory factory;
+    auto create = [&factory](const std::string &input) {
+        return factory.createStrategy(std::make_unique<RuntimeTokens>(input));
+    };
+
+    EXPECT_NE(dynamic_cast<RoundRobinStrategy *>(create("--balancing ROUND_ROBIN").get()), nullptr);
+    EXPECT_NE(dynamic_cast<LeastConnectionsStrategy *>(create("--balancing LEAST_CONNECTIONS").get()), nullptr);
+    EXPECT_NE(dynamic_cast<PowerOfTwoChoicesStrategy *>(create("--balancing POWER_OF_TWO").get()), nullptr);
+    EXPECT_EQ(create("--balancing RANDOM"), nullptr);
+
+    auto weighted = create("--balancing WEIGHTED 3,1,2");
+    ASSERT_NE(dynamic_cast<WeightedRoundRobinStrategy *>(weighted.get()), nullptr);
+    EXPECT_EQ(dynamic_cast<WeightedRoundRobinStrategy *>(weighted.get())->getWeights(), (std::vector<int>{3, 1, 2}));
+
+    EXPECT_EQ(create("--balancing WEIGHTED"), nullptr);
+    EXPECT_EQ(create("--balancing WEIGHTED 3,0"), nullptr);
+    EXPECT_EQ(create("--balancing WEIGHTED 3;1"), nullptr);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
\ No newline at end of file
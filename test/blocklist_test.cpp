@@ -0,0 +1,131 @@
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <unistd.h>
+
+#include "listener/blocklist.hpp"
+
+using namespace echo;
+
+namespace {
+std::string filter(const BlocklistAutomaton &automaton, std::string message, std::optional<char> mask = std::nullopt) {
+    message.resize(automaton.filter(message.data(), message.size(), mask));
+    return message;
+}
+
+/* Filters "message" by searching for every word at every position, ASCII letters matching regardless of case */
+std::string filterNaively(const std::vector<std::string> &words, const std::string &message, std::optional<char> mask) {
+    auto lower = [](std::string text) {
+        for (char &c : text) {
+            c = std::tolower(static_cast<unsigned char>(c));
+        }
+        return text;
+    };
+    std::string lowerMessage = lower(message);
+    std::vector<bool> censored(message.size(), false);
+    for (const std::string &word : words) {
+        std::string lowerWord = lower(word);
+        for (size_t start = lowerMessage.find(lowerWord); start != std::string::npos && !word.empty();
+             start = lowerMessage.find(lowerWord, start + 1)) {
+            std::fill(censored.begin() + start, censored.begin() + start + word.size(), true);
+        }
+    }
+
+    std::string result;
+    for (size_t i = 0; i < message.size(); i++) {
+        if (!censored[i]) {
+            result.push_back(message[i]);
+        } else if (mask.has_value()) {
+            result.push_back(*mask);
+        }
+    }
+    return result;
+}
+
+/* Writes "contents" to a new temporary file, returning its path */
+std::string writeTemporaryFile(const std::string &contents) {
+    char path[] = "/tmp/blocklist_test_XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT_NE(fd, -1);
+    EXPECT_EQ(write(fd, contents.data(), contents.size()), static_cast<ssize_t>(contents.size()));
+    close(fd);
+    return path;
+}
+} // namespace
+
+TEST(Blocklist, RemovesOverlappingWords) {
+    BlocklistAutomaton automaton({"he", "she", "his", "hers"});
+    EXPECT_EQ(filter(automaton, "ushers"), "u");
+    EXPECT_EQ(filter(automaton, "ushers", '*'), "u*****");
+    EXPECT_EQ(filter(automaton, "this is shy, she said"), "t is shy,  said");
+    EXPECT_EQ(filter(automaton, "nothing to see"), "nothing to see");
+    EXPECT_EQ(filter(automaton, ""), "");
+}
+
+TEST(Blocklist, IgnoresCaseOfLetters) {
+    BlocklistAutomaton automaton({"Blocked", "word2"});
+    EXPECT_EQ(filter(automaton, "a BLOCKED Word2, blocked"), "a  , ");
+    EXPECT_EQ(filter(automaton, "word3 blocke", '#'), "word3 blocke");
+}
+
+TEST(Blocklist, MatchesNaiveSearch) {
+    // A four letter alphabet, so that the words overlap and share prefixes and suffixes all the time
+    std::mt19937 random(7);
+    auto randomText = [&random](size_t length) {
+        std::string text;
+        for (size_t i = 0; i < length; i++) {
+            text.push_back("abcdABCD"[random() % 8]);
+        }
+        return text;
+    };
+
+    for (int round = 0; round < 200; round++) {
+        std::vector<std::string> words;
+        for (size_t i = 0; i < 1 + random() % 40; i++) {
+            words.emplace_back(randomText(1 + random() % 6));
+        }
+        BlocklistAutomaton automaton(words);
+
+        std::string message = randomText(random() % 300);
+        ASSERT_EQ(filter(automaton, message), filterNaively(words, message, std::nullopt)) << message;
+        ASSERT_EQ(filter(automaton, message, '*'), filterNaively(words, message, '*')) << message;
+    }
+}
+
+TEST(Blocklist, LargeListsShareStates) {
+    std::vector<std::string> words;
+    for (int i = 0; i < 10000; i++) {
+        words.emplace_back("word" + std::to_string(i));
+    }
+    BlocklistAutomaton automaton(words);
+    // "word" and then a trie of the numbers
+    EXPECT_LT(automaton.getStateCount(), 12000);
+    EXPECT_EQ(filter(automaton, "a word9999 b word12345 c"), "a  b 5 c");
+    EXPECT_EQ(filter(automaton, "words and sword"), "words and sword");
+
+    EXPECT_THROW(BlocklistAutomaton({std::string(maxBlockedWordLength + 1, 'a')}), std::length_error);
+}
+
+TEST(Blocklist, ReadsWordsFromFile) {
+    std::string path = writeTemporaryFile("# comment\nfirst\r\n\nsecond word\n#third\n");
+    std::optional<std::vector<std::string>> words = readBlocklist(path);
+    ASSERT_TRUE(words.has_value());
+    EXPECT_EQ(*words, (std::vector<std::string>{"first", "second word"}));
+    std::remove(path.c_str());
+
+    path = writeTemporaryFile("# only a comment\n\n");
+    EXPECT_FALSE(readBlocklist(path).has_value());
+    std::remove(path.c_str());
+
+    path = writeTemporaryFile("fine\n" + std::string(maxBlockedWordLength + 1, 'a') + "\n");
+    EXPECT_FALSE(readBlocklist(path).has_value());
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(readBlocklist("/nonexistent/blocklist").has_value());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "socket/buffer_pool.hpp"
+#include <gtest/gtest.h>
+
+using namespace echo;
+
+TEST(BufferPool, BuffersAreRoundedUpToSizeClasses) {
+    BufferPool pool;
+    EXPECT_EQ(pool.acquire(1).getCapacity(), minPooledBufferSize);
+    EXPECT_EQ(pool.acquire(minPooledBufferSize).getCapacity(), minPooledBufferSize);
+    EXPECT_EQ(pool.acquire(minPooledBufferSize + 1).getCapacity(), 2 * minPooledBufferSize);
+    EXPECT_EQ(pool.acquire(5000).getCapacity(), 8192);
+    EXPECT_EQ(pool.acquire(maxPooledBufferSize).getCapacity(), maxPooledBufferSize);
+    EXPECT_EQ(pool.acquire(maxPooledBufferSize + 1).getCapacity(), maxPooledBufferSize + 1);
+}
+
+TEST(BufferPool, ReleasedBuffersAreReused) {
+    BufferPool pool;
+    char *first;
+    {
+        Buffer buffer = pool.acquire(4096);
+        first = buffer.getData();
+        buffer.getData()[4095] = 1;
+    }
+
+    Buffer reused = pool.acquire(3000);
+    EXPECT_EQ(reused.getData(), first);
+
+    // Other size classes don't share the free list
+    Buffer other = pool.acquire(8192);
+    EXPECT_NE(other.getData(), first);
+    EXPECT_EQ(pool.getStats().slabCount, 1);
+}
+
+TEST(BufferPool, StatsTrackOccupancy) {
+    BufferPool pool;
+    {
+        Buffer first = pool.acquire(16 * 1024);
+        Buffer second = pool.acquire(16 * 1024);
+        EXPECT_EQ(pool.getStats().usedBytes, 32 * 1024);
+        EXPECT_EQ(pool.getStats().reservedBytes, slabSize);
+
+        Buffer moved = std::move(first);
+        EXPECT_EQ(first.getData(), nullptr);
+        EXPECT_EQ(pool.getStats().usedBytes, 32 * 1024);
+    }
+
+    BufferPoolStats stats = pool.getStats();
+    EXPECT_EQ(stats.usedBytes, 0);
+    EXPECT_EQ(stats.usedHighWaterMark, 32 * 1024);
+    EXPECT_EQ(stats.reservedBytes, slabSize);
+
+    // Large buffers are mapped on their own and unmapped as soon as they are released
+    pool.acquire(maxPooledBufferSize + 1);
+    EXPECT_EQ(pool.getStats().reservedBytes, slabSize);
+    EXPECT_EQ(pool.getStats().usedHighWaterMark, maxPooledBufferSize + 1);
+}
+
+TEST(BufferPool, BuffersWithoutPoolUseTheHeap) {
+    Buffer buffer = BufferPool::allocate(nullptr, 100);
+    EXPECT_EQ(buffer.getCapacity(), 100);
+    buffer.getData()[99] = 1;
+    buffer.reset();
+    EXPECT_EQ(buffer.getData(), nullptr);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
\ No newline at end of file
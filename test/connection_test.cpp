@@ -0,0 +1,212 @@
+#include "listener/connection.hpp"
+#include "listener/connection_table.hpp"
+#include <cstring>
+#include <gtest/gtest.h>
+
+using namespace echo;
+
+TEST(Connection, QueueAndConsumeOutput) {
+    Connection connection(5);
+    EXPECT_FALSE(connection.hasPendingOutput());
+    EXPECT_TRUE(connection.getFrontOutput().empty());
+
+    connection.queueOutput("hello\n");
+    connection.queueOutput("world\n");
+    EXPECT_EQ(connection.getPendingBytes(), 12);
+    EXPECT_EQ(connection.getFrontOutput(), "hello\nworld\n");
+
+    connection.consumeOutput(3);
+    EXPECT_EQ(connection.getFrontOutput(), "lo\nworld\n");
+    connection.consumeOutput(9);
+    EXPECT_FALSE(connection.hasPendingOutput());
+}
+
+TEST(Connection, FrontInFlightIsNotModified) {
+    Connection connection(5);
+    connection.queueOutput("first");
+    connection.setFrontInFlight(true);
+    const char *inFlight = connection.getFrontOutput().data();
+
+    connection.queueOutput("second");
+    connection.queueOutput("third");
+    EXPECT_EQ(connection.getFrontOutput(), "first");
+    EXPECT_EQ(connection.getFrontOutput().data(), inFlight);
+    EXPECT_EQ(connection.getPendingBytes(), 16);
+
+    connection.consumeOutput(5);
+    connection.setFrontInFlight(false);
+    EXPECT_EQ(connection.getFrontOutput(), "secondthird");
+}
+
+TEST(Connection, WaterMarks) {
+    Connection connection(5);
+    connection.queueOutput(std::string(outputHighWaterMark + 1, 'a'));
+    EXPECT_TRUE(connection.isAboveHighWaterMark());
+    EXPECT_FALSE(connection.isBelowLowWaterMark());
+
+    connection.consumeOutput(outputHighWaterMark + 1 - outputLowWaterMark);
+    EXPECT_FALSE(connection.isAboveHighWaterMark());
+    EXPECT_TRUE(connection.isBelowLowWaterMark());
+
+    connection.discardOutput();
+    EXPECT_FALSE(connection.hasPendingOutput());
+}
+
+TEST(Connection, ViewsAreMergedAndMaterialized) {
+    Connection connection(5);
+    std::string storage = "hello\nworld\n";
+
+    connection.queueView(std::string_view(storage).substr(0, 6));
+    connection.queueView(std::string_view(storage).substr(6));
+    EXPECT_EQ(connection.getFrontOutput().data(), storage.data());
+    EXPECT_EQ(connection.getFrontOutput(), "hello\nworld\n");
+
+    connection.consumeOutput(2);
+    connection.materializeViews();
+    storage.assign(storage.size(), 'x');
+    EXPECT_EQ(connection.getFrontOutput(), "llo\nworld\n");
+    EXPECT_EQ(connection.getPendingBytes(), 10);
+}
+
+TEST(Connection, GatherSeparatesPinnedOutput) {
+    Connection connection(5);
+    connection.setZeroCopyEnabled(true);
+    connection.queueOutput("owned");
+
+    Buffer storage = BufferPool::allocate(nullptr, 4);
+    std::memcpy(storage.getData(), "view", 4);
+    connection.queueView(std::string_view(storage.getData(), 4));
+    connection.pinViews(std::move(storage));
+    connection.queueOutput("tail");
+
+    struct iovec iov[4];
+    bool zeroCopy;
+    ASSERT_EQ(connection.gatherOutput(iov, 4, zeroCopy), 1);
+    EXPECT_FALSE(zeroCopy);
+    connection.consumeOutput(5);
+
+    ASSERT_EQ(connection.gatherOutput(iov, 4, zeroCopy), 1);
+    EXPECT_TRUE(zeroCopy);
+    EXPECT_EQ(std::string_view(static_cast<char *>(iov[0].iov_base), iov[0].iov_len), "view");
+    connection.recordZeroCopySend();
+    connection.consumeOutput(4);
+    EXPECT_TRUE(connection.hasZeroCopyInFlight());
+
+    connection.completeZeroCopySends(0);
+    EXPECT_FALSE(connection.hasZeroCopyInFlight());
+    EXPECT_EQ(connection.getFrontOutput(), "tail");
+}
+
+TEST(Connection, DiscardKeepsBuffersOfZeroCopySendsInFlight) {
+    BufferPool pool;
+    Connection connection(5, FramingType::LINE, &pool);
+    connection.setZeroCopyEnabled(true);
+
+    Buffer storage = BufferPool::allocate(&pool, 4);
+    std::memcpy(storage.getData(), "view", 4);
+    connection.queueView(std::string_view(storage.getData(), 4));
+    connection.pinViews(std::move(storage));
+    connection.recordZeroCopySend();
+    connection.consumeOutput(2);
+
+    // The kernel may still transmit the pages, so the pool can't hand them out again yet
+    connection.discardOutput();
+    EXPECT_FALSE(connection.hasPendingOutput());
+    EXPECT_TRUE(connection.hasZeroCopyInFlight());
+    EXPECT_GT(pool.getStats().usedBytes, 0);
+
+    connection.completeZeroCopySends(0);
+    EXPECT_FALSE(connection.hasZeroCopyInFlight());
+    EXPECT_EQ(pool.getStats().usedBytes, 0);
+}
+
+TEST(Connection, DiscardKeepsFrontInFlight) {
+    BufferPool pool;
+    Connection connection(5, FramingType::LINE, &pool);
+    connection.queueOutput("first");
+    connection.setFrontInFlight(true);
+    connection.queueOutput("second");
+
+    // The kernel still reads the front block until the send completes
+    connection.discardOutput();
+    EXPECT_FALSE(connection.hasPendingOutput());
+    EXPECT_TRUE(connection.isFrontInFlight());
+    EXPECT_GT(pool.getStats().usedBytes, 0);
+
+    EXPECT_TRUE(connection.finishFrontSend());
+    EXPECT_FALSE(connection.isFrontInFlight());
+    EXPECT_EQ(pool.getStats().usedBytes, 0);
+    EXPECT_FALSE(connection.finishFrontSend());
+}
+
+TEST(Connection, ReservedFramesAreFramedInOrder) {
+    Connection connection(5);
+    std::string storage = "view\n";
+    connection.queueView(storage);
+
+    std::span<char> payload = connection.reserveFrame(10);
+    ASSERT_EQ(payload.size(), 10);
+    std::memcpy(payload.data(), "reserved", 8);
+    connection.commitFrame(8);
+    connection.queueOutput("after\n");
+    connection.materializeViews();
+
+    std::string output;
+    while (connection.hasPendingOutput()) {
+        std::string_view front = connection.getFrontOutput();
+        output += front;
+        connection.consumeOutput(front.size());
+    }
+    EXPECT_EQ(output, "view\nreserved\nafter\n");
+
+    Connection lengthFramed(6, FramingType::LENGTH);
+    payload = lengthFramed.reserveFrame(outputBlockSize);
+    std::memcpy(payload.data(), "abc", 3);
+    lengthFramed.commitFrame(3);
+    EXPECT_EQ(lengthFramed.getFrontOutput(), std::string_view("\0\0\0\3abc", 7));
+    EXPECT_EQ(lengthFramed.getPendingBytes(), 7);
+}
+
+TEST(ConnectionTable, InsertFindErase) {
+    ConnectionTable table;
+    EXPECT_EQ(table.find(3), nullptr);
+
+    Connection &first = table.insert(3, FramingType::LENGTH, nullptr);
+    EXPECT_EQ(first.getFd(), 3);
+    EXPECT_EQ(first.getDecoder().getType(), FramingType::LENGTH);
+
+    // Connections never move, even when the table grows by many pages
+    for (int fd = 4; fd < 5000; fd++) {
+        table.insert(fd, FramingType::LINE, nullptr);
+    }
+    EXPECT_EQ(table.find(3), &first);
+    EXPECT_EQ(table.size(), 4997);
+
+    table.erase(4000);
+    EXPECT_EQ(table.find(4000), nullptr);
+    EXPECT_EQ(table.size(), 4996);
+    EXPECT_EQ(table.find(-1), nullptr);
+    EXPECT_EQ(table.find(100000), nullptr);
+
+    size_t visited = 0;
+    table.forEach([&visited](Connection &) { visited++; });
+    EXPECT_EQ(visited, 4996);
+}
+
+TEST(ConnectionTable, HandlesOfRemovedConnectionsAreStale) {
+    ConnectionTable table;
+    table.insert(7, FramingType::LINE, nullptr);
+    ConnectionHandle handle = table.getHandle(7);
+    EXPECT_NE(table.find(handle), nullptr);
+
+    // A new connection reusing the fd is not reachable through the old handle
+    table.erase(7);
+    Connection &reused = table.insert(7, FramingType::LINE, nullptr);
+    EXPECT_EQ(table.find(handle), nullptr);
+    EXPECT_EQ(table.find(table.getHandle(7)), &reused);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
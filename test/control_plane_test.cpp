@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include "listener/server_load.hpp"
+
+using namespace echo;
+
+TEST(ControlRing, KeepsMessagesInOrder) {
+    auto ring = std::make_unique<ControlRing>();
+    std::string message;
+    EXPECT_FALSE(ring->pop(message));
+
+    ASSERT_TRUE(ring->push("--set-response-schema REVERSE"));
+    ASSERT_TRUE(ring->push(""));
+    ASSERT_TRUE(ring->push("--retire"));
+
+    ASSERT_TRUE(ring->pop(message));
+    EXPECT_EQ(message, "--set-response-schema REVERSE");
+    ASSERT_TRUE(ring->pop(message));
+    EXPECT_EQ(message, "");
+    ASSERT_TRUE(ring->pop(message));
+    EXPECT_EQ(message, "--retire");
+    EXPECT_FALSE(ring->pop(message));
+}
+
+TEST(ControlRing, WrapsAroundWhenConsumed) {
+    auto ring = std::make_unique<ControlRing>();
+    std::string large(controlRingCapacity / 3, 'a');
+    std::string message;
+
+    // Messages keep crossing the end of the ring, along with their lengths
+    for (size_t i = 0; i < 10; i++) {
+        large[0] = static_cast<char>('a' + i);
+        ASSERT_TRUE(ring->push(large));
+        ASSERT_TRUE(ring->push(std::to_string(i)));
+        ASSERT_TRUE(ring->pop(message));
+        EXPECT_EQ(message, large);
+        ASSERT_TRUE(ring->pop(message));
+        EXPECT_EQ(message, std::to_string(i));
+    }
+}
+
+TEST(ControlRing, RefusesMessagesWithoutRoom) {
+    auto ring = std::make_unique<ControlRing>();
+    std::string half(controlRingCapacity / 2, 'x');
+    ASSERT_TRUE(ring->push(half));
+    EXPECT_FALSE(ring->push(half));
+
+    std::string message;
+    ASSERT_TRUE(ring->pop(message));
+    EXPECT_TRUE(ring->push(half));
+}
+
+TEST(ServerStats, SumsSlotsIntoLatencyPercentiles) {
+    EXPECT_EQ(toLatencyBucket(500), 0);
+    EXPECT_EQ(toLatencyBucket(1000), 1);
+    EXPECT_EQ(toLatencyBucket(3000), 2);
+    EXPECT_EQ(toLatencyBucket(int64_t{1} << 40), latencyBucketCount - 1);
+
+    ServerLoadMonitor monitor;
+    ServerControlBlock &block = monitor.getControlBlock();
+    EXPECT_EQ(monitor.getStats().getLatencyPercentileMicros(50), 0);
+
+    block.reactorStats[0].messages = 3;
+    block.reactorStats[1].messages = 4;
+    block.reactorStats[1].bytesSent = 100;
+    block.reactorStats[0].latencyBuckets[toLatencyBucket(3000)] = 98;
+    block.reactorStats[1].latencyBuckets[toLatencyBucket(50000)] = 2;
+
+    ServerStats stats = monitor.getStats();
+    EXPECT_EQ(stats.messages, 7);
+    EXPECT_EQ(stats.bytesSent, 100);
+    EXPECT_DOUBLE_EQ(stats.getLatencyPercentileMicros(50), 4);
+    EXPECT_DOUBLE_EQ(stats.getLatencyPercentileMicros(99), 64);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
\ No newline at end of file
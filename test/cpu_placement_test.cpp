@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include "listener/cpu_placement.hpp"
+
+using namespace echo;
+
+namespace {
+/* Two nodes of four CPUs each, the second node's CPUs numbered after the first's */
+CpuTopology makeTwoNodeTopology() { return CpuTopology{{0, 1, 2, 3, 4, 5, 6, 7}, {0, 0, 0, 0, 1, 1, 1, 1}}; }
+} // namespace
+
+TEST(CpuPlacement, ParsesAndFormatsCpuLists) {
+    EXPECT_EQ(parseCpuList("0-3,8,10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(parseCpuList("5"), (std::vector<int>{5}));
+    EXPECT_TRUE(parseCpuList("").empty());
+    EXPECT_TRUE(parseCpuList("3-1").empty());
+    EXPECT_TRUE(parseCpuList("0;1").empty());
+
+    EXPECT_EQ(formatCpuList({0, 1, 2, 3, 8, 10, 11}), "0-3,8,10-11");
+    EXPECT_EQ(formatCpuList({4}), "4");
+}
+
+TEST(CpuPlacement, CoreSlotsAlternateBetweenNodes) {
+    CpuPlacement placement(PlacementPolicy::CORE, makeTwoNodeTopology(), 2);
+    ASSERT_EQ(placement.getSlotCount(), 4);
+
+    EXPECT_EQ(placement.getPlacement(0).cpus, (std::vector<int>{0, 1}));
+    EXPECT_EQ(placement.getPlacement(0).node, 0);
+    EXPECT_EQ(placement.getPlacement(1).cpus, (std::vector<int>{4, 5}));
+    EXPECT_EQ(placement.getPlacement(1).node, 1);
+    EXPECT_EQ(placement.getPlacement(2).cpus, (std::vector<int>{2, 3}));
+    EXPECT_EQ(placement.getPlacement(3).cpus, (std::vector<int>{6, 7}));
+
+    // Servers with more reactors than a node has CPUs get the whole node
+    CpuPlacement wide(PlacementPolicy::CORE, makeTwoNodeTopology(), 6);
+    ASSERT_EQ(wide.getSlotCount(), 2);
+    EXPECT_EQ(wide.getPlacement(1).cpus, (std::vector<int>{4, 5, 6, 7}));
+}
+
+TEST(CpuPlacement, NodeSlotsTakeWholeNodes) {
+    CpuPlacement placement(PlacementPolicy::NODE, makeTwoNodeTopology(), 1);
+    ASSERT_EQ(placement.getSlotCount(), 2);
+    EXPECT_EQ(placement.getPlacement(0).cpus, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(placement.getPlacement(1).node, 1);
+}
+
+TEST(CpuPlacement, PicksLeastUsedSlot) {
+    CpuPlacement placement(PlacementPolicy::CORE, makeTwoNodeTopology(), 2);
+    EXPECT_EQ(placement.pickSlot({}), 0);
+    EXPECT_EQ(placement.pickSlot({0, 1}), 2);
+
+    // Once every slot is taken the servers share them, and a freed slot is taken first
+    EXPECT_EQ(placement.pickSlot({0, 1, 2, 3}), 0);
+    EXPECT_EQ(placement.pickSlot({0, 0, 1, 1, 3, 3}), 2);
+}
+
+TEST(CpuPlacement, FindsSlotOfCpu) {
+    CpuPlacement placement(PlacementPolicy::CORE, makeTwoNodeTopology(), 2);
+    EXPECT_EQ(placement.findSlot(5), 1);
+    EXPECT_EQ(placement.findSlot(3), 2);
+    EXPECT_EQ(placement.findSlot(8), -1);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "socket/framing.hpp"
+#include <cstring>
+#include <gtest/gtest.h>
+
+using namespace echo;
+
+TEST(Framing, LineFramesSplitAndCoalesced) {
+    FrameDecoder decoder(FramingType::LINE);
+    std::string frame;
+
+    decoder.feed("hel", 3);
+    EXPECT_FALSE(decoder.nextFrame(frame));
+
+    decoder.feed("lo\nworld\n!", 10);
+    ASSERT_TRUE(decoder.nextFrame(frame));
+    EXPECT_EQ(frame, "hello");
+    ASSERT_TRUE(decoder.nextFrame(frame));
+    EXPECT_EQ(frame, "world");
+    EXPECT_FALSE(decoder.nextFrame(frame));
+    EXPECT_EQ(decoder.getBufferedBytes(), 1);
+}
+
+TEST(Framing, LengthFramesRoundTrip) {
+    std::string large(5000, 'x');
+    std::string stream;
+    Framing::appendFrame(stream, FramingType::LENGTH, "first");
+    Framing::appendFrame(stream, FramingType::LENGTH, "");
+    Framing::appendFrame(stream, FramingType::LENGTH, large);
+
+    FrameDecoder decoder(FramingType::LENGTH);
+    std::vector<std::string> frames;
+    std::string frame;
+    // Feed byte by byte to exercise every split position of the header and payload
+    for (char c : stream) {
+        decoder.feed(&c, 1);
+        while (decoder.nextFrame(frame)) {
+            frames.emplace_back(frame);
+        }
+    }
+
+    ASSERT_EQ(frames.size(), 3);
+    EXPECT_EQ(frames[0], "first");
+    EXPECT_EQ(frames[1], "");
+    EXPECT_EQ(frames[2], large);
+}
+
+TEST(Framing, OversizedFrame) {
+    FrameDecoder decoder(FramingType::LENGTH);
+    std::string stream;
+    stream.resize(lengthHeaderSize);
+    Framing::encodeHeader(FramingType::LENGTH, maxFrameSize + 1, stream.data());
+    decoder.feed(stream.data(), stream.size());
+
+    std::string frame;
+    EXPECT_FALSE(decoder.nextFrame(frame));
+    EXPECT_TRUE(decoder.isOversized());
+}
+
+TEST(Framing, InPlaceFramesAreResealed) {
+    FrameDecoder decoder(FramingType::LINE);
+    std::string stream = "hello\nworld\n";
+    std::memcpy(decoder.getFeedBuffer(stream.size()), stream.data(), stream.size());
+    decoder.commitFeed(stream.size());
+
+    FrameView frame;
+    ASSERT_TRUE(decoder.nextFrame(frame));
+    EXPECT_EQ(std::string_view(frame.payload, frame.payloadSize), "hello");
+    EXPECT_EQ(Framing::sealFrameInPlace(FramingType::LINE, frame.payload, 3), "hel\n");
+
+    std::string lengthStream;
+    Framing::appendFrame(lengthStream, FramingType::LENGTH, "payload");
+    FrameDecoder lengthDecoder(FramingType::LENGTH);
+    lengthDecoder.feed(lengthStream.data(), lengthStream.size());
+    ASSERT_TRUE(lengthDecoder.nextFrame(frame));
+
+    std::string expected;
+    Framing::appendFrame(expected, FramingType::LENGTH, "pay");
+    EXPECT_EQ(Framing::sealFrameInPlace(FramingType::LENGTH, frame.payload, 3), expected);
+}
+
+TEST(Framing, DetachedBufferKeepsFrames) {
+    FrameDecoder decoder(FramingType::LINE);
+    decoder.feed("first\nsec", 9);
+
+    FrameView frame;
+    ASSERT_TRUE(decoder.nextFrame(frame));
+    Buffer detached = decoder.detachBuffer();
+    decoder.feed("ond\n", 4);
+
+    EXPECT_EQ(std::string_view(frame.payload, frame.payloadSize), "first");
+    std::string second;
+    ASSERT_TRUE(decoder.nextFrame(second));
+    EXPECT_EQ(second, "second");
+}
+
+TEST(Framing, FramingTypeFromChoice) {
+    EXPECT_EQ(Framing::getFramingType("LINE"), FramingType::LINE);
+    EXPECT_EQ(Framing::getFramingType("LENGTH"), FramingType::LENGTH);
+    EXPECT_EQ(Framing::getFramingType("INVALID"), FramingType::UNKNOWN);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+#include <cerrno>
+#include <gtest/gtest.h>
+#include <linux/io_uring.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+#include "listener/server.hpp"
+#include "listener/server_channel.hpp"
+#include "listener/server_load.hpp"
+
+using namespace echo;
+
+/* Runs a server with a single reactor of the event loop type under test, handing it the server end of a socketpair */
+class ReactorTestFixture : public testing::TestWithParam<EventLoopType> {
+  protected:
+    void SetUp() override {
+        if (GetParam() == EventLoopType::IO_URING) {
+            struct io_uring_params params {};
+            int ringFd = syscall(__NR_io_uring_setup, 1, &params);
+            if (ringFd == -1 && errno == ENOSYS) {
+                GTEST_SKIP() << "io_uring is not supported by the kernel";
+            }
+            close(ringFd);
+        }
+
+        int pair[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair), 0);
+        clientFd = pair[1];
+
+        pipe = std::make_shared<InProcessPipe>();
+        channel = std::make_unique<ServerChannel>(pipe, sharedMemory.getControlBlock().commands);
+        server = std::make_unique<Server>(pipe, ServerConfig{GetParam(), 1});
+        server->shareControlBlock(sharedMemory.getControlBlock());
+        channel->queueClient(pair[0], FramingType::LINE);
+        ASSERT_TRUE(channel->flush());
+        running = std::jthread([this]() { server->start(); });
+    }
+
+    void TearDown() override {
+        if (server != nullptr) {
+            server->stop();
+        }
+        running = std::jthread();
+        if (clientFd != -1) {
+            close(clientFd);
+        }
+    }
+
+    /* Reads from the client until the server closes the connection, returning everything received */
+    std::string readUntilClosed() {
+        std::string received;
+        char buffer[64 * 1024];
+        ssize_t bytesRead;
+        while ((bytesRead = read(clientFd, buffer, sizeof(buffer))) > 0) {
+            received.append(buffer, bytesRead);
+        }
+        return received;
+    }
+
+    int clientFd = -1;
+    ServerLoadMonitor sharedMemory;
+    std::shared_ptr<InProcessPipe> pipe;
+    std::unique_ptr<ServerChannel> channel;
+    std::unique_ptr<Server> server;
+    std::jthread running;
+};
+
+TEST_P(ReactorTestFixture, PipelinedFramesLargerThanSocketBufferTest) {
+    int sendBufferSize = 0;
+    socklen_t optionSize = sizeof(sendBufferSize);
+    ASSERT_EQ(getsockopt(clientFd, SOL_SOCKET, SO_SNDBUF, &sendBufferSize, &optionSize), 0);
+
+    // Every frame is larger than the socket buffer and tells the frames apart, so responses cut short, merged or
+    // reordered are all caught
+    std::string frames;
+    for (char fill = 'a'; fill < 'a' + 6; fill++) {
+        frames += std::string(2 * sendBufferSize + fill, fill);
+        frames += '\n';
+    }
+
+    // Sent all at once and half-closed while responses are read back, so neither side waits for the other to read
+    std::thread sending([this, &frames]() {
+        for (size_t sent = 0; sent < frames.size();) {
+            ssize_t bytesSent = send(clientFd, frames.data() + sent, frames.size() - sent, MSG_NOSIGNAL);
+            ASSERT_GT(bytesSent, 0);
+            sent += bytesSent;
+        }
+        shutdown(clientFd, SHUT_WR);
+    });
+    std::string received = readUntilClosed();
+    sending.join();
+
+    ASSERT_EQ(received.size(), frames.size());
+    EXPECT_TRUE(received == frames);
+}
+
+std::string eventLoopName(const testing::TestParamInfo<EventLoopType> &info) {
+    switch (info.param) {
+    case EventLoopType::POLL:
+        return "POLL";
+    case EventLoopType::EPOLL:
+        return "EPOLL";
+    default:
+        return "IO_URING";
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(EventLoops, ReactorTestFixture,
+                         testing::Values(EventLoopType::POLL, EventLoopType::EPOLL, EventLoopType::IO_URING),
+                         eventLoopName);
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
\ No newline at end of file
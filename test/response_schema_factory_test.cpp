@@ -1,6 +1,8 @@
 #include "CLI/tokens.hpp"
 #include "listener/response_schema_factory.hpp"
+#include <cstdio>
 #include <gtest/gtest.h>
+#include <unistd.h>
 
 using namespace echo;
 
@@ -43,6 +45,198 @@ TEST_F(ResponseSchemaFactoryTestFixture, CreateSchemaInvalid) {
     EXPECT_EQ(schema, nullptr);
 }
 
+TEST(ResponseSchemaTest, WritesResponsesInPlaceAndOutOfPlace) {
+    std::vector<std::unique_ptr<IResponseSchema>> schemas;
+    schemas.emplace_back(std::make_unique<EquivalentResponseSchema>());
+    schemas.emplace_back(std::make_unique<ReverseResponseSchema>());
+    schemas.emplace_back(std::make_unique<CensoredResponseSchema>("ae", '*'));
+    schemas.emplace_back(std::make_unique<CensoredResponseSchema>("ae"));
+    schemas.emplace_back(std::make_unique<PalindromeResponseSchema>());
+    schemas.emplace_back(std::make_unique<BlocklistResponseSchema>(BlocklistAutomaton({"racecar"})));
+
+    for (const std::string message : {"A man, a plan, a canal: Panama", "Never odd or even, racecar", "abc"}) {
+        for (const std::unique_ptr<IResponseSchema> &schema : schemas) {
+            size_t maxResponseSize = schema->getMaxResponseSize(message.size());
+            std::string outOfPlace(maxResponseSize, '\0');
+            outOfPlace.resize(schema->writeResponse(message, outOfPlace));
+
+            std::string inPlace = message;
+            inPlace.resize(std::max(maxResponseSize, message.size()));
+            inPlace.resize(schema->writeResponse(std::span<const char>(inPlace.data(), message.size()), inPlace));
+            EXPECT_EQ(inPlace, outOfPlace) << message;
+        }
+    }
+
+    std::string message = "abc";
+    schemas[4]->generateResponse(message);
+    EXPECT_EQ(message, "This message is not a palindrome :(");
+    message = "Taco cat";
+    schemas[4]->generateResponse(message);
+    EXPECT_EQ(message, "This message is a palindrome :)");
+}
+
+TEST(SchemaDescriptorTest, CompileParsesArgumentsOnce) {
+    ResponseSchemaFactory factory;
+    auto compile = [&factory](const std::string &input) {
+        return factory.compileDescriptor(std::make_unique<RuntimeTokens>(input));
+    };
+
+    auto censored = compile("--set-response-schema CENSORED CHAR=s");
+    ASSERT_TRUE(censored.has_value());
+    EXPECT_EQ(censored->type, SchemaType::CENSORED);
+    EXPECT_EQ(censored->argument, "s");
+
+    auto reverse = compile("--set-response-schema REVERSE");
+    ASSERT_TRUE(reverse.has_value());
+    EXPECT_EQ(reverse->type, SchemaType::REVERSE);
+
+    EXPECT_FALSE(compile("--set-response-schema CENSORED").has_value());
+    EXPECT_FALSE(compile("--set-response-schema CENSORED CHAR=").has_value());
+    EXPECT_FALSE(compile("--set-response-schema INVALID??").has_value());
+}
+
+TEST(SchemaDescriptorTest, CompilesCensoredCharacterSets) {
+    ResponseSchemaFactory factory;
+    auto compile = [&factory](const std::string &input) {
+        return factory.compileDescriptor(std::make_unique<RuntimeTokens>(input));
+    };
+
+    auto ranges = compile("--set-response-schema CENSORED CHARS=x-z0-2a-");
+    ASSERT_TRUE(ranges.has_value());
+    EXPECT_EQ(ranges->argument, "-012axyz");
+
+    auto masked = compile("--set-response-schema CENSORED CHARS=aeiou MASK=*");
+    ASSERT_TRUE(masked.has_value());
+    EXPECT_EQ(masked->argument, std::string("aeiou\0*", 7));
+
+    std::string message = "censored vowels";
+    factory.createSchema(*masked)->generateResponse(message);
+    EXPECT_EQ(message, "c*ns*r*d v*w*ls");
+
+    message = "censored vowels";
+    factory.createSchema(*compile("--set-response-schema CENSORED CHARS=aeiou"))->generateResponse(message);
+    EXPECT_EQ(message, "cnsrd vwls");
+
+    EXPECT_FALSE(compile("--set-response-schema CENSORED CHARS=").has_value());
+    EXPECT_FALSE(compile("--set-response-schema CENSORED CHARS=z-a").has_value());
+    EXPECT_FALSE(compile("--set-response-schema CENSORED CHARS=abc MASK=").has_value());
+    EXPECT_FALSE(compile("--set-response-schema CENSORED CHARS=abc MASK=**").has_value());
+    EXPECT_FALSE(compile("--set-response-schema CENSORED CHARS=abc COLOR=red").has_value());
+}
+
+TEST(SchemaDescriptorTest, CompilesBlocklistFromFile) {
+    char path[] = "/tmp/blocklist_factory_test_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(fd, -1);
+    std::string words = "darn\nheck\n";
+    ASSERT_EQ(write(fd, words.data(), words.size()), static_cast<ssize_t>(words.size()));
+    close(fd);
+
+    ResponseSchemaFactory factory;
+    auto compile = [&factory](const std::string &input) {
+        return factory.compileDescriptor(std::make_unique<RuntimeTokens>(input));
+    };
+
+    auto masked = compile("--set-response-schema BLOCKLIST FILE=" + std::string(path) + " MASK=*");
+    ASSERT_TRUE(masked.has_value());
+    EXPECT_EQ(masked->type, SchemaType::BLOCKLIST);
+    std::string message = "Heck, darn it";
+    factory.createSchema(*masked)->generateResponse(message);
+    EXPECT_EQ(message, "****, **** it");
+
+    // Also through encoding, as the descriptor reaches the servers
+    auto compiled = compile("--set-response-schema BLOCKLIST FILE=" + std::string(path));
+    ASSERT_TRUE(compiled.has_value());
+    auto removed = SchemaDescriptor::decode(compiled->encode());
+    ASSERT_TRUE(removed.has_value());
+    message = "Heck, darn it";
+    factory.createSchema(*removed)->generateResponse(message);
+    EXPECT_EQ(message, ",  it");
+
+    EXPECT_FALSE(compile("--set-response-schema BLOCKLIST").has_value());
+    EXPECT_FALSE(compile("--set-response-schema BLOCKLIST FILE=/nonexistent/blocklist").has_value());
+    EXPECT_FALSE(compile("--set-response-schema BLOCKLIST FILE=" + std::string(path) + " MASK=").has_value());
+
+    // A blocklist gone by the time a server builds the schema leaves the server with its current one
+    std::remove(path);
+    EXPECT_EQ(factory.createSchema(*masked), nullptr);
+}
+
+TEST(SchemaDescriptorTest, CompilesPipelines) {
+    ResponseSchemaFactory factory;
+    auto create = [&factory](const std::string &input) {
+        std::optional<SchemaDescriptor> descriptor =
+            factory.compileDescriptor(std::make_unique<RuntimeTokens>(input));
+        // Through encoding, as the descriptor reaches the servers
+        return descriptor.has_value() ? factory.createSchema(*SchemaDescriptor::decode(descriptor->encode())) : nullptr;
+    };
+    auto respond = [](const AbstractResponseSchema &schema, std::string message) {
+        schema->generateResponse(message);
+        return message;
+    };
+
+    // Byte-wise stages are fused into one, whichever kernel the composition runs
+    auto censoredReverse = create("--set-response-schema PIPELINE CENSORED:CHAR=x,REVERSE");
+    ASSERT_NE(dynamic_cast<FusedResponseSchema *>(censoredReverse.get()), nullptr);
+    EXPECT_EQ(respond(censoredReverse, "xylophone box"), "ob enohpoly");
+
+    auto masked = create("--set-response-schema PIPELINE REVERSE,CENSORED:CHARS=a-c:MASK=*,EQUIVALENT,CENSORED:CHAR=*");
+    ASSERT_NE(masked, nullptr);
+    EXPECT_EQ(respond(masked, "abcdefabc"), "fed");
+
+    auto twoMasks = create("--set-response-schema PIPELINE CENSORED:CHAR=a:MASK=*,CENSORED:CHAR=b:MASK=#,REVERSE");
+    ASSERT_NE(twoMasks, nullptr);
+    EXPECT_EQ(respond(twoMasks, "abcab"), "#*c#*");
+
+    auto reversedTwice = create("--set-response-schema PIPELINE REVERSE,REVERSE,CENSORED:CHARS=0-9");
+    EXPECT_EQ(respond(reversedTwice, "r2d2 c3po"), "rd cpo");
+
+    // Stages that aren't byte-wise run on their own, on the response of the fused stages before them
+    auto palindrome = create("--set-response-schema PIPELINE CENSORED:CHAR=x,REVERSE,PALINDROME");
+    ASSERT_NE(dynamic_cast<PipelineResponseSchema *>(palindrome.get()), nullptr);
+    EXPECT_EQ(respond(palindrome, "xabax?"), "This message is a palindrome :)");
+    EXPECT_EQ(respond(palindrome, "abx"), "This message is not a palindrome :(");
+
+    auto censoredVerdict = create("--set-response-schema PIPELINE PALINDROME,CENSORED:CHARS=a-z");
+    EXPECT_EQ(respond(censoredVerdict, "abc"), "T      :(");
+
+    auto compile = [&factory](const std::string &input) {
+        return factory.compileDescriptor(std::make_unique<RuntimeTokens>(input));
+    };
+    EXPECT_FALSE(compile("--set-response-schema PIPELINE").has_value());
+    EXPECT_FALSE(compile("--set-response-schema PIPELINE REVERSE,").has_value());
+    EXPECT_FALSE(compile("--set-response-schema PIPELINE REVERSE,,REVERSE").has_value());
+    EXPECT_FALSE(compile("--set-response-schema PIPELINE CENSORED,REVERSE").has_value());
+    EXPECT_FALSE(compile("--set-response-schema PIPELINE CENSORED:CHAR=a:MASK=*:MASK=#").has_value());
+    EXPECT_FALSE(compile("--set-response-schema PIPELINE PIPELINE:REVERSE").has_value());
+    EXPECT_FALSE(compile("--set-response-schema PIPELINE INVALID??").has_value());
+    std::string tooLong = "--set-response-schema PIPELINE REVERSE";
+    for (int stage = 0; stage < 16; stage++) {
+        tooLong += ",REVERSE";
+    }
+    EXPECT_FALSE(compile(tooLong).has_value());
+}
+
+TEST(SchemaDescriptorTest, EncodingRoundTrips) {
+    SchemaDescriptor descriptor{42, SchemaType::CENSORED, "x"};
+    auto decoded = SchemaDescriptor::decode(descriptor.encode());
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(decoded->version, 42);
+    EXPECT_EQ(decoded->type, SchemaType::CENSORED);
+    EXPECT_EQ(decoded->argument, "x");
+
+    auto schema = ResponseSchemaFactory().createSchema(*decoded);
+    std::string message = "xoxo";
+    schema->generateResponse(message);
+    EXPECT_EQ(message, "oo");
+
+    // Truncated descriptors and unknown schema types are refused
+    EXPECT_FALSE(SchemaDescriptor::decode(descriptor.encode().substr(0, 4)).has_value());
+    std::string unknownType = descriptor.encode();
+    unknownType[sizeof(uint64_t)] = 100;
+    EXPECT_FALSE(SchemaDescriptor::decode(unknownType).has_value());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <string>
+
+#include "listener/response_schema.hpp"
+#include "listener/schema_kernels.hpp"
+
+using namespace echo;
+
+namespace {
+/* Longest message compared byte for byte, spanning many vectors of every kernel plus every possible remainder */
+const size_t maxLength = 4096 + 100;
+
+/* Every level the CPU can run */
+std::vector<SimdLevel> getSupportedLevels() {
+    std::vector<SimdLevel> levels;
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSSE3, SimdLevel::AVX2}) {
+        if (level <= detectSimdLevel()) {
+            levels.emplace_back(level);
+        }
+    }
+    return levels;
+}
+
+std::string makeMessage(size_t length) {
+    std::string message(length, '\0');
+    for (size_t i = 0; i < length; i++) {
+        message[i] = static_cast<char>(i * 7 + i / 256);
+    }
+    return message;
+}
+} // namespace
+
+TEST(SchemaKernels, ReverseKernelsMatchScalarReverse) {
+    for (SimdLevel level : getSupportedLevels()) {
+        ReverseKernel reverse = getReverseKernel(level);
+        for (size_t length = 0; length <= maxLength; length++) {
+            // Starting one byte into the buffer, so that the vector loads are unaligned
+            std::string buffer = ' ' + makeMessage(length) + ' ';
+            std::string expected = buffer;
+            std::reverse(expected.begin() + 1, expected.end() - 1);
+
+            reverse(buffer.data() + 1, length);
+            ASSERT_EQ(buffer, expected) << getSimdLevelName(level) << " kernel, length " << length;
+        }
+    }
+}
+
+TEST(SchemaKernels, CensorAndMaskKernelsMatchScalarLookup) {
+    // A single character, a range, and bytes on both sides of 0x80 sharing low nibbles
+    for (std::string chars : {std::string("e"), std::string("abcdefghijklmnopqrstuvwxyz"),
+                              std::string("\x01\x11\x81\xf1 \x7f\x80\xff")}) {
+        CensorTable table(chars);
+        for (SimdLevel level : getSupportedLevels()) {
+            CensorKernel censor = getCensorKernel(level);
+            MaskKernel mask = getMaskKernel(level);
+            for (size_t length = 0; length <= maxLength; length++) {
+                std::string message = makeMessage(length);
+                std::string expectedCensored;
+                std::string expectedMasked;
+                for (char c : message) {
+                    bool censored = chars.find(c) != std::string::npos;
+                    if (!censored) {
+                        expectedCensored.push_back(c);
+                    }
+                    expectedMasked.push_back(censored ? '*' : c);
+                }
+
+                std::string buffer = ' ' + message + ' ';
+                size_t kept = censor(table, buffer.data() + 1, length);
+                ASSERT_EQ(buffer.substr(1, kept), expectedCensored)
+                    << getSimdLevelName(level) << " censor kernel, length " << length;
+                ASSERT_EQ(buffer.back(), ' ');
+
+                buffer = ' ' + message + ' ';
+                mask(table, '*', buffer.data() + 1, length);
+                ASSERT_EQ(buffer, ' ' + expectedMasked + ' ')
+                    << getSimdLevelName(level) << " mask kernel, length " << length;
+            }
+        }
+    }
+}
+
+TEST(SchemaKernels, FusedKernelsMatchSequentialStages) {
+    // Shorter than the other kernels' messages as there are eight kernels per level, still several vectors and every
+    // remainder long
+    const size_t fusedMaxLength = 320;
+    FusedCensorTables tables{CensorTable("aeiou\x81"), CensorTable("xyz\xf1"), '*'};
+    for (SimdLevel level : getSupportedLevels()) {
+        for (int combination = 0; combination < 8; combination++) {
+            bool removes = combination & 4;
+            bool masks = combination & 2;
+            bool reverses = combination & 1;
+            FusedKernel fused = getFusedKernel(level, removes, masks, reverses);
+            for (size_t length = 0; length <= fusedMaxLength; length++) {
+                std::string message = makeMessage(length);
+                std::string expected;
+                for (char c : message) {
+                    if (!removes || !tables.removed.contains(c)) {
+                        expected.push_back(masks && tables.masked.contains(c) ? '*' : c);
+                    }
+                }
+                if (reverses) {
+                    std::reverse(expected.begin(), expected.end());
+                }
+
+                std::string buffer = ' ' + message + ' ';
+                size_t written = fused(tables, buffer.data() + 1, length, buffer.data() + 1);
+                ASSERT_EQ(buffer.substr(1, written), expected)
+                    << getSimdLevelName(level) << " fused kernel " << combination << " in place, length " << length;
+                ASSERT_EQ(buffer.back(), ' ');
+
+                std::string response(length + 2, ' ');
+                written = fused(tables, message.data(), length, response.data() + 1);
+                ASSERT_EQ(response.substr(1, written), expected)
+                    << getSimdLevelName(level) << " fused kernel " << combination << ", length " << length;
+                ASSERT_EQ(response.front(), ' ');
+                ASSERT_EQ(response.back(), ' ');
+            }
+        }
+    }
+}
+
+TEST(SchemaKernels, ReverseSchemaUsesDetectedKernel) {
+    ReverseResponseSchema schema;
+    std::string message = makeMessage(1000);
+    std::string expected(message.rbegin(), message.rend());
+
+    schema.generateResponse(message);
+    EXPECT_EQ(message, expected);
+
+    EXPECT_EQ(schema.writeResponse(message, message), expected.size());
+    EXPECT_EQ(message, std::string(expected.rbegin(), expected.rend()));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
\ No newline at end of file
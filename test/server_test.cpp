@@ -1,6 +1,9 @@
 #include <fcntl.h>
 #include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <thread>
 
+#include "listener/schema_descriptor.hpp"
 #include "listener/server.hpp"
 #include "socket/socket_factory.hpp"
 
@@ -52,6 +55,140 @@ TEST_F(ServerTestFixture, ServerListenersTest) {
     EXPECT_NE(unixSocketAdded, nullptr);
 }
 
+TEST(ServerReactorTest, ReactorsShareResponseSchemaTest) {
+    std::string pipeName = "/tmp/testpipe_reactors";
+    mkfifo(pipeName.c_str(), O_RDWR);
+    chmod(pipeName.c_str(), S_IRUSR | S_IWUSR);
+    Server server(pipeName, ServerConfig{EventLoopType::EPOLL, 4});
+
+    ASSERT_EQ(server.getReactorCount(), 4);
+    ASSERT_EQ(server.getClientCount(), 0);
+
+    uint64_t version = server.getResponseSchemaVersion();
+    auto previousSchema = server.getResponseSchema();
+    server.setResponseSchema(std::make_unique<ReverseResponseSchema>());
+    ASSERT_NE(server.getResponseSchemaVersion(), version);
+
+    // A reactor still holding the previous schema can keep using it
+    std::string message = "test";
+    previousSchema->generateResponse(message);
+    ASSERT_EQ(message, "test");
+    server.getResponseSchema()->generateResponse(message);
+    ASSERT_EQ(message, "tset");
+}
+
+TEST(ServerChannelTest, SocketpairPassesClientSocketsTest) {
+    int channelFds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, channelFds), 0);
+    ServerLoadMonitor sharedMemory;
+    ServerChannel channel(channelFds[0], sharedMemory.getControlBlock().commands);
+    Server server(channelFds[1]);
+    server.shareControlBlock(sharedMemory.getControlBlock());
+
+    // More clients than fit into a single packet
+    const size_t clientCount = maxFdsPerPacket + 6;
+    std::vector<int> handedOver;
+    std::vector<int> peers;
+    for (size_t i = 0; i < clientCount; i++) {
+        int pair[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+        channel.queueClient(pair[0], FramingType::LINE);
+        handedOver.emplace_back(pair[0]);
+        peers.emplace_back(pair[1]);
+    }
+    channel.queueControlMessage(ControlMessageType::SET_RESPONSE_SCHEMA,
+                                SchemaDescriptor{1, SchemaType::REVERSE, ""}.encode());
+    ASSERT_TRUE(channel.flush());
+    ASSERT_FALSE(channel.hasQueuedData());
+
+    // The dispatcher's copies are closed as soon as they are sent
+    for (int fd : handedOver) {
+        EXPECT_EQ(fcntl(fd, F_GETFD), -1);
+    }
+
+    server.acceptPipeData();
+    EXPECT_EQ(server.getClientCount(), clientCount);
+    EXPECT_EQ(sharedMemory.getClientCount(), clientCount);
+
+    std::string message = "abc";
+    server.getResponseSchema()->generateResponse(message);
+    EXPECT_EQ(message, "cba");
+    EXPECT_EQ(server.getSchemaDescriptorVersion(), 1);
+    EXPECT_EQ(sharedMemory.getControlBlock().schemaVersion, 1);
+
+    for (int fd : peers) {
+        close(fd);
+    }
+}
+
+TEST(ServerChannelTest, InProcessPipeHandsOverClientsInOrderTest) {
+    auto pipe = std::make_shared<InProcessPipe>();
+    ServerLoadMonitor sharedMemory;
+    ServerChannel channel(pipe, sharedMemory.getControlBlock().commands);
+    Server server(pipe);
+    server.shareControlBlock(sharedMemory.getControlBlock());
+
+    // More clients than fit into a single chunk, with a command in between
+    const size_t clientCount = maxRingChunkSize / 4;
+    std::vector<int> peers;
+    for (size_t i = 0; i < clientCount; i++) {
+        int pair[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+        channel.queueClient(pair[0], FramingType::LINE);
+        peers.emplace_back(pair[1]);
+        if (i == clientCount / 2) {
+            channel.queueControlMessage(ControlMessageType::SET_RESPONSE_SCHEMA,
+                                        SchemaDescriptor{3, SchemaType::REVERSE, ""}.encode());
+        }
+    }
+    ASSERT_TRUE(channel.flush());
+
+    // The server owns the sockets now, which the dispatcher must not have closed
+    server.acceptPipeData();
+    EXPECT_EQ(server.getClientCount(), clientCount);
+    EXPECT_EQ(sharedMemory.getClientCount(), clientCount);
+    EXPECT_EQ(server.getSchemaDescriptorVersion(), 3);
+
+    for (int fd : peers) {
+        close(fd);
+    }
+}
+
+TEST(ServerListenerTest, RedirectedClientReachesServerListenerTest) {
+    std::string pipeName = "/tmp/testpipe_listener";
+    mkfifo(pipeName.c_str(), O_RDWR);
+    chmod(pipeName.c_str(), S_IRUSR | S_IWUSR);
+    Server server(pipeName);
+    server.acceptClientsFrom(std::make_unique<UnixSocket>("/tmp/test_server_socket"));
+    ASSERT_EQ(server.getListenerPool().size(), 1);
+    int serverListenerFd = server.getListenerPool()[0]->getsocketFd();
+
+    // Stands in for a dispatcher in redirect mode
+    UnixSocket dispatcherListener("/tmp/test_dispatcher_socket");
+    dispatcherListener.bind();
+    ASSERT_EQ(listen(dispatcherListener.getsocketFd(), 1), 0);
+
+    AbstractSocket client;
+    std::thread connecting([&client]() {
+        const char *argv[] = {"./echo_client", "/tmp/test_dispatcher_socket", "LENGTH", "REDIRECT"};
+        client = SocketFactory::createClientSocket(4, const_cast<char **>(argv));
+    });
+    int redirectedFd = accept(dispatcherListener.getsocketFd(), nullptr, nullptr);
+    ASSERT_NE(redirectedFd, -1);
+    std::string redirect = redirectPrefix + "/tmp/test_server_socket\n";
+    send(redirectedFd, redirect.data(), redirect.size(), MSG_NOSIGNAL);
+    close(redirectedFd);
+    connecting.join();
+
+    ASSERT_NE(dynamic_cast<UnixSocket *>(client.get()), nullptr);
+    EXPECT_EQ(client->getFraming(), FramingType::LENGTH);
+    EXPECT_FALSE(server.acceptListenerClients(dispatcherListener.getsocketFd()));
+    EXPECT_TRUE(server.acceptListenerClients(serverListenerFd));
+    EXPECT_EQ(server.getClientCount(), 1);
+
+    unlink("/tmp/test_dispatcher_socket");
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -28,6 +28,21 @@ TEST(Tokens, RuntimeTokensTokenizeAndDetokenize) {
     EXPECT_EQ(tokensRuntime.detokenize(delimiter), inputRuntime);
 }
 
+TEST(Tokens, StartupTokensSplitByOption) {
+    std::vector<std::string> args = {"./executable", "--first", "choice", "argument", "--second", "choice2"};
+    auto split = StartupTokens::splitByOption(args);
+
+    ASSERT_EQ(split.size(), 2);
+    EXPECT_EQ(split[0]->getOption(), "--first");
+    EXPECT_EQ(split[0]->getChoice(), "choice");
+    EXPECT_EQ(split[0]->getChoiceArgument(), "argument");
+    EXPECT_EQ(split[1]->getOption(), "--second");
+    EXPECT_EQ(split[1]->getChoice(), "choice2");
+    EXPECT_EQ(split[1]->detokenize(' '), "./executable --second choice2");
+
+    EXPECT_TRUE(StartupTokens::splitByOption({"./executable"}).empty());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();